@@ -0,0 +1,114 @@
+﻿#include "AirHockeyEnv.h"
+
+// speed of the puck at kick-off, in points per second
+#define KICK_OFF_SPEED 300.0f
+
+AirHockeyEnv::AirHockeyEnv(int envCount, float tableWidth, float tableHeight, float malletRadius, float puckRadius,
+    int ticksPerStep, int winningScore, unsigned int maxEpisodeTicks, unsigned int seed)
+{
+    _tableWidth = tableWidth;
+    _tableHeight = tableHeight;
+    _malletRadius = malletRadius;
+    _puckRadius = puckRadius;
+    _ticksPerStep = ticksPerStep > 0 ? ticksPerStep : 1;
+    _winningScore = winningScore;
+    _maxEpisodeTicks = maxEpisodeTicks;
+    _tables.resize(envCount);
+    _seeds.resize(envCount);
+    for (auto i = 0; i < envCount; ++i)
+    {
+        // every table gets its own non-zero xorshift seed
+        _seeds[i] = (seed + 1) * 2654435761u + i * 40503u;
+        _seeds[i] = _seeds[i] ? _seeds[i] : 1;
+        resetTable(i);
+    }
+}
+
+void AirHockeyEnv::reset(const unsigned char* resetMask, float* observations)
+{
+    const auto envCount = getEnvCount();
+    for (auto i = 0; i < envCount; ++i)
+    {
+        if (!resetMask || resetMask[i])
+        {
+            resetTable(i);
+        }
+        writeObservation(i, observations + i * OBSERVATION_SIZE);
+    }
+}
+
+void AirHockeyEnv::step(const float* actions, float* observations, float* rewards, unsigned char* dones)
+{
+    stepRange(0, getEnvCount(), actions, observations, rewards, dones);
+}
+
+void AirHockeyEnv::stepRange(int begin, int end, const float* actions, float* observations, float* rewards, unsigned char* dones)
+{
+    for (auto i = begin; i < end; ++i)
+    {
+        auto& table = _tables[i];
+        const auto action = actions + i * ACTION_SIZE;
+        for (auto player = 0; player < AirHockeySim::PLAYER_COUNT; ++player)
+        {
+            table.moveMallet(player, action[2 * player], action[2 * player + 1]);
+        }
+
+        const int scores[AirHockeySim::PLAYER_COUNT] = { table.scores[0], table.scores[1] };
+        for (auto tick = 0; tick < _ticksPerStep; ++tick)
+        {
+            table.step();
+        }
+
+        // zero-sum reward: what a player scored minus what the other one scored during this step
+        const auto scored1 = static_cast<float>(table.scores[0] - scores[0]);
+        const auto scored2 = static_cast<float>(table.scores[1] - scores[1]);
+        rewards[i * AirHockeySim::PLAYER_COUNT] = scored1 - scored2;
+        rewards[i * AirHockeySim::PLAYER_COUNT + 1] = scored2 - scored1;
+
+        const auto won = table.scores[0] >= _winningScore || table.scores[1] >= _winningScore;
+        // init() in resetTable() starts the tick count of the table from 0
+        const auto timeout = _maxEpisodeTicks > 0 && table.tick >= _maxEpisodeTicks;
+        dones[i] = won || timeout ? 1 : 0;
+
+        writeObservation(i, observations + i * OBSERVATION_SIZE);
+    }
+}
+
+void AirHockeyEnv::resetTable(int index)
+{
+    auto& table = _tables[index];
+    table.init(_tableWidth, _tableHeight, _malletRadius, _puckRadius);
+    // the first action of the episode moves the mallets over one step like every other one, not over one tick,
+    // unsigned so tick - malletMoveTicks is _ticksPerStep at tick 0
+    for (auto player = 0; player < AirHockeySim::PLAYER_COUNT; ++player)
+    {
+        table.malletMoveTicks[player] = table.tick - static_cast<unsigned int>(_ticksPerStep);
+    }
+
+    // xorshift32, kick-off toward a random court with a random angle
+    auto& seed = _seeds[index];
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    table.puck.vy = (seed & 1) ? KICK_OFF_SPEED : -KICK_OFF_SPEED;
+    table.puck.vx = KICK_OFF_SPEED * (static_cast<float>((seed >> 1) % 1001) / 1000.0f - 0.5f);
+}
+
+void AirHockeyEnv::writeObservation(int index, float* observation) const
+{
+    const auto& table = _tables[index];
+    observation[OBSERVATION_PUCK] = table.puck.x;
+    observation[OBSERVATION_PUCK + 1] = table.puck.y;
+    observation[OBSERVATION_PUCK + 2] = table.puck.vx;
+    observation[OBSERVATION_PUCK + 3] = table.puck.vy;
+    for (auto player = 0; player < AirHockeySim::PLAYER_COUNT; ++player)
+    {
+        const auto& mallet = table.mallets[player];
+        const auto offset = OBSERVATION_MALLETS + 4 * player;
+        observation[offset] = mallet.x;
+        observation[offset + 1] = mallet.y;
+        observation[offset + 2] = mallet.vx;
+        observation[offset + 3] = mallet.vy;
+        observation[OBSERVATION_SCORES + player] = static_cast<float>(table.scores[player]);
+    }
+}
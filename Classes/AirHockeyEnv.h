@@ -0,0 +1,76 @@
+﻿#pragma once
+#include "AirHockeySim.h"
+#include <vector>
+
+/**
+ * \brief Vectorized environment over AirHockeySim, to train mallet controllers on the game rules.
+ *
+ * Steps many tables at once from one action array and writes observations, rewards and
+ * done flags straight into buffers owned by the caller. Nothing is allocated after the
+ * constructor. All buffers are row-major, one row per table:
+ * - actions: ACTION_SIZE floats, target x and y of each mallet in table points
+ * - observations: OBSERVATION_SIZE floats, see ObservationIndex
+ * - rewards: PLAYER_COUNT floats, +1 for the player who scored, -1 for the other one
+ * - dones: 1 byte, set when a player reached the winning score or the episode is too long
+ */
+class AirHockeyEnv
+{
+public:
+    enum ObservationIndex
+    {
+        OBSERVATION_PUCK = 0,       // x, y, vx, vy
+        OBSERVATION_MALLETS = 4,    // x, y, vx, vy of each mallet
+        OBSERVATION_SCORES = 4 + 4 * AirHockeySim::PLAYER_COUNT,
+        OBSERVATION_SIZE = OBSERVATION_SCORES + AirHockeySim::PLAYER_COUNT
+    };
+
+    static const int ACTION_SIZE = 2 * AirHockeySim::PLAYER_COUNT;
+
+    /**
+     * \param envCount Number of tables
+     * \param ticksPerStep Simulation ticks between two actions (frame skip)
+     * \param winningScore An episode is done when a player reaches this score
+     * \param maxEpisodeTicks An episode is done after this many ticks, 0 for no limit
+     * \param seed Seed of the kick-off directions
+     */
+    AirHockeyEnv(int envCount, float tableWidth, float tableHeight, float malletRadius, float puckRadius,
+        int ticksPerStep, int winningScore, unsigned int maxEpisodeTicks, unsigned int seed);
+
+    int getEnvCount() const { return static_cast<int>(_tables.size()); }
+
+    /**
+     * \brief Start a new episode on the tables whose resetMask byte is not 0, all tables if resetMask is nullptr,
+     * then write the observations of every table
+     */
+    void reset(const unsigned char* resetMask, float* observations);
+
+    /**
+     * \brief Apply actions and advance every table by ticksPerStep ticks
+     */
+    void step(const float* actions, float* observations, float* rewards, unsigned char* dones);
+
+    /**
+     * \brief Same as step(), for the tables in [begin, end) only, so callers can split the work across threads.
+     * Buffers are still indexed from table 0.
+     */
+    void stepRange(int begin, int end, const float* actions, float* observations, float* rewards, unsigned char* dones);
+
+    /**
+     * \brief Direct access to a table, e.g. for rendering an episode
+     */
+    const AirHockeySim& getTable(int index) const { return _tables[index]; }
+
+private:
+    void resetTable(int index);
+    void writeObservation(int index, float* observation) const;
+
+    std::vector<AirHockeySim> _tables;
+    std::vector<unsigned int> _seeds;
+    float _tableWidth;
+    float _tableHeight;
+    float _malletRadius;
+    float _puckRadius;
+    int _ticksPerStep;
+    int _winningScore;
+    unsigned int _maxEpisodeTicks;
+};
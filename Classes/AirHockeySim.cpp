@@ -0,0 +1,298 @@
+﻿#include "AirHockeySim.h"
+#include <cmath>
+
+// a touch that did not move for longer than this does not make the mallet slower
+#define MAX_TOUCH_INTERVAL 0.1f
+// contacts resolved in one tick, a puck squeezed between a mallet and a wall stops here
+#define MAX_CONTACTS 8
+
+// what the puck hits in step(), mallets are 0..PLAYER_COUNT-1
+#define CONTACT_NONE -1
+#define CONTACT_WALL_LEFT -2
+#define CONTACT_WALL_RIGHT -3
+#define CONTACT_WALL_BOTTOM -4
+#define CONTACT_WALL_TOP -5
+
+static bool inGoalMouth(const AirHockeySim& sim, float x)
+{
+    return x >= sim.width * GOAL_LEFT && x <= sim.width * GOAL_RIGHT;
+}
+
+/**
+ * \brief First time in [0, 1] at which a circle at (dx, dy) moving by (vx, vy) relative to
+ * another circle touches it, or -1 if they do not meet. Already touching and closing in is 0.
+ */
+static float sweptCircleTimeOfImpact(float dx, float dy, float vx, float vy, float sumRadius)
+{
+    const auto c = dx * dx + dy * dy - sumRadius * sumRadius;
+    const auto b = dx * vx + dy * vy;
+    if (c <= 0.0f)
+    {
+        return b < 0.0f ? 0.0f : -1.0f;
+    }
+    const auto a = vx * vx + vy * vy;
+    if (b >= 0.0f || a <= 0.0f)
+    {
+        return -1.0f;
+    }
+    const auto discriminant = b * b - a * c;
+    if (discriminant < 0.0f)
+    {
+        return -1.0f;
+    }
+    const auto t = (-b - std::sqrt(discriminant)) / a;
+    return t <= 1.0f ? t : -1.0f;
+}
+
+void AirHockeySim::init(float tableWidth, float tableHeight, float malletRadius, float puckRadius)
+{
+    width = tableWidth;
+    height = tableHeight;
+    for (auto& mallet : mallets)
+    {
+        mallet = SimBody();
+        mallet.radius = malletRadius;
+    }
+    puck = SimBody();
+    puck.radius = puckRadius;
+    scores[0] = 0;
+    scores[1] = 0;
+    tick = 0;
+    zones[0] = { 0.0f, 0.0f, width, height * 0.5f };
+    zones[1] = { 0.0f, height * 0.5f, width, height };
+    malletMoveTicks[0] = 0;
+    malletMoveTicks[1] = 0;
+
+    resetGame();
+
+    // at kick-off the mallets stand on the base lines, not half outside of the table
+    mallets[0].y = mallets[0].nextY = malletRadius;
+    mallets[1].y = mallets[1].nextY = height - malletRadius;
+}
+
+void AirHockeySim::resetGame()
+{
+    mallets[0].x = mallets[0].nextX = width * 0.5f;
+    mallets[0].y = mallets[0].nextY = 0.0f;
+    mallets[0].vx = mallets[0].vy = 0.0f;
+
+    mallets[1].x = mallets[1].nextX = width * 0.5f;
+    mallets[1].y = mallets[1].nextY = height;
+    mallets[1].vx = mallets[1].vy = 0.0f;
+
+    puck.x = puck.nextX = width * 0.5f;
+    puck.y = puck.nextY = height * 0.5f;
+    puck.vx = puck.vy = 0.0f;
+}
+
+void AirHockeySim::moveMallet(int index, float tapX, float tapY)
+{
+    auto& mallet = mallets[index];
+    auto nextX = tapX;
+    auto nextY = tapY;
+    zones[index].clamp(mallet.radius, nextX, nextY);
+
+    // velocity is the distance to the tap over the time since the previous touch move,
+    // so the hit is as strong at 30 FPS as at 120 FPS
+    auto interval = (tick - malletMoveTicks[index]) * tickSeconds();
+    interval = interval < tickSeconds() ? tickSeconds() : interval;
+    interval = interval > MAX_TOUCH_INTERVAL ? MAX_TOUCH_INTERVAL : interval;
+    malletMoveTicks[index] = tick;
+
+    // update next position and velocity of mallet
+    mallet.nextX = nextX;
+    mallet.nextY = nextY;
+    mallet.vx = (tapX - mallet.x) / interval;
+    mallet.vy = (tapY - mallet.y) / interval;
+}
+
+void AirHockeySim::releaseMallet(int index)
+{
+    // no need to reset next position, the mallet is already there after step()
+    mallets[index].vx = 0.0f;
+    mallets[index].vy = 0.0f;
+}
+
+int AirHockeySim::zoneAt(float x, float y) const
+{
+    for (auto i = 0; i < PLAYER_COUNT; ++i)
+    {
+        if (zones[i].contains(x, y))
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int AirHockeySim::step()
+{
+    ++tick;
+
+    // if the puck is in a goal, score for the player on the other court
+    if (isGoal())
+    {
+        const auto scorer = whichCourt() == 1 ? 2 : 1;
+        scores[scorer - 1]++;
+        resetGame();
+        return scorer == 1 ? SIM_EVENT_GOAL_PLAYER1 : SIM_EVENT_GOAL_PLAYER2;
+    }
+
+    auto events = static_cast<int>(SIM_EVENT_NONE);
+
+    // Range of position, keep the puck in this range
+    const auto minX = puck.radius;
+    const auto maxX = width - puck.radius;
+    const auto minY = puck.radius;
+    const auto maxY = height - puck.radius;
+
+    // Sweep the puck through the tick and stop at each contact (time of impact),
+    // so a fast puck or a fast flick can not pass through a mallet or a corner.
+    // Time is a fraction of the tick, mallets slide from their position to next position.
+    const auto dt = tickSeconds();
+    auto puckX = puck.x;
+    auto puckY = puck.y;
+    auto puckVx = puck.vx;
+    auto puckVy = puck.vy;
+    auto time = 0.0f;
+    for (auto contact = 0; contact < MAX_CONTACTS && time < 1.0f; ++contact)
+    {
+        auto toi = 1.0f - time;
+        auto hit = CONTACT_NONE;
+
+        // check collision between puck and mallets
+        for (auto i = 0; i < PLAYER_COUNT; ++i)
+        {
+            const auto& mallet = mallets[i];
+            const auto sweepX = mallet.nextX - mallet.x;
+            const auto sweepY = mallet.nextY - mallet.y;
+            const auto dx = puckX - (mallet.x + sweepX * time);
+            const auto dy = puckY - (mallet.y + sweepY * time);
+            const auto t = sweptCircleTimeOfImpact(dx, dy, puckVx * dt - sweepX, puckVy * dt - sweepY, mallet.radius + puck.radius);
+            if (t >= 0.0f && t < toi)
+            {
+                toi = t;
+                hit = i;
+            }
+        }
+
+        // check collision between puck and walls
+        const auto wallTimeOfImpact = [](float position, float distance, float limit)
+        {
+            const auto t = (limit - position) / distance;
+            return t > 0.0f ? t : 0.0f;
+        };
+        if (puckVx < 0.0f && wallTimeOfImpact(puckX, puckVx * dt, minX) < toi)
+        {
+            toi = wallTimeOfImpact(puckX, puckVx * dt, minX);
+            hit = CONTACT_WALL_LEFT;
+        }
+        if (puckVx > 0.0f && wallTimeOfImpact(puckX, puckVx * dt, maxX) < toi)
+        {
+            toi = wallTimeOfImpact(puckX, puckVx * dt, maxX);
+            hit = CONTACT_WALL_RIGHT;
+        }
+        if (puckVy < 0.0f && wallTimeOfImpact(puckY, puckVy * dt, minY) < toi)
+        {
+            toi = wallTimeOfImpact(puckY, puckVy * dt, minY);
+            hit = CONTACT_WALL_BOTTOM;
+        }
+        if (puckVy > 0.0f && wallTimeOfImpact(puckY, puckVy * dt, maxY) < toi)
+        {
+            toi = wallTimeOfImpact(puckY, puckVy * dt, maxY);
+            hit = CONTACT_WALL_TOP;
+        }
+
+        // move the puck to the first contact
+        puckX += puckVx * dt * toi;
+        puckY += puckVy * dt * toi;
+        time += toi;
+
+        if (hit == CONTACT_NONE)
+        {
+            break;
+        }
+        else if (hit >= 0)
+        {
+            // the puck leaves the mallet along the contact normal,
+            // carrying both its own speed and the speed of the mallet
+            const auto& mallet = mallets[hit];
+            const auto sweepX = mallet.nextX - mallet.x;
+            const auto sweepY = mallet.nextY - mallet.y;
+            const auto malletX = mallet.x + sweepX * time;
+            const auto malletY = mallet.y + sweepY * time;
+            const auto sumRadius = mallet.radius + puck.radius;
+            auto normalX = puckX - malletX;
+            auto normalY = puckY - malletY;
+            const auto length = std::sqrt(normalX * normalX + normalY * normalY);
+            normalX = length > 0.0f ? normalX / length : 0.0f;
+            normalY = length > 0.0f ? normalY / length : 1.0f;
+
+            const auto magPuck = puckVx * puckVx + puckVy * puckVy;
+            const auto magMallet = mallet.vx * mallet.vx + mallet.vy * mallet.vy;
+            const auto force = std::sqrt(magPuck + magMallet);
+            puckVx = force * normalX;
+            puckVy = force * normalY;
+
+            // never slower than the mallet is sweeping along the normal, or it hits again at once
+            const auto separating = (puckVx * dt - sweepX) * normalX + (puckVy * dt - sweepY) * normalY;
+            if (separating < 0.0f)
+            {
+                puckVx -= separating / dt * normalX;
+                puckVy -= separating / dt * normalY;
+            }
+
+            // resolve overlap left by a mallet that jumped onto the puck
+            puckX = malletX + sumRadius * normalX;
+            puckY = malletY + sumRadius * normalY;
+            events |= SIM_EVENT_MALLET_HIT;
+        }
+        else if (hit == CONTACT_WALL_LEFT || hit == CONTACT_WALL_RIGHT)
+        {
+            puckX = hit == CONTACT_WALL_LEFT ? minX : maxX;
+            puckVx *= WALL_BOUNCE; // move back
+            events |= hit == CONTACT_WALL_LEFT ? SIM_EVENT_WALL_LEFT : SIM_EVENT_WALL_RIGHT;
+        }
+        else
+        {
+            puckY = hit == CONTACT_WALL_BOTTOM ? minY : maxY;
+            if (inGoalMouth(*this, puckX))
+            {
+                // there is no wall in the goal mouth, the puck stays on the goal line for the next tick
+                break;
+            }
+            puckVy *= WALL_BOUNCE;
+            events |= hit == CONTACT_WALL_BOTTOM ? SIM_EVENT_WALL_BOTTOM : SIM_EVENT_WALL_TOP;
+        }
+    }
+
+    // out of contacts for this tick, the puck waits for the next tick inside the table
+    puckX = puckX < minX ? minX : (puckX > maxX ? maxX : puckX);
+    puckY = puckY < minY ? minY : (puckY > maxY ? maxY : puckY);
+
+    puck.vx = puckVx;
+    puck.vy = puckVy;
+
+    // move bodies
+    puck.x = puck.nextX = puckX;
+    puck.y = puck.nextY = puckY;
+    for (auto& mallet : mallets)
+    {
+        mallet.x = mallet.nextX;
+        mallet.y = mallet.nextY;
+    }
+    return events;
+}
+
+bool AirHockeySim::isGoal() const
+{
+    const auto minY = puck.radius;
+    const auto maxY = height - puck.radius;
+    const auto inLine = puck.y <= minY || puck.y >= maxY;
+    return inLine && inGoalMouth(*this, puck.x);
+}
+
+int AirHockeySim::whichCourt() const
+{
+    return puck.y <= height * 0.5f ? 1 : 2;
+}
@@ -0,0 +1,142 @@
+﻿#pragma once
+
+// goal mouth, as a fraction of the table width
+#define GOAL_LEFT 0.26f
+#define GOAL_RIGHT 0.74f
+
+// the puck keeps this fraction of its speed, backward, when it hits a wall
+#define WALL_BOUNCE -0.75f
+
+/**
+ * \brief Events reported by AirHockeySim::step(), combined as bit flags
+ */
+enum SimEvent
+{
+    SIM_EVENT_NONE = 0,
+    SIM_EVENT_MALLET_HIT = 1 << 0,
+    SIM_EVENT_WALL_LEFT = 1 << 1,
+    SIM_EVENT_WALL_RIGHT = 1 << 2,
+    SIM_EVENT_WALL_BOTTOM = 1 << 3,
+    SIM_EVENT_WALL_TOP = 1 << 4,
+    SIM_EVENT_GOAL_PLAYER1 = 1 << 5,
+    SIM_EVENT_GOAL_PLAYER2 = 1 << 6,
+    SIM_EVENT_PUCK_HIT = 1 << 7,
+
+    SIM_EVENT_WALL = SIM_EVENT_WALL_LEFT | SIM_EVENT_WALL_RIGHT | SIM_EVENT_WALL_BOTTOM | SIM_EVENT_WALL_TOP,
+    SIM_EVENT_GOAL = SIM_EVENT_GOAL_PLAYER1 | SIM_EVENT_GOAL_PLAYER2
+};
+
+/**
+ * \brief A round body on the table (mallet or puck)
+ */
+struct SimBody
+{
+    // current position
+    float x;
+    float y;
+
+    // the body will move to this position in step()
+    float nextX;
+    float nextY;
+
+    // velocity, in points per second
+    float vx;
+    float vy;
+
+    float radius;
+};
+
+/**
+ * \brief Part of the table a mallet plays in, its centre is kept a radius inside
+ */
+struct SimZone
+{
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+
+    bool contains(float x, float y) const { return x >= minX && x < maxX && y >= minY && y < maxY; }
+
+    /**
+     * \brief Move a mallet position of this radius inside the zone
+     */
+    void clamp(float radius, float& x, float& y) const
+    {
+        x = x < minX + radius ? minX + radius : (x > maxX - radius ? maxX - radius : x);
+        y = y < minY + radius ? minY + radius : (y > maxY - radius ? maxY - radius : y);
+    }
+};
+
+/**
+ * \brief Renderer-free state of one air hockey match.
+ *
+ * This is a plain struct without any pointer, so it can be copied with memcpy.
+ * It does not depend on cocos2d, GameLayer only mirrors it into sprites.
+ */
+struct AirHockeySim
+{
+    static const int PLAYER_COUNT = 2;
+
+    // the simulation always advances by 1 / TICKS_PER_SECOND, whatever the frame rate is.
+    // Collisions are swept, so this only sets the input and goal resolution, not correctness
+    static const int TICKS_PER_SECOND = 120;
+
+    float width;
+    float height;
+    SimBody mallets[PLAYER_COUNT];
+    // the half court of each mallet, bottom for player 1
+    SimZone zones[PLAYER_COUNT];
+    SimBody puck;
+    int scores[PLAYER_COUNT];
+    unsigned int tick;
+
+    // tick of the last moveMallet() call of each mallet, to turn touch moves into velocity
+    unsigned int malletMoveTicks[PLAYER_COUNT];
+
+    /**
+     * \brief Duration of one tick in seconds
+     */
+    static float tickSeconds() { return 1.0f / TICKS_PER_SECOND; }
+
+    /**
+     * \brief Set table size and radius of bodies, then place them at the start positions
+     */
+    void init(float tableWidth, float tableHeight, float malletRadius, float puckRadius);
+
+    /**
+     * \brief Put mallets and puck back to the kick-off positions, scores are kept
+     */
+    void resetGame();
+
+    /**
+     * \brief Move a mallet toward a tap, the target is clamped to the zone of the mallet
+     */
+    void moveMallet(int index, float tapX, float tapY);
+
+    /**
+     * \brief Stop a mallet when its touch is released
+     */
+    void releaseMallet(int index);
+
+    /**
+     * \brief Mallet whose zone holds a point of the table, -1 outside of the table
+     */
+    int zoneAt(float x, float y) const;
+
+    /**
+     * \brief Advance the match by one tick of tickSeconds()
+     * \return SimEvent flags of what happened during this tick
+     */
+    int step();
+
+    /**
+     * \brief Whether the puck is inside one of the goals
+     */
+    bool isGoal() const;
+
+    /**
+     * \brief Court which the puck is in, 1 for bottom (player 1) and 2 for top (player 2)
+     */
+    int whichCourt() const;
+};
@@ -1,5 +1,30 @@
 #include "AppDelegate.h"
+#include "EffectPlayer.h"
 #include "GameLayer.h"
+#include "LoadingLayer.h"
+#include "PartyLayer.h"
+
+// #define PARTY_MODE 1
+// pucks and mallets on the table in party mode
+#define PARTY_BALLS 32
+#define PARTY_PLAYERS 4
+// each court split in this many zones side by side, with 4 players a 2v2 table of quadrants
+#define PARTY_ZONE_COLUMNS 2
+
+// the computer plays player 2 and may plan this many microseconds per frame, two human players otherwise
+// #define CPU_PLAYER_BUDGET_US 300
+
+// set the address of the other device to play against it online, on both devices, instead of the computer
+// #define ONLINE_REMOTE_HOST "192.168.1.2"
+#define ONLINE_PORT 7777
+// 1 on one device, 2 on the other
+#define ONLINE_LOCAL_PLAYER 1
+
+// the mallets lead the fingers by this many milliseconds to hide the input latency, 0 to follow the touches
+#define TOUCH_PREDICTION_MS 0
+
+// the table textures cooked by MyGame_texturecook, the PNGs are loaded when it is missing
+#define TEXTURE_BUNDLE "textures.pak"
 
 // #define USE_AUDIO_ENGINE 1
 #define USE_SIMPLE_AUDIO_ENGINE 1
@@ -34,6 +59,7 @@ AppDelegate::~AppDelegate()
 #elif USE_SIMPLE_AUDIO_ENGINE
     SimpleAudioEngine::end();
 #endif
+    EffectPlayer::end();
 }
 
 // if you want a different context, modify the value of glContextAttrs
@@ -54,6 +80,9 @@ static int register_all_packages()
 }
 
 bool AppDelegate::applicationDidFinishLaunching() {
+    // the time to first interactive frame starts here
+    const auto launchTime = std::chrono::steady_clock::now();
+
     // initialize director
     auto director = Director::getInstance();
     auto glview = director->getOpenGLView();
@@ -70,6 +99,7 @@ bool AppDelegate::applicationDidFinishLaunching() {
     director->setDisplayStats(true);
 
     // set FPS. the default value is 1.0/60 if you don't call this
+    // gameplay runs on its own fixed tick (AirHockeySim::TICKS_PER_SECOND), this is only the render rate
     director->setAnimationInterval(1.0f / 60);
 
     // Set the design resolution
@@ -92,14 +122,19 @@ bool AppDelegate::applicationDidFinishLaunching() {
     }
 
     AppDelegate::setSearchPaths();
-    AppDelegate::preloadSounds();
+    auto audioEngine = SimpleAudioEngine::getInstance();
+    audioEngine->setBackgroundMusicVolume(0.5f);
+    audioEngine->setEffectsVolume(5.0f);
+    // before the loading screen adds the sounds to it
+    EffectPlayer::getInstance()->start();
 
     register_all_packages();
 
-    // create a scene. it's an autorelease object
+    // draw a splash while the assets load on worker threads, the game scene comes after
+    auto loadingLayer = LoadingLayer::create(launchTime, &AppDelegate::createGameScene);
+    AppDelegate::addAssets(loadingLayer->getLoader());
     auto scene = cocos2d::Scene::create();
-    auto gameLayer = GameLayer::create();
-    scene->addChild(gameLayer, 0, "GameLayer");
+    scene->addChild(loadingLayer, 0, "LoadingLayer");
 
     // run
     director->runWithScene(scene);
@@ -107,6 +142,27 @@ bool AppDelegate::applicationDidFinishLaunching() {
     return true;
 }
 
+cocos2d::Scene* AppDelegate::createGameScene()
+{
+    // create a scene. it's an autorelease object
+    auto scene = cocos2d::Scene::create();
+#if PARTY_MODE
+    static_assert(PARTY_BALLS > 0 && PARTY_PLAYERS > 0, "a party needs at least one ball and one player");
+    auto partyLayer = PartyLayer::create(PARTY_BALLS, PARTY_PLAYERS, PARTY_ZONE_COLUMNS);
+    scene->addChild(partyLayer, 0, "PartyLayer");
+#else
+    auto gameLayer = GameLayer::create();
+#ifdef ONLINE_REMOTE_HOST
+    gameLayer->enableOnlinePlay(ONLINE_LOCAL_PLAYER - 1, ONLINE_PORT, ONLINE_REMOTE_HOST, ONLINE_PORT);
+#elif defined(CPU_PLAYER_BUDGET_US)
+    gameLayer->enableCpuPlayer(CPU_PLAYER_BUDGET_US);
+#endif
+    gameLayer->setTouchPrediction(TOUCH_PREDICTION_MS);
+    scene->addChild(gameLayer, 0, "GameLayer");
+#endif
+    return scene;
+}
+
 // This function will be called when the app is inactive. Note, when receiving a phone call it is invoked.
 void AppDelegate::applicationDidEnterBackground() {
     Director::getInstance()->stopAnimation();
@@ -117,6 +173,7 @@ void AppDelegate::applicationDidEnterBackground() {
     SimpleAudioEngine::getInstance()->pauseBackgroundMusic();
     SimpleAudioEngine::getInstance()->pauseAllEffects();
 #endif
+    EffectPlayer::getInstance()->pause();
 }
 
 // this function will be called when the app is active again
@@ -129,6 +186,7 @@ void AppDelegate::applicationWillEnterForeground() {
     SimpleAudioEngine::getInstance()->resumeBackgroundMusic();
     SimpleAudioEngine::getInstance()->resumeAllEffects();
 #endif
+    EffectPlayer::getInstance()->resume();
 }
 
 void AppDelegate::setSearchPaths()
@@ -149,12 +207,12 @@ void AppDelegate::setSearchPaths()
     fileUtils->setSearchPaths(searchPaths);
 }
 
-void AppDelegate::preloadSounds()
+void AppDelegate::addAssets(AssetLoader& loader)
 {
-    const auto fileUtils = FileUtils::getInstance();
-    auto audioEngine = SimpleAudioEngine::getInstance();
-    audioEngine->preloadEffect("hit.wav");
-    audioEngine->preloadEffect("score.wav");
-    audioEngine->setBackgroundMusicVolume(0.5f);
-    audioEngine->setEffectsVolume(5.0f);
+    loader.setTextureBundle(TEXTURE_BUNDLE);
+    loader.addSpriteSheet(TABLE_SPRITE_SHEET, TABLE_TEXTURE);
+    loader.addSound("hit.wav");
+    loader.addSound("score.wav");
+    // the score labels only draw digits
+    loader.addFont("fonts/Arial.ttf", 60, "0123456789");
 }
@@ -2,6 +2,7 @@
 #define  _APP_DELEGATE_H_
 
 #include "cocos2d.h"
+#include "AssetLoader.h"
 
 /**
 @brief    The cocos2d Application.
@@ -41,9 +42,14 @@ public:
     static void setSearchPaths();
 
     /**
-     * \brief Preload sound resouces. Must be called after setSearchPaths()
+     * \brief Add the images, sounds and fonts of the game to the loader. Must be called after setSearchPaths()
      */
-    static void preloadSounds();
+    static void addAssets(AssetLoader& loader);
+
+    /**
+     * \brief Scene of the match, its assets must be loaded
+     */
+    static cocos2d::Scene* createGameScene();
 };
 
 #endif // _APP_DELEGATE_H_
@@ -0,0 +1,252 @@
+﻿#include "AssetLoader.h"
+#include "2d/CCFontAtlas.h"
+#include "2d/CCFontAtlasCache.h"
+#include "EffectPlayer.h"
+#include <algorithm>
+
+USING_NS_CC;
+
+// more workers than this only fight over the storage
+#define MAX_LOADER_THREADS 4
+
+AssetLoader::AssetLoader()
+{
+    _nextAsset = 0;
+    _decodedCount = 0;
+    _loadedCount = 0;
+    _decodeMilliseconds = 0.0f;
+    _loadMilliseconds = 0.0f;
+}
+
+AssetLoader::~AssetLoader()
+{
+    join();
+    for (auto& asset : _assets)
+    {
+        CC_SAFE_RELEASE(asset.image);
+        CC_SAFE_RELEASE(asset.alphaImage);
+    }
+}
+
+void AssetLoader::addImage(const std::string& filename)
+{
+    _assets.push_back({ AssetType::IMAGE, filename, "", 0.0f, "", "", nullptr, nullptr, Data() });
+}
+
+void AssetLoader::addSound(const std::string& filename)
+{
+    _assets.push_back({ AssetType::SOUND, filename, "", 0.0f, "", "", nullptr, nullptr, Data() });
+}
+
+void AssetLoader::addSpriteSheet(const std::string& plist, const std::string& image)
+{
+    _assets.push_back({ AssetType::SPRITE_SHEET, image, "", 0.0f, "", plist, nullptr, nullptr, Data() });
+}
+
+void AssetLoader::addFont(const std::string& filename, float size, const std::string& glyphs)
+{
+    _assets.push_back({ AssetType::FONT, filename, "", size, glyphs, "", nullptr, nullptr, Data() });
+}
+
+void AssetLoader::setTextureBundle(const std::string& filename)
+{
+    _bundleFilename = filename;
+}
+
+void AssetLoader::start(int threadCount)
+{
+    // FileUtils caches the paths it resolves, that is not thread-safe, the workers get full paths
+    for (auto& asset : _assets)
+    {
+        asset.fullPath = FileUtils::getInstance()->fullPathForFilename(asset.filename);
+    }
+    const auto bundlePath = _bundleFilename.empty() ? "" : FileUtils::getInstance()->fullPathForFilename(_bundleFilename);
+    // Android assets are inside the APK, they can not be mapped
+    if (!bundlePath.empty() && !_bundle.map(bundlePath))
+    {
+        _bundleData = FileUtils::getInstance()->getDataFromFile(bundlePath);
+        if (!_bundle.open(_bundleData.getBytes(), _bundleData.getSize()))
+        {
+            CCLOG("Can not read texture bundle %s", bundlePath.c_str());
+            _bundleData.clear();
+        }
+    }
+    if (threadCount <= 0)
+    {
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    }
+    threadCount = std::min(std::min(threadCount, MAX_LOADER_THREADS), std::max(getAssetCount(), 1));
+    _startTime = std::chrono::steady_clock::now();
+    for (auto i = 0; i < threadCount; ++i)
+    {
+        _workers.emplace_back(&AssetLoader::work, this);
+    }
+}
+
+void AssetLoader::work()
+{
+    int index = 0;
+    while ((index = _nextAsset++) < getAssetCount())
+    {
+        decode(_assets[index]);
+        std::lock_guard<std::mutex> lock(_decodedMutex);
+        _decoded.push_back(index);
+        if (++_decodedCount == getAssetCount())
+        {
+            _decodeMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _startTime).count();
+        }
+    }
+}
+
+void AssetLoader::decode(Asset& asset)
+{
+    const auto isImage = asset.type == AssetType::IMAGE || asset.type == AssetType::SPRITE_SHEET;
+    if (isImage && _bundle.isOpen())
+    {
+        asset.image = decodeCooked(asset.filename);
+        if (asset.image)
+        {
+            asset.alphaImage = decodeCooked(asset.filename + TextureCache::getETC1AlphaFileSuffix());
+            return;
+        }
+    }
+    if (asset.fullPath.empty())
+    {
+        return;
+    }
+    if (isImage)
+    {
+        asset.image = new (std::nothrow) Image();
+        if (asset.image && !asset.image->initWithImageFile(asset.fullPath))
+        {
+            CC_SAFE_RELEASE_NULL(asset.image);
+        }
+    }
+    else
+    {
+        // the GL thread reads it again, from the system cache
+        asset.data = FileUtils::getInstance()->getDataFromFile(asset.fullPath);
+    }
+}
+
+Image* AssetLoader::decodeCooked(const std::string& name)
+{
+    size_t size = 0;
+    const auto data = _bundle.find(name, size);
+    if (!data)
+    {
+        return nullptr;
+    }
+    // a PVR file, Image copies its pixels out of the mapping; only ETC1 without GPU support is decoded
+    auto image = new (std::nothrow) Image();
+    if (image && !image->initWithImageData(data, size))
+    {
+        CCLOG("Can not read %s from the texture bundle", name.c_str());
+        CC_SAFE_RELEASE_NULL(image);
+    }
+    return image;
+}
+
+bool AssetLoader::update(std::chrono::microseconds budget)
+{
+    if (_loadedCount == getAssetCount())
+    {
+        return true;
+    }
+    // at least one asset per call, whatever the budget
+    const auto start = std::chrono::steady_clock::now();
+    do
+    {
+        auto index = -1;
+        {
+            std::lock_guard<std::mutex> lock(_decodedMutex);
+            if (_decoded.empty())
+            {
+                break;
+            }
+            index = _decoded.back();
+            _decoded.pop_back();
+        }
+        load(_assets[index]);
+        ++_loadedCount;
+    } while (std::chrono::steady_clock::now() - start < budget);
+
+    if (_loadedCount < getAssetCount())
+    {
+        return false;
+    }
+    _loadMilliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _startTime).count();
+    join();
+    _bundle.close();
+    _bundleData.clear();
+    return true;
+}
+
+void AssetLoader::load(Asset& asset)
+{
+    if (asset.fullPath.empty() && !asset.image)
+    {
+        CCLOG("Can not find asset %s", asset.filename.c_str());
+        return;
+    }
+    switch (asset.type)
+    {
+    case AssetType::IMAGE:
+        if (asset.image)
+        {
+            addTexture(asset);
+        }
+        break;
+    case AssetType::SPRITE_SHEET:
+        if (asset.image)
+        {
+            auto texture = addTexture(asset);
+            SpriteFrameCache::getInstance()->addSpriteFramesWithFile(asset.plist, texture);
+        }
+        break;
+    case AssetType::SOUND:
+        EffectPlayer::getInstance()->addSound(asset.filename, asset.data);
+        break;
+    case AssetType::FONT:
+    {
+        // the same config as Label::createWithTTF(text, filename, size), so the labels find the atlas
+        TTFConfig config(asset.filename, asset.fontSize);
+        auto atlas = FontAtlasCache::getFontAtlasTTF(&config);
+        std::u32string glyphs;
+        if (atlas && StringUtils::UTF8ToUTF32(asset.glyphs, glyphs))
+        {
+            atlas->prepareLetterDefinitions(glyphs);
+        }
+        break;
+    }
+    }
+    asset.data.clear();
+}
+
+Texture2D* AssetLoader::addTexture(Asset& asset)
+{
+    // the same key as Sprite::create(filename), so the sprites find the texture
+    const auto& key = asset.fullPath.empty() ? asset.filename : asset.fullPath;
+    auto texture = Director::getInstance()->getTextureCache()->addImage(asset.image, key);
+    if (texture && asset.alphaImage)
+    {
+        auto alphaTexture = new (std::nothrow) Texture2D();
+        if (alphaTexture && alphaTexture->initWithImage(asset.alphaImage))
+        {
+            texture->setAlphaTexture(alphaTexture);
+        }
+        CC_SAFE_RELEASE(alphaTexture);
+    }
+    CC_SAFE_RELEASE_NULL(asset.image);
+    CC_SAFE_RELEASE_NULL(asset.alphaImage);
+    return texture;
+}
+
+void AssetLoader::join()
+{
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+    _workers.clear();
+}
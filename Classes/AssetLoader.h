@@ -0,0 +1,114 @@
+﻿#pragma once
+#include "cocos2d.h"
+#include "TextureBundle.h"
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Loads the assets of the game before its first scene. Worker threads read and decode them in parallel,
+ * update() hands them to the GL thread within a time budget per frame, so a splash screen keeps drawing.
+ *
+ * Images are decoded on the workers and become textures of the TextureCache, from the texture bundle when
+ * it has them: those only need to be copied from the mapping, then uploaded as they are. The workers read the
+ * sounds, the GL thread hands them to the EffectPlayer. FontAtlasCache is not thread-safe: the workers only
+ * read the fonts, the GL thread rasterizes them.
+ */
+class AssetLoader
+{
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    /**
+     * \brief Add the assets before start(), with the search paths already set
+     */
+    void addImage(const std::string& filename);
+    void addSound(const std::string& filename);
+
+    /**
+     * \brief Add the frames of plist to the SpriteFrameCache, with image as their texture
+     */
+    void addSpriteSheet(const std::string& plist, const std::string& image);
+
+    /**
+     * \param glyphs Characters drawn into the font atlas ahead of time
+     */
+    void addFont(const std::string& filename, float size, const std::string& glyphs);
+
+    /**
+     * \brief Take the images and sprite sheet textures from a bundle cooked by MyGame_texturecook,
+     * those it does not have are decoded from their files, as without a bundle
+     */
+    void setTextureBundle(const std::string& filename);
+
+    /**
+     * \param threadCount Worker threads, 0 for one per core but the GL thread's, at most 4
+     */
+    void start(int threadCount);
+
+    /**
+     * \brief Hand what the workers decoded to the GL thread for about budget, call every frame
+     * \return Whether every asset is loaded
+     */
+    bool update(std::chrono::microseconds budget);
+
+    int getAssetCount() const { return static_cast<int>(_assets.size()); }
+    int getLoadedCount() const { return _loadedCount; }
+
+    /**
+     * \brief Time from start() until the workers were done, and until every asset was loaded
+     */
+    float getDecodeMilliseconds() const { return _decodeMilliseconds; }
+    float getLoadMilliseconds() const { return _loadMilliseconds; }
+
+private:
+    enum class AssetType
+    {
+        IMAGE,
+        SOUND,
+        FONT,
+        SPRITE_SHEET
+    };
+
+    struct Asset
+    {
+        AssetType type;
+        std::string filename;
+        std::string fullPath;
+        float fontSize;
+        std::string glyphs;
+        std::string plist;
+        // decoded by a worker
+        cocos2d::Image* image;
+        // ETC1 alpha, from the bundle
+        cocos2d::Image* alphaImage;
+        cocos2d::Data data;
+    };
+
+    void decode(Asset& asset);
+    cocos2d::Image* decodeCooked(const std::string& name);
+    void load(Asset& asset);
+    cocos2d::Texture2D* addTexture(Asset& asset);
+    void work();
+    void join();
+
+    std::vector<Asset> _assets;
+    std::string _bundleFilename;
+    TextureBundle _bundle;
+    // the bundle when it can not be mapped
+    cocos2d::Data _bundleData;
+    std::vector<std::thread> _workers;
+    std::atomic<int> _nextAsset;
+    // assets decoded and not loaded yet, indices into _assets
+    std::mutex _decodedMutex;
+    std::vector<int> _decoded;
+    int _decodedCount;
+    int _loadedCount;
+    std::chrono::steady_clock::time_point _startTime;
+    float _decodeMilliseconds;
+    float _loadMilliseconds;
+};
@@ -0,0 +1,327 @@
+﻿#include "CpuPlayer.h"
+#include <cmath>
+
+// the puck may drift this much from the prediction before it is replanned (points, points per second)
+#define PLAN_POSITION_TOLERANCE 0.5f
+#define PLAN_VELOCITY_TOLERANCE 1.0f
+// the clock is read once every this many planned ticks
+#define CLOCK_CHECK_INTERVAL 8
+// this long before the intercept the mallet stops waiting and drives through the puck
+#define STRIKE_SECONDS 0.05f
+// aim this far inside the goal post, as a fraction of the table width
+#define AIM_INSIDE_POST 0.05f
+// a mallet in front of the puck goes round to this far behind the strike position first (points)
+#define APPROACH_DISTANCE 30.0f
+// the mallet passes the puck with this margin, as a fraction of the contact distance
+#define AVOID_CLEARANCE 1.25f
+
+CpuPlayer::CpuPlayer()
+{
+    _malletIndex = 1;
+    _budget = std::chrono::microseconds(200);
+    _maxSpeed = 1500.0f;
+    _predicted = 0;
+    _planTick = 0;
+    _finished = false;
+    _hasIntercept = false;
+    _interceptIndex = 0;
+}
+
+void CpuPlayer::init(int malletIndex, int budgetMicroseconds, float maxSpeed)
+{
+    _malletIndex = malletIndex;
+    _budget = std::chrono::microseconds(budgetMicroseconds);
+    _maxSpeed = maxSpeed;
+    _predicted = 0;
+    _finished = false;
+    _hasIntercept = false;
+}
+
+void CpuPlayer::think(const AirHockeySim& sim, float dt, float& targetX, float& targetY)
+{
+    const auto deadline = std::chrono::steady_clock::now() + _budget;
+    if (!isOnPlan(sim))
+    {
+        restart(sim);
+    }
+    if (!_finished)
+    {
+        plan(sim, deadline);
+    }
+
+    const auto& mallet = sim.mallets[_malletIndex];
+    const auto bottom = _malletIndex % 2 == 0;
+    auto goalX = 0.0f;
+    auto goalY = 0.0f;
+    auto striking = false;
+    if (_hasIntercept)
+    {
+        const auto& puck = _trajectory[_interceptIndex];
+        const auto remaining = (static_cast<int>(_planTick - sim.tick) + _interceptIndex) * AirHockeySim::tickSeconds();
+        auto strikeX = 0.0f;
+        auto strikeY = 0.0f;
+        strikePosition(sim, puck, strikeX, strikeY);
+        approachPosition(sim, puck, strikeX, strikeY, goalX, goalY);
+        if (remaining <= STRIKE_SECONDS && goalX == strikeX && goalY == strikeY)
+        {
+            // behind the puck: go through it, so the mallet hits it at full speed
+            goalX += (puck.x - goalX) * 2.0f;
+            goalY += (puck.y - goalY) * 2.0f;
+            striking = true;
+        }
+    }
+    else
+    {
+        // nothing to hit yet: stand between the puck and the own goal
+        const auto goalLeft = sim.width * GOAL_LEFT;
+        const auto goalRight = sim.width * GOAL_RIGHT;
+        goalX = sim.puck.x < goalLeft ? goalLeft : (sim.puck.x > goalRight ? goalRight : sim.puck.x);
+        goalY = bottom ? mallet.radius * 2.0f : sim.height - mallet.radius * 2.0f;
+    }
+    if (!striking)
+    {
+        avoidPuck(sim, goalX, goalY);
+    }
+
+    // the mallet can not move faster than a hand
+    const auto dx = goalX - mallet.x;
+    const auto dy = goalY - mallet.y;
+    const auto distance = std::sqrt(dx * dx + dy * dy);
+    const auto reach = _maxSpeed * dt;
+    const auto scale = distance > reach ? reach / distance : 1.0f;
+    targetX = mallet.x + dx * scale;
+    targetY = mallet.y + dy * scale;
+}
+
+bool CpuPlayer::isOnPlan(const AirHockeySim& sim) const
+{
+    // without an intercept the plan depended on where the mallet was, which has changed since
+    if (_predicted == 0 || sim.tick < _planTick || (_finished && !_hasIntercept))
+    {
+        return false;
+    }
+    const auto index = static_cast<int>(sim.tick - _planTick);
+    if (index >= _predicted || (_hasIntercept && index > _interceptIndex))
+    {
+        return false;
+    }
+    const auto& expected = _trajectory[index];
+    return std::fabs(expected.x - sim.puck.x) <= PLAN_POSITION_TOLERANCE
+        && std::fabs(expected.y - sim.puck.y) <= PLAN_POSITION_TOLERANCE
+        && std::fabs(expected.vx - sim.puck.vx) <= PLAN_VELOCITY_TOLERANCE
+        && std::fabs(expected.vy - sim.puck.vy) <= PLAN_VELOCITY_TOLERANCE;
+}
+
+void CpuPlayer::restart(const AirHockeySim& sim)
+{
+    _planTick = sim.tick;
+    _trajectory[0].x = sim.puck.x;
+    _trajectory[0].y = sim.puck.y;
+    _trajectory[0].vx = sim.puck.vx;
+    _trajectory[0].vy = sim.puck.vy;
+    _predicted = 1;
+    _finished = false;
+    _hasIntercept = false;
+    _interceptIndex = 0;
+}
+
+void CpuPlayer::plan(const AirHockeySim& sim, std::chrono::steady_clock::time_point deadline)
+{
+    for (auto iteration = 1; !_finished; ++iteration)
+    {
+        if (!predictNext(sim) || evaluate(sim, _predicted - 1) || _predicted == HORIZON_TICKS)
+        {
+            _finished = true;
+        }
+        if (iteration % CLOCK_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline)
+        {
+            break;
+        }
+    }
+}
+
+bool CpuPlayer::predictNext(const AirHockeySim& sim)
+{
+    // same wall rule as AirHockeySim::step(): what goes past a wall comes back, slowed by WALL_BOUNCE
+    const auto& previous = _trajectory[_predicted - 1];
+    const auto dt = AirHockeySim::tickSeconds();
+    const auto minX = sim.puck.radius;
+    const auto maxX = sim.width - sim.puck.radius;
+    const auto minY = sim.puck.radius;
+    const auto maxY = sim.height - sim.puck.radius;
+    auto next = previous;
+    next.x += next.vx * dt;
+    next.y += next.vy * dt;
+    if (next.x < minX || next.x > maxX)
+    {
+        const auto wall = next.x < minX ? minX : maxX;
+        next.x = wall - (next.x - wall) * -WALL_BOUNCE;
+        next.vx *= WALL_BOUNCE;
+    }
+    if (next.y < minY || next.y > maxY)
+    {
+        const auto wall = next.y < minY ? minY : maxY;
+        if (next.x >= sim.width * GOAL_LEFT && next.x <= sim.width * GOAL_RIGHT)
+        {
+            // into a goal, nothing to predict after that
+            return false;
+        }
+        next.y = wall - (next.y - wall) * -WALL_BOUNCE;
+        next.vy *= WALL_BOUNCE;
+    }
+    _trajectory[_predicted++] = next;
+    return true;
+}
+
+bool CpuPlayer::evaluate(const AirHockeySim& sim, int index)
+{
+    const auto& puck = _trajectory[index];
+    const auto& mallet = sim.mallets[_malletIndex];
+
+    // only the own zone can be reached, like the touch clamps of moveMallet()
+    auto strikeX = 0.0f;
+    auto strikeY = 0.0f;
+    strikePosition(sim, puck, strikeX, strikeY);
+    auto reachableX = strikeX;
+    auto reachableY = strikeY;
+    sim.zones[_malletIndex].clamp(mallet.radius, reachableX, reachableY);
+    if (reachableX != strikeX || reachableY != strikeY)
+    {
+        return false;
+    }
+
+    // reachable if the mallet gets there before the puck, by way of the approach position and without
+    // running into the puck on the way, which could knock it into the own goal
+    auto approachX = 0.0f;
+    auto approachY = 0.0f;
+    approachPosition(sim, puck, strikeX, strikeY, approachX, approachY);
+    const auto time = (static_cast<int>(_planTick - sim.tick) + index) * AirHockeySim::tickSeconds();
+    const auto length = std::sqrt((approachX - mallet.x) * (approachX - mallet.x) + (approachY - mallet.y) * (approachY - mallet.y))
+        + std::sqrt((strikeX - approachX) * (strikeX - approachX) + (strikeY - approachY) * (strikeY - approachY));
+    if (length > _maxSpeed * time || !isPathClear(sim, index, approachX, approachY, strikeX, strikeY))
+    {
+        return false;
+    }
+    _hasIntercept = true;
+    _interceptIndex = index;
+    return true;
+}
+
+void CpuPlayer::strikePosition(const AirHockeySim& sim, const PuckState& puck, float& x, float& y) const
+{
+    // stand behind the puck on the line to the side of the other goal that its mallet does not cover
+    const auto targetY = _malletIndex % 2 == 0 ? sim.height : 0.0f;
+    const auto& opponent = sim.mallets[(_malletIndex + 1) % AirHockeySim::PLAYER_COUNT];
+    const auto targetX = sim.width * (opponent.x < sim.width * 0.5f ? GOAL_RIGHT - AIM_INSIDE_POST : GOAL_LEFT + AIM_INSIDE_POST);
+    auto dx = targetX - puck.x;
+    auto dy = targetY - puck.y;
+    const auto length = std::sqrt(dx * dx + dy * dy);
+    dx = length > 0.0f ? dx / length : 0.0f;
+    dy = length > 0.0f ? dy / length : 1.0f;
+    const auto distance = sim.mallets[_malletIndex].radius + sim.puck.radius;
+    x = puck.x - dx * distance;
+    y = puck.y - dy * distance;
+}
+
+void CpuPlayer::approachPosition(const AirHockeySim& sim, const PuckState& puck, float strikeX, float strikeY, float& x, float& y) const
+{
+    // the strike position is behind the puck, seen from the target; a mallet already as far back goes straight
+    // to it, one in front of it or beside it first goes further back
+    const auto& mallet = sim.mallets[_malletIndex];
+    const auto backX = strikeX - puck.x;
+    const auto backY = strikeY - puck.y;
+    if ((mallet.x - strikeX) * backX + (mallet.y - strikeY) * backY >= 0.0f)
+    {
+        x = strikeX;
+        y = strikeY;
+        return;
+    }
+    const auto length = std::sqrt(backX * backX + backY * backY);
+    x = strikeX + backX / length * APPROACH_DISTANCE;
+    y = strikeY + backY / length * APPROACH_DISTANCE;
+    sim.zones[_malletIndex].clamp(mallet.radius, x, y);
+}
+
+bool CpuPlayer::isPathClear(const AirHockeySim& sim, int index, float waypointX, float waypointY, float strikeX, float strikeY) const
+{
+    // the mallet at full speed to the waypoint then the strike position, where it waits, against the predicted
+    // puck of each tick before the intercept. A puck coming from behind the strike position runs into the
+    // waiting mallet too, and bounces back toward the own goal
+    const auto& mallet = sim.mallets[_malletIndex];
+    const auto contact = (mallet.radius + sim.puck.radius) * 0.99f;
+    const auto first = static_cast<int>(sim.tick - _planTick);
+    const auto step = _maxSpeed * AirHockeySim::tickSeconds();
+    const auto firstLeg = std::sqrt((waypointX - mallet.x) * (waypointX - mallet.x) + (waypointY - mallet.y) * (waypointY - mallet.y));
+    const auto secondLeg = std::sqrt((strikeX - waypointX) * (strikeX - waypointX) + (strikeY - waypointY) * (strikeY - waypointY));
+    for (auto i = first + 1; i < index; ++i)
+    {
+        const auto travelled = step * (i - first);
+        auto x = strikeX;
+        auto y = strikeY;
+        if (travelled < firstLeg)
+        {
+            x = mallet.x + (waypointX - mallet.x) * travelled / firstLeg;
+            y = mallet.y + (waypointY - mallet.y) * travelled / firstLeg;
+        }
+        else if (travelled < firstLeg + secondLeg)
+        {
+            x = waypointX + (strikeX - waypointX) * (travelled - firstLeg) / secondLeg;
+            y = waypointY + (strikeY - waypointY) * (travelled - firstLeg) / secondLeg;
+        }
+        const auto dx = _trajectory[i].x - x;
+        const auto dy = _trajectory[i].y - y;
+        if (dx * dx + dy * dy < contact * contact)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void CpuPlayer::avoidPuck(const AirHockeySim& sim, float& x, float& y) const
+{
+    // when the way to (x, y) passes the puck, go beside the puck first, on the side the way already passes
+    const auto& mallet = sim.mallets[_malletIndex];
+    const auto clearance = (mallet.radius + sim.puck.radius) * AVOID_CLEARANCE;
+    const auto dx = x - mallet.x;
+    const auto dy = y - mallet.y;
+    const auto lengthSquared = dx * dx + dy * dy;
+    if (lengthSquared <= 0.0f)
+    {
+        return;
+    }
+    const auto along = ((sim.puck.x - mallet.x) * dx + (sim.puck.y - mallet.y) * dy) / lengthSquared;
+    if (along <= 0.0f)
+    {
+        // moving away from the puck
+        return;
+    }
+    const auto closest = along < 1.0f ? along : 1.0f;
+    auto sideX = mallet.x + dx * closest - sim.puck.x;
+    auto sideY = mallet.y + dy * closest - sim.puck.y;
+    auto distance = std::sqrt(sideX * sideX + sideY * sideY);
+    if (distance >= clearance)
+    {
+        return;
+    }
+    if (distance < 1.0f)
+    {
+        // straight at the puck, either side does
+        sideX = -dy;
+        sideY = dx;
+        distance = std::sqrt(lengthSquared);
+    }
+    auto aroundX = sim.puck.x + sideX / distance * clearance;
+    auto aroundY = sim.puck.y + sideY / distance * clearance;
+    auto clampedX = aroundX;
+    auto clampedY = aroundY;
+    sim.zones[_malletIndex].clamp(mallet.radius, clampedX, clampedY);
+    if (clampedX != aroundX || clampedY != aroundY)
+    {
+        // no room between the puck and the wall on that side
+        aroundX = sim.puck.x - sideX / distance * clearance;
+        aroundY = sim.puck.y - sideY / distance * clearance;
+    }
+    x = aroundX;
+    y = aroundY;
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+#include "AirHockeySim.h"
+#include <chrono>
+
+/**
+ * \brief Computer opponent: predicts the puck, wall bounces included, and plans an intercept.
+ * The mallet reaches the strike position from behind the puck and goes around the puck, never
+ * through it, so it does not knock the puck into its own goal.
+ *
+ * Planning is anytime: each think() works until its time budget is spent and keeps the
+ * trajectory and best intercept found so far for the next frame, while the puck still
+ * follows the prediction. A bigger budget finds intercepts sooner, which is the difficulty.
+ * It does not depend on cocos2d.
+ */
+class CpuPlayer
+{
+public:
+    // how far ahead the puck is predicted
+    static const int HORIZON_TICKS = 2 * AirHockeySim::TICKS_PER_SECOND;
+
+    CpuPlayer();
+
+    /**
+     * \param malletIndex Mallet played by the computer
+     * \param budgetMicroseconds Planning time allowed per think()
+     * \param maxSpeed Fastest the mallet can move, in points per second
+     */
+    void init(int malletIndex, int budgetMicroseconds, float maxSpeed);
+
+    void setBudget(int budgetMicroseconds) { _budget = std::chrono::microseconds(budgetMicroseconds); }
+
+    int getMalletIndex() const { return _malletIndex; }
+
+    /**
+     * \brief Plan within the budget, then give where the mallet moves during a frame of dt seconds
+     */
+    void think(const AirHockeySim& sim, float dt, float& targetX, float& targetY);
+
+    /**
+     * \brief Number of predicted ticks of the current plan
+     */
+    int getPredictedTicks() const { return _predicted; }
+
+    /**
+     * \brief Whether the current plan has an intercept
+     */
+    bool hasIntercept() const { return _hasIntercept; }
+
+private:
+    struct PuckState
+    {
+        float x;
+        float y;
+        float vx;
+        float vy;
+    };
+
+    bool isOnPlan(const AirHockeySim& sim) const;
+    void restart(const AirHockeySim& sim);
+    void plan(const AirHockeySim& sim, std::chrono::steady_clock::time_point deadline);
+    bool predictNext(const AirHockeySim& sim);
+    bool evaluate(const AirHockeySim& sim, int index);
+    void strikePosition(const AirHockeySim& sim, const PuckState& puck, float& x, float& y) const;
+    void approachPosition(const AirHockeySim& sim, const PuckState& puck, float strikeX, float strikeY, float& x, float& y) const;
+    bool isPathClear(const AirHockeySim& sim, int index, float waypointX, float waypointY, float strikeX, float strikeY) const;
+    void avoidPuck(const AirHockeySim& sim, float& x, float& y) const;
+
+    int _malletIndex;
+    std::chrono::microseconds _budget;
+    float _maxSpeed;
+
+    // prediction, _trajectory[0] is the puck at _planTick
+    PuckState _trajectory[HORIZON_TICKS];
+    int _predicted;
+    unsigned int _planTick;
+    bool _finished;
+
+    // earliest reachable intercept found so far
+    bool _hasIntercept;
+    int _interceptIndex;
+};
@@ -0,0 +1,227 @@
+﻿#include "EffectMixer.h"
+#include <algorithm>
+#include <cstring>
+
+// frames mixed at once, a larger buffer is mixed in several passes
+#define MIX_CHUNK_FRAMES 512
+
+EffectMixer::EffectMixer()
+    : _soundCount(0), _outputLatencyUs(0), _dropped(0), _stolen(0)
+{
+    _sampleRate = 44100;
+    for (auto& voice : _voices)
+    {
+        voice.sound = -1;
+        voice.position = 0;
+        voice.gainLeft = 0.0f;
+        voice.gainRight = 0.0f;
+    }
+}
+
+void EffectMixer::init(int sampleRate)
+{
+    _sampleRate = sampleRate;
+    _buffer.assign(MIX_CHUNK_FRAMES * 2, 0.0f);
+}
+
+int EffectMixer::addSound(const int16_t* samples, int frames, int channels, int sampleRate)
+{
+    const auto id = _soundCount.load(std::memory_order_relaxed);
+    if (id == SOUND_COUNT || frames <= 0 || channels < 1 || channels > 2 || sampleRate <= 0)
+    {
+        return -1;
+    }
+    auto& sound = _sounds[id];
+    sound.channels = channels;
+    if (sampleRate == _sampleRate)
+    {
+        sound.frames = frames;
+        sound.samples.assign(samples, samples + frames * channels);
+    }
+    else
+    {
+        // linear, the effects are short and resampled once
+        const auto step = static_cast<double>(sampleRate) / _sampleRate;
+        sound.frames = static_cast<int>(frames / step);
+        sound.samples.resize(static_cast<size_t>(sound.frames) * channels);
+        for (auto i = 0; i < sound.frames; ++i)
+        {
+            const auto source = i * step;
+            const auto index = static_cast<int>(source);
+            const auto next = std::min(index + 1, frames - 1);
+            const auto fraction = static_cast<float>(source - index);
+            for (auto c = 0; c < channels; ++c)
+            {
+                const auto a = samples[index * channels + c];
+                const auto b = samples[next * channels + c];
+                sound.samples[i * channels + c] = static_cast<int16_t>(a + (b - a) * fraction);
+            }
+        }
+    }
+    _soundCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+bool EffectMixer::decodeWav(const unsigned char* data, size_t size, std::vector<int16_t>& samples, int& channels, int& sampleRate)
+{
+    if (!data || size < 12 || memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+    auto hasFormat = false;
+    size_t offset = 12;
+    while (offset + 8 <= size)
+    {
+        uint32_t chunkSize;
+        memcpy(&chunkSize, data + offset + 4, 4);
+        const auto chunk = data + offset + 8;
+        const auto available = std::min<size_t>(chunkSize, size - offset - 8);
+        if (memcmp(data + offset, "fmt ", 4) == 0 && available >= 16)
+        {
+            uint16_t format, channelCount, bits;
+            uint32_t rate;
+            memcpy(&format, chunk, 2);
+            memcpy(&channelCount, chunk + 2, 2);
+            memcpy(&rate, chunk + 4, 4);
+            memcpy(&bits, chunk + 14, 2);
+            // PCM only, the effects are not worth a decoder
+            if (format != 1 || bits != 16 || channelCount < 1 || channelCount > 2)
+            {
+                return false;
+            }
+            channels = channelCount;
+            sampleRate = static_cast<int>(rate);
+            hasFormat = true;
+        }
+        else if (memcmp(data + offset, "data", 4) == 0 && hasFormat)
+        {
+            samples.resize(available / 2);
+            memcpy(samples.data(), chunk, samples.size() * 2);
+            return !samples.empty();
+        }
+        // chunks are padded to an even size
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+    return false;
+}
+
+bool EffectMixer::play(int sound, float volume, float pan)
+{
+    if (sound < 0 || sound >= SOUND_COUNT)
+    {
+        return false;
+    }
+    const Command command = { sound, volume, pan, std::chrono::steady_clock::now() };
+    if (!_commands.push(command))
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void EffectMixer::mix(int16_t* out, int frames)
+{
+    // the voices started now reach the speaker after what the output already holds
+    const auto now = std::chrono::steady_clock::now();
+    const auto outputTime = now + std::chrono::microseconds(_outputLatencyUs.load(std::memory_order_relaxed));
+    Command command;
+    while (_commands.pop(command))
+    {
+        this->startVoice(command, outputTime);
+    }
+
+    while (frames > 0)
+    {
+        const auto chunk = std::min(frames, MIX_CHUNK_FRAMES);
+        std::fill(_buffer.begin(), _buffer.begin() + chunk * 2, 0.0f);
+        for (auto& voice : _voices)
+        {
+            if (voice.sound >= 0)
+            {
+                this->mixVoice(voice, _buffer.data(), chunk);
+            }
+        }
+        for (auto i = 0; i < chunk * 2; ++i)
+        {
+            const auto sample = std::min(std::max(_buffer[i], -32768.0f), 32767.0f);
+            out[i] = static_cast<int16_t>(sample);
+        }
+        out += chunk * 2;
+        frames -= chunk;
+    }
+}
+
+void EffectMixer::startVoice(const Command& command, std::chrono::steady_clock::time_point outputTime)
+{
+    if (command.sound >= _soundCount.load(std::memory_order_acquire))
+    {
+        return;
+    }
+    // a free voice, or the one closest to its end, its loss is the least heard
+    Voice* target = nullptr;
+    auto targetRemaining = 0;
+    for (auto& voice : _voices)
+    {
+        if (voice.sound < 0)
+        {
+            target = &voice;
+            break;
+        }
+        const auto remaining = _sounds[voice.sound].frames - voice.position;
+        if (!target || remaining < targetRemaining)
+        {
+            target = &voice;
+            targetRemaining = remaining;
+        }
+    }
+    if (target->sound >= 0)
+    {
+        _stolen.fetch_add(1, std::memory_order_relaxed);
+    }
+    const auto pan = std::min(std::max(command.pan, -1.0f), 1.0f);
+    target->sound = command.sound;
+    target->position = 0;
+    target->gainLeft = command.volume * std::min(1.0f, 1.0f - pan);
+    target->gainRight = command.volume * std::min(1.0f, 1.0f + pan);
+    const Started started = { command.triggerTime, outputTime };
+    // a full ring loses the measure, not the sound
+    _started.push(started);
+}
+
+void EffectMixer::mixVoice(Voice& voice, float* buffer, int frames)
+{
+    const auto& sound = _sounds[voice.sound];
+    const auto count = std::min(frames, sound.frames - voice.position);
+    const auto samples = sound.samples.data() + static_cast<size_t>(voice.position) * sound.channels;
+    if (sound.channels == 1)
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            buffer[i * 2] += samples[i] * voice.gainLeft;
+            buffer[i * 2 + 1] += samples[i] * voice.gainRight;
+        }
+    }
+    else
+    {
+        for (auto i = 0; i < count; ++i)
+        {
+            buffer[i * 2] += samples[i * 2] * voice.gainLeft;
+            buffer[i * 2 + 1] += samples[i * 2 + 1] * voice.gainRight;
+        }
+    }
+    voice.position += count;
+    if (voice.position >= sound.frames)
+    {
+        voice.sound = -1;
+    }
+}
+
+void EffectMixer::collectLatency(LatencyHistogram& histogram)
+{
+    Started started;
+    while (_started.pop(started))
+    {
+        histogram.add(std::chrono::duration<float, std::milli>(started.outputTime - started.triggerTime).count());
+    }
+}
@@ -0,0 +1,158 @@
+﻿#pragma once
+#include "LatencyHistogram.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * \brief Fixed-size ring of one producer thread and one consumer thread, without lock or allocation
+ */
+template <typename T, unsigned int CAPACITY>
+class SpscRing
+{
+public:
+    SpscRing() : _head(0), _tail(0) {}
+
+    /**
+     * \return false when the ring is full
+     */
+    bool push(const T& item)
+    {
+        const auto head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == CAPACITY)
+        {
+            return false;
+        }
+        _items[head & (CAPACITY - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item)
+    {
+        const auto tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = _items[tail & (CAPACITY - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "the capacity must be a power of 2");
+    T _items[CAPACITY];
+    // _head is only written by push(), _tail only by pop(); both only grow
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+};
+
+/**
+ * \brief Mixes short sound effects, decoded to PCM ahead of time, into a stereo 16 bit stream.
+ *
+ * The game thread calls play(), which only pushes a command into a ring; the audio thread starts the voices
+ * at its next mix(). When all VOICE_COUNT voices play, the one closest to its end is stolen. Each started
+ * voice reports when it reaches the speaker, collectLatency() turns that into trigger-to-output latency.
+ * It does not depend on cocos2d, the output is up to the caller (see EffectPlayer).
+ */
+class EffectMixer
+{
+public:
+    static const int VOICE_COUNT = 16;
+    static const int SOUND_COUNT = 16;
+
+    EffectMixer();
+
+    /**
+     * \brief Set the output rate, before adding sounds
+     */
+    void init(int sampleRate);
+
+    /**
+     * \brief Add a sound, resampled to the output rate if needed. Not while the audio thread adds sounds.
+     * \param samples Interleaved, 1 or 2 channels
+     * \return Its id for play(), -1 when the mixer is full
+     */
+    int addSound(const int16_t* samples, int frames, int channels, int sampleRate);
+
+    /**
+     * \brief Read a 16 bit PCM WAV file
+     */
+    static bool decodeWav(const unsigned char* data, size_t size, std::vector<int16_t>& samples, int& channels, int& sampleRate);
+
+    /**
+     * \brief Start a sound at the next mix, from the game thread only
+     * \param pan -1 left to 1 right
+     * \return false when the command ring was full and the sound dropped
+     */
+    bool play(int sound, float volume, float pan);
+
+    /**
+     * \brief Fill a buffer, from the audio thread only
+     */
+    void mix(int16_t* out, int frames);
+
+    /**
+     * \brief How long the output takes to play a buffer after mix() filled it, set by the output
+     */
+    void setOutputLatency(std::chrono::microseconds latency) { _outputLatencyUs.store(latency.count(), std::memory_order_relaxed); }
+
+    /**
+     * \brief Add the latency of the voices started since the last call, from the game thread
+     */
+    void collectLatency(LatencyHistogram& histogram);
+
+    unsigned int getDroppedCount() const { return _dropped.load(std::memory_order_relaxed); }
+    unsigned int getStolenCount() const { return _stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Sound
+    {
+        // interleaved, at the output rate
+        std::vector<int16_t> samples;
+        int frames;
+        int channels;
+    };
+
+    struct Command
+    {
+        int sound;
+        float volume;
+        float pan;
+        std::chrono::steady_clock::time_point triggerTime;
+    };
+
+    struct Started
+    {
+        std::chrono::steady_clock::time_point triggerTime;
+        std::chrono::steady_clock::time_point outputTime;
+    };
+
+    struct Voice
+    {
+        // -1 when free
+        int sound;
+        int position;
+        float gainLeft;
+        float gainRight;
+    };
+
+    void startVoice(const Command& command, std::chrono::steady_clock::time_point outputTime);
+    void mixVoice(Voice& voice, float* buffer, int frames);
+
+    int _sampleRate;
+    Sound _sounds[SOUND_COUNT];
+    // sounds [0, _soundCount) are complete, the audio thread reads no further
+    std::atomic<int> _soundCount;
+    Voice _voices[VOICE_COUNT];
+    SpscRing<Command, 64> _commands;
+    SpscRing<Started, 64> _started;
+    std::atomic<long long> _outputLatencyUs;
+    std::atomic<unsigned int> _dropped;
+    std::atomic<unsigned int> _stolen;
+    // mixed in float, then clamped to 16 bit
+    std::vector<float> _buffer;
+};
@@ -0,0 +1,312 @@
+﻿#include "EffectPlayer.h"
+#include "audio/include/SimpleAudioEngine.h"
+#include <cstring>
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+#include "fmod.hpp"
+#endif
+
+USING_NS_CC;
+
+// frames the mixer fills at once, the output holds OUTPUT_BUFFER_COUNT of them
+#define OUTPUT_BUFFER_FRAMES 256
+#define OUTPUT_BUFFER_COUNT 2
+
+static EffectPlayer* s_sharedEffectPlayer = nullptr;
+
+#if CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID
+
+// an OpenSL ES buffer queue, the mixer refills a buffer each time one is played
+struct EffectPlayer::Output
+{
+    SLObjectItf engineObject;
+    SLObjectItf outputMixObject;
+    SLObjectItf playerObject;
+    SLPlayItf play;
+    SLAndroidSimpleBufferQueueItf queue;
+    EffectMixer* mixer;
+    int16_t buffers[OUTPUT_BUFFER_COUNT][OUTPUT_BUFFER_FRAMES * 2];
+    int nextBuffer;
+
+    Output()
+    {
+        engineObject = nullptr;
+        outputMixObject = nullptr;
+        playerObject = nullptr;
+        play = nullptr;
+        queue = nullptr;
+        mixer = nullptr;
+        nextBuffer = 0;
+    }
+
+    ~Output()
+    {
+        if (playerObject)
+        {
+            (*playerObject)->Destroy(playerObject);
+        }
+        if (outputMixObject)
+        {
+            (*outputMixObject)->Destroy(outputMixObject);
+        }
+        if (engineObject)
+        {
+            (*engineObject)->Destroy(engineObject);
+        }
+    }
+
+    static void onBufferPlayed(SLAndroidSimpleBufferQueueItf /*queue*/, void* context)
+    {
+        static_cast<Output*>(context)->enqueue();
+    }
+
+    void enqueue()
+    {
+        auto buffer = buffers[nextBuffer];
+        nextBuffer = (nextBuffer + 1) % OUTPUT_BUFFER_COUNT;
+        mixer->mix(buffer, OUTPUT_BUFFER_FRAMES);
+        (*queue)->Enqueue(queue, buffer, sizeof(buffers[0]));
+    }
+
+    bool start(EffectMixer& effectMixer)
+    {
+        // SL_SAMPLINGRATE_44_1, most devices mix at 44.1 or 48 kHz
+        const auto sampleRate = 44100;
+        mixer = &effectMixer;
+        mixer->init(sampleRate);
+        // a buffer is mixed while the other one plays
+        mixer->setOutputLatency(std::chrono::microseconds(1000000LL * OUTPUT_BUFFER_FRAMES * (OUTPUT_BUFFER_COUNT - 1) / sampleRate));
+
+        SLEngineItf engine;
+        if (slCreateEngine(&engineObject, 0, nullptr, 0, nullptr, nullptr) != SL_RESULT_SUCCESS
+            || (*engineObject)->Realize(engineObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS
+            || (*engineObject)->GetInterface(engineObject, SL_IID_ENGINE, &engine) != SL_RESULT_SUCCESS
+            || (*engine)->CreateOutputMix(engine, &outputMixObject, 0, nullptr, nullptr) != SL_RESULT_SUCCESS
+            || (*outputMixObject)->Realize(outputMixObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS)
+        {
+            return false;
+        }
+        SLDataLocator_AndroidSimpleBufferQueue queueLocator = { SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE, OUTPUT_BUFFER_COUNT };
+        SLDataFormat_PCM format = { SL_DATAFORMAT_PCM, 2, SL_SAMPLINGRATE_44_1, SL_PCMSAMPLEFORMAT_FIXED_16,
+            SL_PCMSAMPLEFORMAT_FIXED_16, SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, SL_BYTEORDER_LITTLEENDIAN };
+        SLDataSource source = { &queueLocator, &format };
+        SLDataLocator_OutputMix outputMixLocator = { SL_DATALOCATOR_OUTPUTMIX, outputMixObject };
+        SLDataSink sink = { &outputMixLocator, nullptr };
+        const SLInterfaceID interfaces[] = { SL_IID_ANDROIDSIMPLEBUFFERQUEUE };
+        const SLboolean required[] = { SL_BOOLEAN_TRUE };
+        if ((*engine)->CreateAudioPlayer(engine, &playerObject, &source, &sink, 1, interfaces, required) != SL_RESULT_SUCCESS
+            || (*playerObject)->Realize(playerObject, SL_BOOLEAN_FALSE) != SL_RESULT_SUCCESS
+            || (*playerObject)->GetInterface(playerObject, SL_IID_PLAY, &play) != SL_RESULT_SUCCESS
+            || (*playerObject)->GetInterface(playerObject, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &queue) != SL_RESULT_SUCCESS
+            || (*queue)->RegisterCallback(queue, &Output::onBufferPlayed, this) != SL_RESULT_SUCCESS)
+        {
+            return false;
+        }
+        for (auto i = 0; i < OUTPUT_BUFFER_COUNT; ++i)
+        {
+            enqueue();
+        }
+        return (*play)->SetPlayState(play, SL_PLAYSTATE_PLAYING) == SL_RESULT_SUCCESS;
+    }
+
+    void setPaused(bool paused)
+    {
+        (*play)->SetPlayState(play, paused ? SL_PLAYSTATE_PAUSED : SL_PLAYSTATE_PLAYING);
+    }
+};
+
+#elif CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+
+// an FMOD user stream on its own system, FMOD's stream thread asks the mixer for each buffer
+struct EffectPlayer::Output
+{
+    FMOD::System* system;
+    FMOD::Sound* sound;
+    FMOD::Channel* channel;
+    EffectMixer* mixer;
+
+    Output()
+    {
+        system = nullptr;
+        sound = nullptr;
+        channel = nullptr;
+        mixer = nullptr;
+    }
+
+    ~Output()
+    {
+        if (sound)
+        {
+            sound->release();
+        }
+        if (system)
+        {
+            system->close();
+            system->release();
+        }
+    }
+
+    static FMOD_RESULT F_CALLBACK onRead(FMOD_SOUND* sound, void* data, unsigned int length)
+    {
+        void* context = nullptr;
+        reinterpret_cast<FMOD::Sound*>(sound)->getUserData(&context);
+        static_cast<Output*>(context)->mixer->mix(static_cast<int16_t*>(data), length / (2 * sizeof(int16_t)));
+        return FMOD_OK;
+    }
+
+    bool start(EffectMixer& effectMixer)
+    {
+        // FMOD buffers 4 x 1024 frames by default, about 85 ms
+        if (FMOD::System_Create(&system) != FMOD_OK
+            || system->setDSPBufferSize(OUTPUT_BUFFER_FRAMES, 4) != FMOD_OK
+            || system->init(4, FMOD_INIT_NORMAL, nullptr) != FMOD_OK)
+        {
+            return false;
+        }
+        auto sampleRate = 0;
+        system->getSoftwareFormat(&sampleRate, nullptr, nullptr);
+        unsigned int dspLength = 0;
+        auto dspCount = 0;
+        system->getDSPBufferSize(&dspLength, &dspCount);
+        mixer = &effectMixer;
+        mixer->init(sampleRate);
+        // the stream double buffers, then the FMOD mixer queues its own buffers
+        const auto latencyFrames = OUTPUT_BUFFER_FRAMES * OUTPUT_BUFFER_COUNT + dspLength * dspCount;
+        mixer->setOutputLatency(std::chrono::microseconds(1000000LL * latencyFrames / sampleRate));
+
+        FMOD_CREATESOUNDEXINFO info;
+        memset(&info, 0, sizeof(info));
+        info.cbsize = sizeof(info);
+        info.numchannels = 2;
+        info.defaultfrequency = sampleRate;
+        info.format = FMOD_SOUND_FORMAT_PCM16;
+        info.decodebuffersize = OUTPUT_BUFFER_FRAMES;
+        // a second, looped forever
+        info.length = sampleRate * 2 * sizeof(int16_t);
+        info.pcmreadcallback = &Output::onRead;
+        info.userdata = this;
+        return system->createStream(nullptr, FMOD_OPENUSER | FMOD_LOOP_NORMAL | FMOD_2D, &info, &sound) == FMOD_OK
+            && system->playSound(sound, nullptr, false, &channel) == FMOD_OK;
+    }
+
+    void setPaused(bool paused)
+    {
+        channel->setPaused(paused);
+    }
+};
+
+#else
+
+// no low-latency output here yet, SimpleAudioEngine plays the effects
+struct EffectPlayer::Output
+{
+    bool start(EffectMixer&) { return false; }
+    void setPaused(bool) {}
+};
+
+#endif
+
+EffectPlayer* EffectPlayer::getInstance()
+{
+    if (!s_sharedEffectPlayer)
+    {
+        s_sharedEffectPlayer = new (std::nothrow) EffectPlayer();
+    }
+    return s_sharedEffectPlayer;
+}
+
+void EffectPlayer::end()
+{
+    CC_SAFE_DELETE(s_sharedEffectPlayer);
+}
+
+EffectPlayer::EffectPlayer()
+{
+    _output = nullptr;
+}
+
+EffectPlayer::~EffectPlayer()
+{
+    CC_SAFE_DELETE(_output);
+}
+
+bool EffectPlayer::start()
+{
+    if (_output)
+    {
+        return true;
+    }
+    _output = new (std::nothrow) Output();
+    if (_output && !_output->start(_mixer))
+    {
+        CCLOG("No low-latency audio output, the effects play through SimpleAudioEngine");
+        CC_SAFE_DELETE(_output);
+    }
+    return _output != nullptr;
+}
+
+int EffectPlayer::addSound(const std::string& filename, const Data& data)
+{
+    std::vector<int16_t> samples;
+    auto channels = 0;
+    auto sampleRate = 0;
+    auto mixerId = -1;
+    if (_output && EffectMixer::decodeWav(data.getBytes(), data.getSize(), samples, channels, sampleRate))
+    {
+        mixerId = _mixer.addSound(samples.data(), static_cast<int>(samples.size()) / channels, channels, sampleRate);
+    }
+    if (mixerId < 0)
+    {
+        CocosDenshion::SimpleAudioEngine::getInstance()->preloadEffect(filename.c_str());
+    }
+    _sounds.push_back({ filename, mixerId });
+    return static_cast<int>(_sounds.size()) - 1;
+}
+
+int EffectPlayer::findSound(const std::string& filename) const
+{
+    for (size_t i = 0; i < _sounds.size(); ++i)
+    {
+        if (_sounds[i].filename == filename)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void EffectPlayer::play(int sound, float volume, float pan)
+{
+    if (sound < 0 || sound >= static_cast<int>(_sounds.size()))
+    {
+        return;
+    }
+    const auto& effect = _sounds[sound];
+    if (effect.mixerId >= 0)
+    {
+        _mixer.play(effect.mixerId, volume, pan);
+    }
+    else
+    {
+        CocosDenshion::SimpleAudioEngine::getInstance()->playEffect(effect.filename.c_str(), false, 1.0f, pan, volume);
+    }
+}
+
+void EffectPlayer::pause()
+{
+    if (_output)
+    {
+        _output->setPaused(true);
+    }
+}
+
+void EffectPlayer::resume()
+{
+    if (_output)
+    {
+        _output->setPaused(false);
+    }
+}
@@ -0,0 +1,68 @@
+﻿#pragma once
+#include "cocos2d.h"
+#include "EffectMixer.h"
+#include <string>
+#include <vector>
+
+/**
+ * \brief Plays the sound effects through an EffectMixer on its own low-latency output: OpenSL ES on
+ * Android, FMOD on Linux. play() neither allocates nor locks on the game thread.
+ *
+ * Where there is no such output, or for a sound that is not a 16 bit PCM WAV, it falls back to
+ * SimpleAudioEngine.
+ */
+class EffectPlayer
+{
+public:
+    static EffectPlayer* getInstance();
+    static void end();
+
+    /**
+     * \brief Open the output, before adding sounds
+     * \return false when the platform has no output, SimpleAudioEngine plays the sounds then
+     */
+    bool start();
+
+    /**
+     * \brief Add a sound from its file content, on the GL thread
+     * \return Its id for play()
+     */
+    int addSound(const std::string& filename, const cocos2d::Data& data);
+
+    /**
+     * \return The id of an added sound, -1 if it was not added
+     */
+    int findSound(const std::string& filename) const;
+
+    /**
+     * \param pan -1 left to 1 right
+     */
+    void play(int sound, float volume, float pan);
+
+    void pause();
+    void resume();
+
+    /**
+     * \brief Add the trigger-to-output latency of the sounds started since the last call, on the GL thread.
+     * It does not include the latency of the audio hardware after the output's buffers.
+     */
+    void collectLatency(LatencyHistogram& histogram) { _mixer.collectLatency(histogram); }
+
+    bool isRunning() const { return _output != nullptr; }
+
+private:
+    struct Output;
+    struct Sound
+    {
+        std::string filename;
+        // -1 for a sound SimpleAudioEngine plays
+        int mixerId;
+    };
+
+    EffectPlayer();
+    ~EffectPlayer();
+
+    EffectMixer _mixer;
+    Output* _output;
+    std::vector<Sound> _sounds;
+};
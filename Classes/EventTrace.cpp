@@ -0,0 +1,124 @@
+﻿#include "EventTrace.h"
+#include "AirHockeySim.h"
+#include <algorithm>
+
+#define TRACE_MAGIC "AHTR"
+#define TRACE_VERSION 1
+// the drain thread wakes up this often, the ring must hold the events of that long
+#define TRACE_DRAIN_INTERVAL_MS 20
+
+EventTrace::EventTrace()
+    : _head(0), _tail(0), _dropped(0), _stopping(false)
+{
+    _file = nullptr;
+    _mask = 0;
+}
+
+EventTrace::~EventTrace()
+{
+    close();
+}
+
+bool EventTrace::open(const std::string& path, unsigned int capacity)
+{
+    close();
+    _file = fopen(path.c_str(), "wb");
+    if (!_file)
+    {
+        return false;
+    }
+    uint32_t size = 1;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    _ring.assign(size, TraceEvent());
+    _mask = size - 1;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _dropped.store(0, std::memory_order_relaxed);
+    _stopping.store(false, std::memory_order_relaxed);
+    _start = std::chrono::steady_clock::now();
+
+    const uint32_t header[] = { TRACE_VERSION, sizeof(TraceEvent) };
+    fwrite(TRACE_MAGIC, 1, 4, _file);
+    fwrite(header, sizeof(header), 1, _file);
+
+    _drainer = std::thread(&EventTrace::drainLoop, this);
+    return true;
+}
+
+void EventTrace::close()
+{
+    if (!_file)
+    {
+        return;
+    }
+    _stopping.store(true, std::memory_order_release);
+    _drainer.join();
+    drain();
+    fclose(_file);
+    _file = nullptr;
+}
+
+bool EventTrace::push(TraceEvent event)
+{
+    if (!_file)
+    {
+        return false;
+    }
+    const auto head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) > _mask)
+    {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    event.timeUs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - _start).count());
+    _ring[head & _mask] = event;
+    // publish the event after it is written
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+const char* EventTrace::getEventName(uint32_t type)
+{
+    switch (type)
+    {
+    case SIM_EVENT_MALLET_HIT: return "mallet hit";
+    case SIM_EVENT_WALL_LEFT: return "left wall";
+    case SIM_EVENT_WALL_RIGHT: return "right wall";
+    case SIM_EVENT_WALL_BOTTOM: return "bottom wall";
+    case SIM_EVENT_WALL_TOP: return "top wall";
+    case SIM_EVENT_GOAL_PLAYER1: return "goal player 1";
+    case SIM_EVENT_GOAL_PLAYER2: return "goal player 2";
+    case SIM_EVENT_PUCK_HIT: return "puck hit";
+    default: return "unknown";
+    }
+}
+
+void EventTrace::drainLoop()
+{
+    while (!_stopping.load(std::memory_order_acquire))
+    {
+        drain();
+        std::this_thread::sleep_for(std::chrono::milliseconds(TRACE_DRAIN_INTERVAL_MS));
+    }
+}
+
+void EventTrace::drain()
+{
+    auto tail = _tail.load(std::memory_order_relaxed);
+    const auto head = _head.load(std::memory_order_acquire);
+    while (tail != head)
+    {
+        // write the contiguous part of the ring at once, the rest after it wraps
+        const auto index = tail & _mask;
+        const auto count = std::min(head - tail, static_cast<uint32_t>(_ring.size()) - index);
+        fwrite(&_ring[index], sizeof(TraceEvent), count, _file);
+        tail += count;
+        // give the slots back only once they are written
+        _tail.store(tail, std::memory_order_release);
+    }
+    fflush(_file);
+}
@@ -0,0 +1,85 @@
+﻿#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief One gameplay event, as it is stored in the ring and in the trace file
+ */
+struct TraceEvent
+{
+    // microseconds since EventTrace::open()
+    uint64_t timeUs;
+    uint32_t tick;
+    // one SimEvent flag
+    uint32_t type;
+    // puck after the tick
+    float x;
+    float y;
+    float vx;
+    float vy;
+    // change of the puck velocity during the tick, in points per second
+    float impulse;
+    // mallet that hit the puck, -1 for other events
+    int32_t mallet;
+};
+
+/**
+ * \brief Binary trace of gameplay events, written without blocking the game thread.
+ *
+ * push() copies the event into a fixed-size single producer, single consumer ring, without lock or
+ * allocation; a background thread drains the ring to the file. When the ring is full, events are
+ * dropped and counted rather than waiting for the disk.
+ * File: "AHTR", version, sizeof(TraceEvent) (uint32 each), then TraceEvent records. See
+ * MyGame_trace2json to view it in chrome://tracing.
+ */
+class EventTrace
+{
+public:
+    EventTrace();
+    ~EventTrace();
+
+    /**
+     * \param capacity Events the ring holds, rounded up to a power of 2
+     */
+    bool open(const std::string& path, unsigned int capacity);
+
+    /**
+     * \brief Write what is left in the ring and close the file
+     */
+    void close();
+
+    bool isOpen() const { return _file != nullptr; }
+
+    /**
+     * \brief Add an event, from the game thread only. timeUs is set here.
+     * \return false when the ring was full and the event dropped
+     */
+    bool push(TraceEvent event);
+
+    unsigned int getDroppedCount() const { return _dropped.load(std::memory_order_relaxed); }
+
+    /**
+     * \brief Readable name of a SimEvent flag
+     */
+    static const char* getEventName(uint32_t type);
+
+private:
+    void drainLoop();
+    void drain();
+
+    FILE* _file;
+    std::chrono::steady_clock::time_point _start;
+    std::vector<TraceEvent> _ring;
+    uint32_t _mask;
+    // _head is only written by push(), _tail only by the drain thread; both only grow
+    std::atomic<uint32_t> _head;
+    std::atomic<uint32_t> _tail;
+    std::atomic<unsigned int> _dropped;
+    std::atomic<bool> _stopping;
+    std::thread _drainer;
+};
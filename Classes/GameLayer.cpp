@@ -1,8 +1,26 @@
 ﻿#include "GameLayer.h"
-#include "SimpleAudioEngine.h"
+#include "EffectPlayer.h"
+#include <cfloat>
+#include <cmath>
 
-#define GOAL_LEFT 0.26f
-#define GOAL_RIGHT 0.74f
+// fastest the computer moves its mallet, in points per second
+#define CPU_MAX_SPEED 1500.0f
+// a frame longer than this is cut, so a hitch does not make the simulation spiral into catching up
+#define MAX_FRAME_TIME 0.25f
+// the last match is recorded here, in the writable path
+#define REPLAY_FILE "last_match.ahr"
+// a replay keyframe every 5 seconds, seeking simulates at most that much
+#define REPLAY_KEYFRAME_INTERVAL (5 * AirHockeySim::TICKS_PER_SECOND)
+// gameplay events of the last match are traced here, see MyGame_trace2json
+#define TRACE_FILE "last_match.aht"
+#define TRACE_CAPACITY 4096
+// a predicted touch goes at most this far ahead of the real one, in points
+#define MAX_TOUCH_PREDICTION 60.0f
+// once nothing has moved for this long, the Director draws a few frames a second until the next touch
+#define IDLE_DELAY 2.0f
+#define IDLE_FRAME_RATE 4.0f
+// a puck on the wall is quieter than a puck hit by a mallet
+#define WALL_HIT_VOLUME 0.5f
 
 GameLayer::GameLayer()
 {
@@ -12,12 +30,27 @@ GameLayer::GameLayer()
     _players = Vector<GameSprite*>();
     _player1ScoreLabel = nullptr;
     _player2ScoreLabel = nullptr;
-    _player1Score = 0;
-    _player2Score = 0;
+    _sim = AirHockeySim();
+    _previousSim = AirHockeySim();
+    for (auto& touchId : _malletTouches)
+    {
+        touchId = -1;
+    }
+    _accumulator = 0.0f;
+    _cpuEnabled = false;
+    _onlineEnabled = false;
+    _localInput = NetInput();
+    _touchPrediction = std::chrono::microseconds(0);
+    _pendingTouchCount = 0;
+    _updatedTouchCount = 0;
+    _restTime = 0.0f;
+    _hitSound = -1;
 }
 
 GameLayer::~GameLayer()
 {
+    _recorder.close();
+    _trace.close();
 }
 
 bool GameLayer::init()
@@ -26,15 +59,25 @@ bool GameLayer::init()
     {
         return false;
     }
-    _players = Vector<GameSprite*>(2);
-    _player1Score = 0;
-    _player2Score = 0;
+    _players = Vector<GameSprite*>(AirHockeySim::PLAYER_COUNT);
     _screenSize = Director::getInstance()->getWinSize();
     this->addBackgroud();
     this->addPlayers();
     this->addBall();
+    _sim.init(_screenSize.width, _screenSize.height, _player1->getRadius(), _ball->getRadius());
+    _previousSim = _sim;
+    if (!_recorder.open(FileUtils::getInstance()->getWritablePath() + REPLAY_FILE, REPLAY_KEYFRAME_INTERVAL))
+    {
+        CCLOG("Can not record the replay");
+    }
+    if (!_trace.open(FileUtils::getInstance()->getWritablePath() + TRACE_FILE, TRACE_CAPACITY))
+    {
+        CCLOG("Can not trace the events");
+    }
+    this->syncSprites(1.0f);
     this->addScoreLabels();
     this->addEventListener();
+    _hitSound = EffectPlayer::getInstance()->findSound("hit.wav");
     this->scheduleUpdate();
     return true;
 }
@@ -58,14 +101,21 @@ void GameLayer::onTouchesBegan(const std::vector<Touch*>& touches, Event* event)
     {
         if (touch)
         {
+            // only the mallet of the zone the touch lands in can be under it
             const auto tap = touch->getLocation();
-            for (auto player : _players)
+            const auto mallet = _sim.zoneAt(tap.x, tap.y);
+            // the computer does not let go of its mallet, and the other device plays its own
+            if (mallet < 0 || (_cpuEnabled && mallet == _cpu.getMalletIndex())
+                || (_onlineEnabled && mallet != _session.getLocalMallet()))
             {
-                if (player && player->getBoundingBox().containsPoint(tap))
-                {
-                    log("touch on player");
-                    player->setTouch(touch);
-                }
+                continue;
+            }
+            if (_players.at(mallet)->getBoundingBox().containsPoint(tap))
+            {
+                this->holdMallet(mallet, touch->getID());
+                auto& predictor = _touchPredictors[mallet];
+                predictor.reset();
+                predictor.addSample(tap.x, tap.y, touch->getTimestamp());
             }
         }
     }
@@ -77,33 +127,26 @@ void GameLayer::onTouchesMoved(const std::vector<Touch*>& touches, Event* event)
     {
         if (touch)
         {
+            // if this touch holds a mallet, the simulation moves the mallet toward it in the next update()
+            const auto held = _touchMallets.find(touch->getID());
+            if (held == _touchMallets.end())
+            {
+                continue;
+            }
+            const auto i = held->second;
             const auto tap = touch->getLocation();
-            for (auto player : _players)
+            auto targetX = tap.x;
+            auto targetY = tap.y;
+            _touchPredictors[i].addSample(tap.x, tap.y, touch->getTimestamp());
+            if (_touchPrediction.count() > 0)
             {
-                // if this touch belongs to the player who is holding touch
-                if (player && player->getTouch() == touch)
-                {
-                    // then, calculate the next position of the player
-                    // nextPosition will be used in update() to move the player
-                    auto nextPosition = tap;
-                    
-                    // keep nextPosition.x in range (minX, maxX)
-                    auto minX = player->getRadius();
-                    auto maxX = _screenSize.width - player->getRadius();
-                    nextPosition.x = nextPosition.x < minX ? minX : nextPosition.x;
-                    nextPosition.x = nextPosition.x > maxX ? maxX : nextPosition.x;
-
-                    // keep nextPosition.y in range (minY, maxY)
-                    const auto midY = _screenSize.height* 0.5f;
-                    auto minY = player->getPositionY() < midY ? player->getRadius() : midY + player->getRadius();
-                    auto maxY = player->getPositionY() < midY ? midY - player->getRadius() : _screenSize.height - player->getRadius();
-                    nextPosition.y = nextPosition.y < minY ? minY : nextPosition.y;
-                    nextPosition.y = nextPosition.y > maxY ? maxY : nextPosition.y;
-
-                    // update next position and moving vector of player
-                    player->setNextPosition(nextPosition);
-                    player->setMovingVector(Vec2(tap.x - player->getPositionX(), tap.y - player->getPositionY()));
-                }
+                _touchPredictors[i].predict(touch->getTimestamp() + _touchPrediction, MAX_TOUCH_PREDICTION,
+                    targetX, targetY);
+            }
+            this->applyMove(i, targetX, targetY);
+            if (_pendingTouchCount < MAX_TOUCH_SAMPLES)
+            {
+                _pendingTouchTimes[_pendingTouchCount++] = touch->getTimestamp();
             }
         }
     }
@@ -115,16 +158,12 @@ void GameLayer::onTouchesEnded(const std::vector<Touch*>& touches, Event* event)
     {
         if (touch)
         {
-            const auto tap = touch->getLocation();
-            for (auto player : _players)
+            const auto held = _touchMallets.find(touch->getID());
+            if (held != _touchMallets.end())
             {
-                // clear touch belongs to player
-                if (player && player->getTouch() == touch)
-                {
-                    player->setTouch(nullptr);
-                    player->setMovingVector(Vec2(0, 0));
-                    // no need to set nextPosition, it will be updated when we call setPosition()
-                }
+                const auto mallet = held->second;
+                this->dropTouch(mallet);
+                this->applyRelease(mallet);
             }
         }
     }
@@ -132,104 +171,283 @@ void GameLayer::onTouchesEnded(const std::vector<Touch*>& touches, Event* event)
 
 void GameLayer::update(float dt)
 {
-    // Range of position, keep the ball in this range
-    const auto minX = _ball->getRadius();
-    const auto maxX = _screenSize.width - _ball->getRadius();
-    const auto minY = _ball->getRadius();
-    const auto maxY = _screenSize.height - _ball->getRadius();
+    // the touches of this frame reach the simulation now, and the screen after the next draw
+    const auto now = std::chrono::steady_clock::now();
+    for (auto i = 0; i < _pendingTouchCount; ++i)
+    {
+        _touchToUpdateLatency.add(std::chrono::duration<float, std::milli>(now - _pendingTouchTimes[i]).count());
+        _updatedTouchTimes[i] = _pendingTouchTimes[i];
+    }
+    _updatedTouchCount = _pendingTouchCount;
+    _pendingTouchCount = 0;
+
+    if (_cpuEnabled)
+    {
+        CC_TELEMETRY_SCOPE("cpu think");
+        auto targetX = 0.0f;
+        auto targetY = 0.0f;
+        _cpu.think(_sim, dt, targetX, targetY);
+        this->applyMove(_cpu.getMalletIndex(), targetX, targetY);
+    }
 
-    // if the ball is in goal 1
-    if (this->isGoal())
+    unsigned char packet[RollbackSession::MAX_PACKET_SIZE];
+    if (_onlineEnabled)
     {
-        auto whichCourt = this->whichCourt();
-        if (whichCourt == 1)
+        size_t size = 0;
+        while ((size = _transport.receive(packet, sizeof(packet))) > 0)
+        {
+            _session.readPacket(packet, size);
+        }
+    }
+
+    // run as many fixed ticks as the frame took, the rest is carried to the next frame
+    _accumulator += dt < MAX_FRAME_TIME ? dt : MAX_FRAME_TIME;
+    const auto tickSeconds = AirHockeySim::tickSeconds();
+    auto events = static_cast<int>(SIM_EVENT_NONE);
+    auto scoresCorrected = false;
+    while (_accumulator >= tickSeconds)
+    {
+        CC_TELEMETRY_SCOPE("tick");
+        if (_onlineEnabled && !_session.canAdvance())
+        {
+            // the other device is too far behind, wait for it rather than predicting further
+            _previousSim = _sim;
+            _accumulator = 0.0f;
+            break;
+        }
+        _previousSim = _sim;
+        auto tickEvents = static_cast<int>(SIM_EVENT_NONE);
+        if (_onlineEnabled)
         {
-            CCLOG("GOAL for player 2");
-            this->increaseScore(2);
+            tickEvents = _session.advance(_localInput);
+            _localInput = NetInput();
+            _sim = _session.getState();
+            scoresCorrected = scoresCorrected || _session.areScoresCorrected();
         }
         else
         {
-            CCLOG("GOAL for player 1");
-            this->increaseScore(1);
+            _recorder.recordTick(_sim);
+            tickEvents = _sim.step();
         }
+        _accumulator -= tickSeconds;
+        if (tickEvents != SIM_EVENT_NONE)
+        {
+            this->traceEvents(tickEvents);
+        }
+        if (tickEvents & SIM_EVENT_GOAL)
+        {
+            // do not slide the sprites from the goal back to the kick-off positions
+            _previousSim = _sim;
+        }
+        events |= tickEvents;
+    }
+
+    if (events & SIM_EVENT_GOAL)
+    {
         this->resetGame();
-        return;
     }
+    else if (scoresCorrected)
+    {
+        // a predicted goal was not scored, the touches it dropped are not given back
+        this->updateScoreLabels();
+    }
+    // panned to the side of the table the puck is on
+    const auto pan = _sim.puck.x / _screenSize.width * 2.0f - 1.0f;
+    if (events & SIM_EVENT_MALLET_HIT)
+    {
+        EffectPlayer::getInstance()->play(_hitSound, 1.0f, pan);
+    }
+    if (events & SIM_EVENT_WALL)
+    {
+        EffectPlayer::getInstance()->play(_hitSound, WALL_HIT_VOLUME, pan);
+    }
+    EffectPlayer::getInstance()->collectLatency(_effectLatency);
 
-    auto ballNextPosition = _ball->getNextPosition();
-    auto ballMovingVector = _ball->getMovingVector();
-    //CCLOG("ballMovingVector: %f %f",ballMovingVector.x, ballMovingVector.y);
-    ballMovingVector *= 1.0f;
-    ballNextPosition.x += ballMovingVector.x;
-    ballNextPosition.y += ballMovingVector.y;
-
-    // check collision between ball and players
-    const auto sumSquareRadius = std::pow(_player1->getRadius() + _ball->getRadius(), 2);
-    for (auto player : _players)
-    {
-        auto playerNextPosition = player->getNextPosition();
-        auto playerMovingVector = player->getMovingVector();
-        auto dx = ballNextPosition.x - playerNextPosition.x;
-        auto dy = ballNextPosition.y - playerNextPosition.y;
-        auto dist = std::pow(dx, 2) + std::pow(dy, 2);
-        
-        if (dist <= sumSquareRadius)
+    if (_onlineEnabled)
+    {
+        _transport.send(packet, _session.writePacket(packet));
+    }
+
+    // draw the bodies between the last two ticks, by how far we are into the next tick
+    this->syncSprites(_accumulator / tickSeconds);
+
+    // touches wake the Director up themselves, this covers the table moving without one
+    auto director = Director::getInstance();
+    if (!this->isAtRest())
+    {
+        _restTime = 0.0f;
+        director->wakeUp();
+    }
+    else if (!director->isIdle())
+    {
+        _restTime += dt;
+        if (_restTime >= IDLE_DELAY)
         {
-            CCLOG("Collision: Player and Ball");
-            auto magBall = std::pow(ballMovingVector.x, 2) + std::pow(ballMovingVector.y, 2);
-            auto magPlayer = std::pow(playerMovingVector.x, 2) + std::pow(playerMovingVector.y, 2);
-            auto force = std::sqrt(magBall + magPlayer);
-            auto angle = std::atan2(dy, dx);
-            ballMovingVector.x = force * std::cos(angle);
-            ballMovingVector.y = force * std::sin(angle);
-            ballNextPosition.x = playerNextPosition.x + (player->getRadius() + _ball->getRadius() + force) * std::cos(angle);
-            ballNextPosition.y = playerNextPosition.y + (player->getRadius() + _ball->getRadius() + force) * std::sin(angle);
-            //CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("hit.wav");
+            director->requestFrameRate(IDLE_FRAME_RATE);
         }
     }
+}
 
-    // check collision between ball and walls
-    if (ballNextPosition.x < minX)
+bool GameLayer::isAtRest() const
+{
+    // the other device moves without touching this screen, the computer only moves while the puck or its
+    // mallet does, which the checks below see
+    if (_onlineEnabled)
     {
-        CCLOG("Collision: Ball and Left wall");
-        ballNextPosition.x = minX;
-        ballMovingVector.x *= -0.75f; // move back
-        //CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("hit.wav");
+        return false;
     }
-    else if (ballNextPosition.x > maxX)
+    if (_sim.puck.vx != 0.0f || _sim.puck.vy != 0.0f)
     {
-        CCLOG("Collision: Ball and Right wall");
-        ballNextPosition.x = maxX;
-        ballMovingVector.x *= -0.75f; // move back
-        //CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("hit.wav");
+        return false;
     }
-    else if (ballNextPosition.y < minY)
+    for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
     {
-        CCLOG("Collision: Ball and Bot wall");
-        ballNextPosition.y = minY;
-        ballMovingVector.y *= -0.75f; // move back
-        //CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("hit.wav");
+        const auto& mallet = _sim.mallets[i];
+        if (_malletTouches[i] >= 0 || mallet.vx != 0.0f || mallet.vy != 0.0f
+            || mallet.nextX != mallet.x || mallet.nextY != mallet.y)
+        {
+            return false;
+        }
     }
-    else if (ballNextPosition.y > maxY)
+    // the sprites are still catching up with the last tick
+    return _previousSim.puck.x == _sim.puck.x && _previousSim.puck.y == _sim.puck.y;
+}
+
+void GameLayer::traceEvents(int tickEvents)
+{
+    // a goal already put the puck back at kick-off, trace where it went in
+    const auto& puck = (tickEvents & SIM_EVENT_GOAL) ? _previousSim.puck : _sim.puck;
+    const auto dvx = _sim.puck.vx - _previousSim.puck.vx;
+    const auto dvy = _sim.puck.vy - _previousSim.puck.vy;
+    TraceEvent event;
+    event.tick = _previousSim.tick;
+    event.x = puck.x;
+    event.y = puck.y;
+    event.vx = _sim.puck.vx;
+    event.vy = _sim.puck.vy;
+    event.impulse = std::sqrt(dvx * dvx + dvy * dvy);
+    for (auto flags = tickEvents; flags != 0; flags &= flags - 1)
     {
-        CCLOG("Collision: Ball and Top wall");
-        ballNextPosition.y = maxY;
-        ballMovingVector.y *= -0.75f; // move back
-        //CocosDenshion::SimpleAudioEngine::getInstance()->playEffect("hit.wav");
+        event.type = flags & -flags;
+        event.mallet = -1;
+        if (event.type == SIM_EVENT_MALLET_HIT)
+        {
+            // the mallet that hit is the one touching the puck
+            auto nearest = FLT_MAX;
+            for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+            {
+                const auto dx = _sim.mallets[i].x - puck.x;
+                const auto dy = _sim.mallets[i].y - puck.y;
+                if (dx * dx + dy * dy < nearest)
+                {
+                    nearest = dx * dx + dy * dy;
+                    event.mallet = i;
+                }
+            }
+        }
+        _trace.push(event);
     }
+}
+
+void GameLayer::setTouchPrediction(float horizonMilliseconds)
+{
+    _touchPrediction = std::chrono::microseconds(static_cast<long long>(horizonMilliseconds * 1000.0f));
+}
+
+void GameLayer::resetInputLatency()
+{
+    _touchToUpdateLatency.reset();
+    _touchToDrawLatency.reset();
+}
 
-    _ball->setMovingVector(ballMovingVector);
-    _ball->setNextPosition(ballNextPosition);
+void GameLayer::onAfterDraw()
+{
+    const auto now = std::chrono::steady_clock::now();
+    for (auto i = 0; i < _updatedTouchCount; ++i)
+    {
+        _touchToDrawLatency.add(std::chrono::duration<float, std::milli>(now - _updatedTouchTimes[i]).count());
+    }
+    _updatedTouchCount = 0;
+}
 
-    // move players
-    _player1->setPosition(_player1->getNextPosition());
-    _player2->setPosition(_player2->getNextPosition());
-    _ball->setPosition(_ball->getNextPosition());
+void GameLayer::applyMove(int mallet, float tapX, float tapY)
+{
+    if (_onlineEnabled)
+    {
+        // the session applies it at the next tick, on both devices
+        _localInput.type = NetInput::MOVE;
+        _localInput.x = tapX;
+        _localInput.y = tapY;
+        return;
+    }
+    _recorder.recordMove(_sim.tick, mallet, tapX, tapY);
+    _sim.moveMallet(mallet, tapX, tapY);
+}
+
+void GameLayer::applyRelease(int mallet)
+{
+    if (_onlineEnabled)
+    {
+        _localInput = NetInput();
+        _localInput.type = NetInput::RELEASE;
+        return;
+    }
+    _recorder.recordRelease(_sim.tick, mallet);
+    _sim.releaseMallet(mallet);
+}
+
+void GameLayer::holdMallet(int mallet, int touchId)
+{
+    // a touch id is reused once released, and a new finger takes the mallet over from a lost one
+    const auto held = _touchMallets.find(touchId);
+    if (held != _touchMallets.end())
+    {
+        _malletTouches[held->second] = -1;
+    }
+    this->dropTouch(mallet);
+    _touchMallets[touchId] = mallet;
+    _malletTouches[mallet] = touchId;
+}
+
+void GameLayer::dropTouch(int mallet)
+{
+    if (_malletTouches[mallet] >= 0)
+    {
+        _touchMallets.erase(_malletTouches[mallet]);
+        _malletTouches[mallet] = -1;
+    }
+}
+
+void GameLayer::enableCpuPlayer(int budgetMicroseconds)
+{
+    _cpu.init(1, budgetMicroseconds, CPU_MAX_SPEED);
+    _cpuEnabled = true;
+    this->dropTouch(_cpu.getMalletIndex());
+}
+
+bool GameLayer::enableOnlinePlay(int localMallet, unsigned short localPort, const std::string& remoteHost, unsigned short remotePort)
+{
+    if (!_transport.open(localPort) || !_transport.setRemote(remoteHost, remotePort))
+    {
+        CCLOG("Can not reach %s:%d", remoteHost.c_str(), remotePort);
+        _transport.close();
+        return false;
+    }
+    // the replay only knows local inputs, online matches are not recorded
+    _recorder.close();
+    _cpuEnabled = false;
+    _session.init(_sim, localMallet);
+    _onlineEnabled = true;
+    _localInput = NetInput();
+    this->dropTouch(1 - localMallet);
+    return true;
 }
 
 void GameLayer::addBackgroud()
 {
-    auto background = Sprite::create("court.png");
+    // no-op when the loading screen already added the frames
+    SpriteFrameCache::getInstance()->addSpriteFramesWithFile(TABLE_SPRITE_SHEET);
+    auto background = GameSprite::createWithSpriteFrameName("court.png");
     background->setPosition(Vec2(_screenSize.width * 0.5f, _screenSize.height * 0.5f));
     background->setScaleX(_screenSize.width / background->getContentSize().width);
     background->setScaleY(_screenSize.height / background->getContentSize().height);
@@ -238,15 +456,13 @@ void GameLayer::addBackgroud()
 
 void GameLayer::addPlayers()
 {
-    _player1 = GameSprite::createWithFile("mallet.png");
-    _player1->setPosition(Vec2(_screenSize.width * 0.5f, _player1->getRadius()));
+    _player1 = GameSprite::createWithSpriteFrameName("mallet.png");
     _player1->setAnchorPoint(Vec2(0.5f, 0.5f));
     _player1->setIgnoreAnchorPointForPosition(false);
     _players.pushBack(_player1);
     this->addChild(_player1, 0, "Player1");
 
-    _player2 = GameSprite::createWithFile("mallet.png");
-    _player2->setPosition(Vec2(_screenSize.width * 0.5f, _screenSize.height -_player2->getRadius()));
+    _player2 = GameSprite::createWithSpriteFrameName("mallet.png");
     _player2->setAnchorPoint(Vec2(0.5f, 0.5f));
     _player2->setIgnoreAnchorPointForPosition(false);
     _players.pushBack(_player2);
@@ -255,8 +471,7 @@ void GameLayer::addPlayers()
 
 void GameLayer::addBall()
 {
-    _ball = GameSprite::createWithFile("puck.png");
-    _ball->setPosition(Vec2(_screenSize.width * 0.5, _screenSize.height * 0.5));
+    _ball = GameSprite::createWithSpriteFrameName("puck.png");
     this->addChild(_ball, 0, "Ball");
 }
 
@@ -279,52 +494,42 @@ void GameLayer::addEventListener()
     listener->onTouchesBegan = CC_CALLBACK_2(GameLayer::onTouchesBegan, this);
     listener->onTouchesMoved = CC_CALLBACK_2(GameLayer::onTouchesMoved, this);
     listener->onTouchesEnded = CC_CALLBACK_2(GameLayer::onTouchesEnded, this);
+    // a cancelled touch would otherwise keep its mallet
+    listener->onTouchesCancelled = CC_CALLBACK_2(GameLayer::onTouchesEnded, this);
     _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
-}
 
-bool GameLayer::isGoal() const
-{
-    const auto minX = _screenSize.width * GOAL_LEFT;
-    const auto maxX = _screenSize.width * GOAL_RIGHT;
-    const auto minY = _ball->getRadius();
-    const auto maxY = _screenSize.height - _ball->getRadius();
-    const auto x = _ball->getPositionX();
-    const auto y = _ball->getPositionY();
-    const auto inLine = y <= minY || y >= maxY;
-    const auto inRangeX = x >= minX && x <= maxX;
-    return inLine && inRangeX;
+    auto drawListener = EventListenerCustom::create(Director::EVENT_AFTER_DRAW, [this](EventCustom*)
+    {
+        this->onAfterDraw();
+    });
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(drawListener, this);
 }
 
-
-int GameLayer::whichCourt() const
+void GameLayer::syncSprites(float alpha)
 {
-    return _ball->getPositionY() <= _screenSize.height * 0.5 ? 1 : 2;
+    const auto lerp = [alpha](const SimBody& from, const SimBody& to)
+    {
+        return Vec2(from.x + (to.x - from.x) * alpha, from.y + (to.y - from.y) * alpha);
+    };
+    for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+    {
+        _players.at(i)->setPosition(lerp(_previousSim.mallets[i], _sim.mallets[i]));
+    }
+    _ball->setPosition(lerp(_previousSim.puck, _sim.puck));
 }
 
 void GameLayer::resetGame()
 {
-    _player1->setPosition(Vec2(_screenSize.width * 0.5f, 0));
-    _player1->setTouch(nullptr);
-    _player1->setMovingVector(Vec2());
-
-    _player2->setPosition(Vec2(_screenSize.width * 0.5f, _screenSize.height));
-    _player2->setTouch(nullptr);
-    _player2->setMovingVector(Vec2());
-
-    _ball->setPosition(Vec2(_screenSize.width * 0.5f, _screenSize.height * 0.5f));
-    _ball->setMovingVector(Vec2());
+    // the simulation already put the bodies back, only the touches are left to release
+    for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+    {
+        this->dropTouch(i);
+    }
+    this->updateScoreLabels();
 }
 
-void GameLayer::increaseScore(int whichplayer)
+void GameLayer::updateScoreLabels()
 {
-    if (whichplayer == 1)
-    {
-        _player1Score++;
-        _player1ScoreLabel->setString(std::to_string(_player1Score));
-    }
-    else
-    {
-        _player2Score++;
-        _player2ScoreLabel->setString(std::to_string(_player2Score));
-    }
+    _player1ScoreLabel->setString(std::to_string(_sim.scores[0]));
+    _player2ScoreLabel->setString(std::to_string(_sim.scores[1]));
 }
@@ -1,21 +1,59 @@
 ﻿#pragma once
 #include "cocos2d.h"
 #include "GameSprite.h"
+#include "AirHockeySim.h"
+#include "CpuPlayer.h"
+#include "EventTrace.h"
+#include "LatencyHistogram.h"
+#include "Replay.h"
+#include "RollbackSession.h"
+#include "TouchPredictor.h"
+#include "UdpTransport.h"
+#include <unordered_map>
 
 using namespace cocos2d;
 
 class GameLayer : public cocos2d::Layer
 {
 private:
+    // touch samples measured per frame, more in one frame are not measured
+    static const int MAX_TOUCH_SAMPLES = 16;
+
     GameSprite* _player1;
     GameSprite* _player2;
     GameSprite* _ball;
     cocos2d::Vector<GameSprite*> _players;
-    int _player1Score;
-    int _player2Score;
     Label* _player1ScoreLabel;
     Label* _player2ScoreLabel;
     Size _screenSize;
+    AirHockeySim _sim;
+    AirHockeySim _previousSim;
+    // which mallet each touch id holds, and the touch id holding each mallet (-1 for none)
+    std::unordered_map<int, int> _touchMallets;
+    int _malletTouches[AirHockeySim::PLAYER_COUNT];
+    float _accumulator;
+    CpuPlayer _cpu;
+    bool _cpuEnabled;
+    ReplayRecorder _recorder;
+    EventTrace _trace;
+    RollbackSession _session;
+    UdpTransport _transport;
+    bool _onlineEnabled;
+    // what the local player did since the last tick, sent with the next one
+    NetInput _localInput;
+    TouchPredictor _touchPredictors[AirHockeySim::PLAYER_COUNT];
+    std::chrono::microseconds _touchPrediction;
+    // touches received since the last update(), and touches of the last update() not drawn yet
+    std::chrono::steady_clock::time_point _pendingTouchTimes[MAX_TOUCH_SAMPLES];
+    int _pendingTouchCount;
+    std::chrono::steady_clock::time_point _updatedTouchTimes[MAX_TOUCH_SAMPLES];
+    int _updatedTouchCount;
+    LatencyHistogram _touchToUpdateLatency;
+    LatencyHistogram _touchToDrawLatency;
+    int _hitSound;
+    LatencyHistogram _effectLatency;
+    // how long nothing has moved on the table
+    float _restTime;
 
 public:
     GameLayer();
@@ -26,13 +64,71 @@ public:
     void onTouchesMoved(const std::vector<Touch*>& touches, Event* event) override;
     void onTouchesEnded(const std::vector<Touch*>& touches, Event* event) override;
     void update(float dt) override;
+
+    /**
+     * \brief Let the computer play player 2, planning at most budgetMicroseconds per frame
+     */
+    void enableCpuPlayer(int budgetMicroseconds);
+
+    /**
+     * \brief Play against another device, this one plays localMallet and the other device the other mallet.
+     * Both devices must start the match at the same time, with the same table size.
+     */
+    bool enableOnlinePlay(int localMallet, unsigned short localPort, const std::string& remoteHost, unsigned short remotePort);
+
+    /**
+     * \brief Move the mallets to where the fingers are expected horizonMilliseconds after their last sample,
+     * 0 to follow the samples
+     */
+    void setTouchPrediction(float horizonMilliseconds);
+
+    /**
+     * \brief Time from GLView receiving a touch sample to the update() that applies it
+     */
+    const LatencyHistogram& getTouchToUpdateLatency() const { return _touchToUpdateLatency; }
+
+    /**
+     * \brief Time from GLView receiving a touch sample to the end of the draw that shows it; the display
+     * adds its own swap and scan-out time on top of this
+     */
+    const LatencyHistogram& getInputLatency() const { return _touchToDrawLatency; }
+
+    void resetInputLatency();
+
+    /**
+     * \brief Time from a collision to its sound leaving the audio output's buffers
+     */
+    const LatencyHistogram& getEffectLatency() const { return _effectLatency; }
+
     void addBackgroud();
     void addPlayers();
     void addBall();
     void addScoreLabels();
     void addEventListener();
-    bool isGoal() const;
-    int whichCourt() const;
+    void syncSprites(float alpha);
+
+    /**
+     * \brief Nothing moves on the table and nothing will until the next touch
+     */
+    bool isAtRest() const;
+
+    /**
+     * \brief Trace the events of the tick that just ran, _previousSim holds the match before it
+     */
+    void traceEvents(int tickEvents);
+    void onAfterDraw();
+
+    /**
+     * \brief Move or release a mallet in the simulation and record it in the replay
+     */
+    void applyMove(int mallet, float tapX, float tapY);
+    void applyRelease(int mallet);
+
+    /**
+     * \brief Give a mallet to a touch, or forget the touch on a mallet; the simulation is not told
+     */
+    void holdMallet(int mallet, int touchId);
+    void dropTouch(int mallet);
     void resetGame();
-    void increaseScore(int whichplayer);
+    void updateScoreLabels();
 };
@@ -2,9 +2,6 @@
 
 GameSprite::GameSprite()
 {
-    _nextPosition = Vec2(0.0f, 0.0f);
-    _movingVector = Vec2(0.0f, 0.0f);
-    _touch = nullptr;
 }
 
 GameSprite::~GameSprite()
@@ -23,17 +20,27 @@ GameSprite* GameSprite::createWithFile(const char* fileName)
     return sprite = nullptr;
 }
 
-void GameSprite::setPosition(const Vec2& position)
+GameSprite* GameSprite::createWithSpriteFrameName(const char* frameName)
 {
-    Sprite::setPosition(position);
-    if(!_nextPosition.equals(position))
+    auto sprite = new(std::nothrow) GameSprite();
+    if (sprite && sprite->initWithSpriteFrameName(frameName))
     {
-        _nextPosition = position;
+        // a texture cooked to ETC1 keeps its alpha in a second texture
+        if (sprite->getTexture()->getAlphaTexture())
+        {
+            sprite->setGLProgramState(GLProgramState::getOrCreateWithGLProgramName(
+                GLProgram::SHADER_NAME_ETC1AS_POSITION_TEXTURE_COLOR_NO_MVP, sprite->getTexture()));
+        }
+        sprite->autorelease();
+        return sprite;
     }
+    CC_SAFE_DELETE(sprite);
+    return sprite = nullptr;
 }
 
 float GameSprite::getRadius() const
 {
-    return this->getTexture()->getContentSize().width * 0.5f;
+    // not the texture's, it holds the whole sprite sheet
+    return this->getContentSize().width * 0.5f;
 }
 
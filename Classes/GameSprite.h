@@ -3,26 +3,21 @@
 
 using namespace cocos2d;
 
+// the court, mallet and puck frames, packed in one texture by MyGame_atlaspack so the table draws in one batch
+#define TABLE_SPRITE_SHEET "table.plist"
+#define TABLE_TEXTURE "table.png"
+
 class GameSprite : public Sprite
 {
 public:
-    // this sprite will move to nextPosition in update())
-    CC_SYNTHESIZE(Vec2, _nextPosition, NextPosition);
-
-    // this sprite will move by this vector
-    CC_SYNTHESIZE(Vec2, _movingVector, MovingVector);
-
-    // holds the touch on this sprite
-    CC_SYNTHESIZE(Touch*, _touch, Touch); 
-
     GameSprite();
     virtual ~GameSprite();
     static GameSprite* createWithFile(const char* fileName);
-    void setPosition(const Vec2& position) override;
+    static GameSprite* createWithSpriteFrameName(const char* frameName);
 
     /**
      * \brief Get radius of this sprite
-     * \return Radius = 1/2 width
+     * \return Radius = 1/2 width of the frame
      */
     float getRadius() const;
 };
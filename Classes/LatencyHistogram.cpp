@@ -0,0 +1,51 @@
+﻿#include "LatencyHistogram.h"
+
+constexpr float LatencyHistogram::BUCKET_MS;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::add(float milliseconds)
+{
+    auto index = milliseconds > 0.0f ? static_cast<int>(milliseconds / BUCKET_MS) : 0;
+    if (index >= BUCKET_COUNT)
+    {
+        index = BUCKET_COUNT - 1;
+    }
+    ++_buckets[index];
+    ++_count;
+    _sum += milliseconds;
+    if (milliseconds > _max)
+    {
+        _max = milliseconds;
+    }
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto i = 0; i < BUCKET_COUNT; ++i)
+    {
+        _buckets[i] = 0;
+    }
+    _count = 0;
+    _sum = 0.0;
+    _max = 0.0f;
+}
+
+float LatencyHistogram::getPercentile(float fraction) const
+{
+    const auto target = static_cast<unsigned int>(fraction * _count);
+    auto seen = 0u;
+    for (auto i = 0; i < BUCKET_COUNT - 1; ++i)
+    {
+        seen += _buckets[i];
+        if (seen > target)
+        {
+            const auto bound = (i + 1) * BUCKET_MS;
+            return bound < _max ? bound : _max;
+        }
+    }
+    return _max;
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+/**
+ * \brief Distribution of latency samples in fixed buckets of BUCKET_MS, no allocation when adding.
+ *
+ * Samples over the last bucket are counted in it, getMax() still has their real value.
+ */
+class LatencyHistogram
+{
+public:
+    static const int BUCKET_COUNT = 100;
+    static constexpr float BUCKET_MS = 0.5f;
+
+    LatencyHistogram();
+
+    void add(float milliseconds);
+    void reset();
+
+    unsigned int getCount() const { return _count; }
+    unsigned int getBucket(int index) const { return _buckets[index]; }
+    float getMax() const { return _max; }
+    float getMean() const { return _count > 0 ? static_cast<float>(_sum / _count) : 0.0f; }
+
+    /**
+     * \brief Upper bound of the bucket that holds the given fraction of the samples, e.g. 0.99f
+     */
+    float getPercentile(float fraction) const;
+
+private:
+    unsigned int _buckets[BUCKET_COUNT];
+    unsigned int _count;
+    double _sum;
+    float _max;
+};
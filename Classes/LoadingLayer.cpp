@@ -0,0 +1,100 @@
+﻿#include "LoadingLayer.h"
+
+// time the GL thread spends on uploads per frame, the splash keeps its frame rate
+#define UPLOAD_BUDGET std::chrono::microseconds(4000)
+#define PROGRESS_BAR_WIDTH 0.6f
+#define PROGRESS_BAR_HEIGHT 12.0f
+
+float LoadingLayer::s_timeToFirstFrame = 0.0f;
+
+LoadingLayer::LoadingLayer()
+{
+    _progressBar = nullptr;
+    _done = false;
+}
+
+LoadingLayer::~LoadingLayer()
+{
+}
+
+bool LoadingLayer::init(std::chrono::steady_clock::time_point launchTime, const std::function<Scene*()>& createNextScene)
+{
+    // no asset is loaded yet, the splash is drawn with primitives only
+    if (!LayerColor::initWithColor(Color4B(16, 32, 48, 255)))
+    {
+        return false;
+    }
+    _launchTime = launchTime;
+    _createNextScene = createNextScene;
+    _progressBar = DrawNode::create();
+    this->addChild(_progressBar, 0, "ProgressBar");
+    this->drawProgress();
+    return true;
+}
+
+LoadingLayer* LoadingLayer::create(std::chrono::steady_clock::time_point launchTime, const std::function<Scene*()>& createNextScene)
+{
+    auto layer = new(std::nothrow) LoadingLayer();
+    if (layer && layer->init(launchTime, createNextScene))
+    {
+        layer->autorelease();
+        return layer;
+    }
+    delete layer;
+    layer = nullptr;
+    return nullptr;
+}
+
+void LoadingLayer::onEnter()
+{
+    LayerColor::onEnter();
+    _loader.start(0);
+    this->scheduleUpdate();
+}
+
+void LoadingLayer::update(float dt)
+{
+    if (_done)
+    {
+        return;
+    }
+    _done = _loader.update(UPLOAD_BUDGET);
+    this->drawProgress();
+    if (!_done)
+    {
+        return;
+    }
+
+    log("assets: %d decoded in %.1f ms, loaded in %.1f ms", _loader.getAssetCount(),
+        _loader.getDecodeMilliseconds(), _loader.getLoadMilliseconds());
+    auto scene = _createNextScene();
+    auto director = Director::getInstance();
+    director->replaceScene(scene);
+
+    // this layer is gone when the game scene is drawn, the listener only keeps what it needs
+    const auto launchTime = _launchTime;
+    auto dispatcher = director->getEventDispatcher();
+    auto listener = std::make_shared<EventListenerCustom*>(nullptr);
+    *listener = dispatcher->addCustomEventListener(Director::EVENT_AFTER_DRAW, [scene, launchTime, dispatcher, listener](EventCustom*)
+    {
+        if (Director::getInstance()->getRunningScene() != scene)
+        {
+            return;
+        }
+        s_timeToFirstFrame = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - launchTime).count();
+        log("time to first interactive frame: %.1f ms", s_timeToFirstFrame);
+        dispatcher->removeEventListener(*listener);
+    });
+}
+
+void LoadingLayer::drawProgress()
+{
+    const auto size = this->getContentSize();
+    const auto width = size.width * PROGRESS_BAR_WIDTH;
+    const auto origin = Vec2((size.width - width) * 0.5f, (size.height - PROGRESS_BAR_HEIGHT) * 0.5f);
+    const auto progress = _loader.getAssetCount() > 0
+        ? static_cast<float>(_loader.getLoadedCount()) / _loader.getAssetCount() : 1.0f;
+    _progressBar->clear();
+    _progressBar->drawSolidRect(origin, origin + Vec2(width, PROGRESS_BAR_HEIGHT), Color4F(1.0f, 1.0f, 1.0f, 0.2f));
+    _progressBar->drawSolidRect(origin, origin + Vec2(width * progress, PROGRESS_BAR_HEIGHT), Color4F::WHITE);
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+#include "cocos2d.h"
+#include "AssetLoader.h"
+#include <chrono>
+#include <functional>
+
+using namespace cocos2d;
+
+/**
+ * \brief Splash screen drawn while an AssetLoader loads the assets, then replaced by the game scene.
+ *
+ * It reports the time from launch to the end of the first frame of the game scene.
+ */
+class LoadingLayer : public cocos2d::LayerColor
+{
+private:
+    AssetLoader _loader;
+    std::function<Scene*()> _createNextScene;
+    std::chrono::steady_clock::time_point _launchTime;
+    DrawNode* _progressBar;
+    bool _done;
+
+    static float s_timeToFirstFrame;
+
+public:
+    LoadingLayer();
+    virtual ~LoadingLayer();
+    bool init(std::chrono::steady_clock::time_point launchTime, const std::function<Scene*()>& createNextScene);
+
+    /**
+     * \param launchTime Start of the time to first frame
+     * \param createNextScene Called once every asset is loaded
+     */
+    static LoadingLayer* create(std::chrono::steady_clock::time_point launchTime, const std::function<Scene*()>& createNextScene);
+
+    /**
+     * \brief Add the assets to it before the layer enters the stage
+     */
+    AssetLoader& getLoader() { return _loader; }
+
+    void onEnter() override;
+    void update(float dt) override;
+    void drawProgress();
+
+    /**
+     * \brief Milliseconds from launch to the end of the first frame that can take input, 0 until it is drawn
+     */
+    static float getTimeToFirstFrame() { return s_timeToFirstFrame; }
+};
@@ -0,0 +1,240 @@
+﻿#include "PartyLayer.h"
+
+// a frame longer than this is cut, so a hitch does not make the simulation spiral into catching up
+#define MAX_FRAME_TIME 0.25f
+// party pucks are smaller than the puck of a normal match
+#define BALL_SCALE 0.5f
+
+PartyLayer::PartyLayer()
+{
+    _players = Vector<GameSprite*>();
+    _balls = Vector<GameSprite*>();
+    _player1ScoreLabel = nullptr;
+    _player2ScoreLabel = nullptr;
+    _accumulator = 0.0f;
+    _ballCount = 0;
+    _playerCount = 0;
+}
+
+PartyLayer::~PartyLayer()
+{
+}
+
+bool PartyLayer::init(int ballCount, int playerCount, int zoneColumns)
+{
+    if (!Layer::init())
+    {
+        return false;
+    }
+    // the radii of the simulation come from the first ball and player sprites
+    if (ballCount <= 0 || playerCount <= 0)
+    {
+        CCLOG("PartyLayer needs at least one ball and one player, not %d and %d", ballCount, playerCount);
+        return false;
+    }
+    _ballCount = ballCount;
+    _playerCount = playerCount;
+    _players = Vector<GameSprite*>(playerCount);
+    _balls = Vector<GameSprite*>(ballCount);
+    _screenSize = Director::getInstance()->getWinSize();
+    this->addBackgroud();
+    this->addPlayers();
+    this->addBalls();
+    _sim.init(_screenSize.width, _screenSize.height, ballCount, _balls.at(0)->getRadius() * BALL_SCALE,
+        playerCount, _players.at(0)->getRadius(), zoneColumns);
+    _zonePlayers.assign(_sim.zones.size(), std::vector<int>());
+    for (auto i = 0; i < playerCount; ++i)
+    {
+        _zonePlayers[_sim.malletZones[i]].push_back(i);
+    }
+    _playerTouches.assign(playerCount, -1);
+    _previousBallX = _sim.puckX;
+    _previousBallY = _sim.puckY;
+    _previousPlayerX = _sim.malletX;
+    _previousPlayerY = _sim.malletY;
+    this->syncSprites(1.0f);
+    this->addScoreLabels();
+    this->addEventListener();
+    this->scheduleUpdate();
+    return true;
+}
+
+PartyLayer* PartyLayer::create(int ballCount, int playerCount, int zoneColumns)
+{
+    auto layer = new(std::nothrow) PartyLayer();
+    if (layer && layer->init(ballCount, playerCount, zoneColumns))
+    {
+        layer->autorelease();
+        return layer;
+    }
+    delete layer;
+    layer = nullptr;
+    return nullptr;
+}
+
+void PartyLayer::onTouchesBegan(const std::vector<Touch*>& touches, Event* event)
+{
+    for (auto touch : touches)
+    {
+        if (touch)
+        {
+            const auto tap = touch->getLocation();
+            const auto zone = _sim.zoneAt(tap.x, tap.y);
+            if (zone < 0)
+            {
+                continue;
+            }
+            for (auto i : _zonePlayers[zone])
+            {
+                if (_playerTouches[i] < 0 && _players.at(i)->getBoundingBox().containsPoint(tap))
+                {
+                    this->holdPlayer(i, touch->getID());
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void PartyLayer::onTouchesMoved(const std::vector<Touch*>& touches, Event* event)
+{
+    for (auto touch : touches)
+    {
+        if (touch)
+        {
+            const auto held = _touchPlayers.find(touch->getID());
+            if (held != _touchPlayers.end())
+            {
+                const auto tap = touch->getLocation();
+                _sim.moveMallet(held->second, tap.x, tap.y);
+            }
+        }
+    }
+}
+
+void PartyLayer::onTouchesEnded(const std::vector<Touch*>& touches, Event* event)
+{
+    for (auto touch : touches)
+    {
+        if (touch)
+        {
+            const auto held = _touchPlayers.find(touch->getID());
+            if (held != _touchPlayers.end())
+            {
+                _playerTouches[held->second] = -1;
+                _sim.releaseMallet(held->second);
+                _touchPlayers.erase(held);
+            }
+        }
+    }
+}
+
+void PartyLayer::update(float dt)
+{
+    _accumulator += dt < MAX_FRAME_TIME ? dt : MAX_FRAME_TIME;
+    const auto tickSeconds = AirHockeySim::tickSeconds();
+    auto events = static_cast<int>(SIM_EVENT_NONE);
+    while (_accumulator >= tickSeconds)
+    {
+        _previousBallX = _sim.puckX;
+        _previousBallY = _sim.puckY;
+        _previousPlayerX = _sim.malletX;
+        _previousPlayerY = _sim.malletY;
+        events |= _sim.step();
+        _accumulator -= tickSeconds;
+    }
+
+    if (events & SIM_EVENT_GOAL)
+    {
+        this->updateScoreLabels();
+    }
+    this->syncSprites(_accumulator / tickSeconds);
+}
+
+void PartyLayer::addBackgroud()
+{
+    // no-op when the loading screen already added the frames
+    SpriteFrameCache::getInstance()->addSpriteFramesWithFile(TABLE_SPRITE_SHEET);
+    auto background = GameSprite::createWithSpriteFrameName("court.png");
+    background->setPosition(Vec2(_screenSize.width * 0.5f, _screenSize.height * 0.5f));
+    background->setScaleX(_screenSize.width / background->getContentSize().width);
+    background->setScaleY(_screenSize.height / background->getContentSize().height);
+    this->addChild(background, 0, "Background");
+}
+
+void PartyLayer::addPlayers()
+{
+    for (auto i = 0; i < _playerCount; ++i)
+    {
+        auto player = GameSprite::createWithSpriteFrameName("mallet.png");
+        _players.pushBack(player);
+        this->addChild(player, 0, "Player" + std::to_string(i + 1));
+    }
+}
+
+void PartyLayer::addBalls()
+{
+    for (auto i = 0; i < _ballCount; ++i)
+    {
+        auto ball = GameSprite::createWithSpriteFrameName("puck.png");
+        ball->setScale(BALL_SCALE);
+        _balls.pushBack(ball);
+        this->addChild(ball, 0);
+    }
+}
+
+void PartyLayer::addScoreLabels()
+{
+    _player1ScoreLabel = Label::createWithTTF("0", "fonts/Arial.ttf", 60);
+    _player1ScoreLabel->setPosition(Vec2(_screenSize.width - 60, _screenSize.height * 0.5f - 80));
+    _player1ScoreLabel->setRotation(90);
+    this->addChild(_player1ScoreLabel, 0, "Player1ScoreLabel");
+
+    _player2ScoreLabel = Label::createWithTTF("0", "fonts/Arial.ttf", 60);
+    _player2ScoreLabel->setPosition(Vec2(_screenSize.width - 60, _screenSize.height * 0.5f + 80));
+    _player2ScoreLabel->setRotation(90);
+    this->addChild(_player2ScoreLabel, 0, "Player2ScoreLabel");
+}
+
+void PartyLayer::addEventListener()
+{
+    auto listener = EventListenerTouchAllAtOnce::create();
+    listener->onTouchesBegan = CC_CALLBACK_2(PartyLayer::onTouchesBegan, this);
+    listener->onTouchesMoved = CC_CALLBACK_2(PartyLayer::onTouchesMoved, this);
+    listener->onTouchesEnded = CC_CALLBACK_2(PartyLayer::onTouchesEnded, this);
+    // a cancelled touch would otherwise keep its mallet
+    listener->onTouchesCancelled = CC_CALLBACK_2(PartyLayer::onTouchesEnded, this);
+    _eventDispatcher->addEventListenerWithSceneGraphPriority(listener, this);
+}
+
+void PartyLayer::syncSprites(float alpha)
+{
+    for (auto i = 0; i < _playerCount; ++i)
+    {
+        _players.at(i)->setPosition(Vec2(_previousPlayerX[i] + (_sim.malletX[i] - _previousPlayerX[i]) * alpha,
+            _previousPlayerY[i] + (_sim.malletY[i] - _previousPlayerY[i]) * alpha));
+    }
+    for (auto i = 0; i < _ballCount; ++i)
+    {
+        _balls.at(i)->setPosition(Vec2(_previousBallX[i] + (_sim.puckX[i] - _previousBallX[i]) * alpha,
+            _previousBallY[i] + (_sim.puckY[i] - _previousBallY[i]) * alpha));
+    }
+}
+
+void PartyLayer::holdPlayer(int player, int touchId)
+{
+    // a touch id is reused once released, drop what it held before
+    const auto held = _touchPlayers.find(touchId);
+    if (held != _touchPlayers.end())
+    {
+        _playerTouches[held->second] = -1;
+    }
+    _touchPlayers[touchId] = player;
+    _playerTouches[player] = touchId;
+}
+
+void PartyLayer::updateScoreLabels()
+{
+    _player1ScoreLabel->setString(std::to_string(_sim.scores[0]));
+    _player2ScoreLabel->setString(std::to_string(_sim.scores[1]));
+}
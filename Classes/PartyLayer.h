@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "cocos2d.h"
+#include "GameSprite.h"
+#include "PartySim.h"
+#include <unordered_map>
+
+using namespace cocos2d;
+
+/**
+ * \brief Party mode table: many pucks and mallets, simulated by PartySim.
+ *
+ * A touch only looks at the mallets of the zone it lands in, then the mallet it holds is found by its id,
+ * so a multi-touch table costs the same per touch whatever the number of mallets.
+ */
+class PartyLayer : public cocos2d::Layer
+{
+private:
+    cocos2d::Vector<GameSprite*> _players;
+    cocos2d::Vector<GameSprite*> _balls;
+    Label* _player1ScoreLabel;
+    Label* _player2ScoreLabel;
+    Size _screenSize;
+    PartySim _sim;
+    std::vector<float> _previousBallX;
+    std::vector<float> _previousBallY;
+    std::vector<float> _previousPlayerX;
+    std::vector<float> _previousPlayerY;
+    float _accumulator;
+    int _ballCount;
+    int _playerCount;
+    // mallets of each zone of _sim
+    std::vector<std::vector<int>> _zonePlayers;
+    // which mallet each touch id holds, and the touch id holding each mallet (-1 for none)
+    std::unordered_map<int, int> _touchPlayers;
+    std::vector<int> _playerTouches;
+
+public:
+    PartyLayer();
+    virtual ~PartyLayer();
+    bool init(int ballCount, int playerCount, int zoneColumns);
+
+    /**
+     * \param zoneColumns Zones side by side in each court, 2 with 4 players for a 2v2 table
+     */
+    static PartyLayer* create(int ballCount, int playerCount, int zoneColumns);
+    void onTouchesBegan(const std::vector<Touch*>& touches, Event* event) override;
+    void onTouchesMoved(const std::vector<Touch*>& touches, Event* event) override;
+    void onTouchesEnded(const std::vector<Touch*>& touches, Event* event) override;
+    void update(float dt) override;
+    void addBackgroud();
+    void addPlayers();
+    void addBalls();
+    void addScoreLabels();
+    void addEventListener();
+    void syncSprites(float alpha);
+    void holdPlayer(int player, int touchId);
+    void updateScoreLabels();
+};
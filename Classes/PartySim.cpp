@@ -0,0 +1,399 @@
+﻿#include "PartySim.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTY_SIM_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PARTY_SIM_NEON 1
+#endif
+
+// a touch that did not move for longer than this does not make the mallet slower
+#define MAX_TOUCH_INTERVAL 0.1f
+// pucks keep this fraction of their closing speed when they hit each other
+#define PUCK_BOUNCE 0.9f
+
+/**
+ * \brief Narrowphase kernel: append to hits the indexes in [begin, end) of the points
+ * closer than sqrt(radiusSq) to (x, y), four points per instruction when SIMD is available.
+ * \return Number of indexes appended
+ */
+static int findOverlaps(float x, float y, const float* xs, const float* ys, int begin, int end, float radiusSq, int* hits)
+{
+    auto count = 0;
+    auto i = begin;
+#if PARTY_SIM_SSE
+    const auto px = _mm_set1_ps(x);
+    const auto py = _mm_set1_ps(y);
+    const auto r2 = _mm_set1_ps(radiusSq);
+    for (; i + 4 <= end; i += 4)
+    {
+        const auto dx = _mm_sub_ps(_mm_loadu_ps(xs + i), px);
+        const auto dy = _mm_sub_ps(_mm_loadu_ps(ys + i), py);
+        const auto d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+        auto mask = _mm_movemask_ps(_mm_cmplt_ps(d2, r2));
+        for (auto lane = 0; mask; ++lane, mask >>= 1)
+        {
+            if (mask & 1)
+            {
+                hits[count++] = i + lane;
+            }
+        }
+    }
+#elif PARTY_SIM_NEON
+    const auto px = vdupq_n_f32(x);
+    const auto py = vdupq_n_f32(y);
+    const auto r2 = vdupq_n_f32(radiusSq);
+    for (; i + 4 <= end; i += 4)
+    {
+        const auto dx = vsubq_f32(vld1q_f32(xs + i), px);
+        const auto dy = vsubq_f32(vld1q_f32(ys + i), py);
+        const auto d2 = vmlaq_f32(vmulq_f32(dx, dx), dy, dy);
+        uint32_t lanes[4];
+        vst1q_u32(lanes, vcltq_f32(d2, r2));
+        for (auto lane = 0; lane < 4; ++lane)
+        {
+            if (lanes[lane])
+            {
+                hits[count++] = i + lane;
+            }
+        }
+    }
+#endif
+    for (; i < end; ++i)
+    {
+        const auto dx = xs[i] - x;
+        const auto dy = ys[i] - y;
+        if (dx * dx + dy * dy < radiusSq)
+        {
+            hits[count++] = i;
+        }
+    }
+    return count;
+}
+
+PartySim::PartySim()
+{
+    puckRadius = 0.0f;
+    malletRadius = 0.0f;
+    zoneColumns = 1;
+    width = 0.0f;
+    height = 0.0f;
+    scores[0] = 0;
+    scores[1] = 0;
+    tick = 0;
+    _cellSize = 1.0f;
+    _columns = 0;
+    _rows = 0;
+}
+
+void PartySim::init(float tableWidth, float tableHeight, int puckCount, float puckRadius_, int malletCount, float malletRadius_,
+    int zoneColumns_)
+{
+    width = tableWidth;
+    height = tableHeight;
+    puckRadius = puckRadius_;
+    malletRadius = malletRadius_;
+    zoneColumns = std::max(1, zoneColumns_);
+    scores[0] = 0;
+    scores[1] = 0;
+    tick = 0;
+
+    // pucks start in rows around the centre line
+    puckX.assign(puckCount, 0.0f);
+    puckY.assign(puckCount, 0.0f);
+    puckVx.assign(puckCount, 0.0f);
+    puckVy.assign(puckCount, 0.0f);
+    const auto spacing = puckRadius * 2.5f;
+    const auto perRow = std::max(1, static_cast<int>((width - 2.0f * puckRadius) / spacing));
+    const auto rowCount = (puckCount + perRow - 1) / perRow;
+    for (auto i = 0; i < puckCount; ++i)
+    {
+        const auto row = i / perRow;
+        const auto column = i % perRow;
+        puckX[i] = puckRadius + spacing * (column + 0.5f);
+        puckY[i] = height * 0.5f + spacing * (row - (rowCount - 1) * 0.5f);
+    }
+
+    zones.resize(2 * zoneColumns);
+    const auto zoneWidth = width / zoneColumns;
+    for (auto row = 0; row < 2; ++row)
+    {
+        for (auto column = 0; column < zoneColumns; ++column)
+        {
+            zones[row * zoneColumns + column] = { zoneWidth * column, height * 0.5f * row, zoneWidth * (column + 1),
+                height * 0.5f * (row + 1) };
+        }
+    }
+
+    // the mallets of a zone share out its base line
+    malletX.assign(malletCount, 0.0f);
+    malletY.assign(malletCount, 0.0f);
+    malletVx.assign(malletCount, 0.0f);
+    malletVy.assign(malletCount, 0.0f);
+    malletMoveTicks.assign(malletCount, 0);
+    malletZones.assign(malletCount, 0);
+    for (auto i = 0; i < malletCount; ++i)
+    {
+        const auto team = i % 2;
+        const auto teamSize = (malletCount + 1 - team) / 2;
+        const auto column = (i / 2) % zoneColumns;
+        const auto zoneSize = (teamSize - column + zoneColumns - 1) / zoneColumns;
+        const auto& zone = zones[team * zoneColumns + column];
+        malletZones[i] = team * zoneColumns + column;
+        malletX[i] = zone.minX + zoneWidth * (i / 2 / zoneColumns + 1) / (zoneSize + 1);
+        malletY[i] = team == 0 ? malletRadius : height - malletRadius;
+    }
+    malletNextX = malletX;
+    malletNextY = malletY;
+
+    // a cell holds a puck diameter, so a puck only touches pucks of its neighbour cells
+    _cellSize = 2.0f * puckRadius;
+    _columns = std::max(1, static_cast<int>(std::ceil(width / _cellSize)));
+    _rows = std::max(1, static_cast<int>(std::ceil(height / _cellSize)));
+    _cellStart.assign(_columns * _rows + 1, 0);
+    _cellCursor.assign(_columns * _rows, 0);
+    _puckCell.assign(puckCount, 0);
+    _sortedIndex.assign(puckCount, 0);
+    _sortedX.assign(puckCount, 0.0f);
+    _sortedY.assign(puckCount, 0.0f);
+    _hits.assign(puckCount, 0);
+}
+
+void PartySim::moveMallet(int index, float tapX, float tapY)
+{
+    auto nextX = tapX;
+    auto nextY = tapY;
+    zones[malletZones[index]].clamp(malletRadius, nextX, nextY);
+
+    // velocity is the distance to the tap over the time since the previous touch move
+    const auto tickSeconds = AirHockeySim::tickSeconds();
+    auto interval = (tick - malletMoveTicks[index]) * tickSeconds;
+    interval = interval < tickSeconds ? tickSeconds : interval;
+    interval = interval > MAX_TOUCH_INTERVAL ? MAX_TOUCH_INTERVAL : interval;
+    malletMoveTicks[index] = tick;
+
+    malletNextX[index] = nextX;
+    malletNextY[index] = nextY;
+    malletVx[index] = (tapX - malletX[index]) / interval;
+    malletVy[index] = (tapY - malletY[index]) / interval;
+}
+
+void PartySim::releaseMallet(int index)
+{
+    malletVx[index] = 0.0f;
+    malletVy[index] = 0.0f;
+}
+
+int PartySim::zoneAt(float x, float y) const
+{
+    if (x < 0.0f || x >= width || y < 0.0f || y >= height)
+    {
+        return -1;
+    }
+    // the zones are a grid, no need to test them one by one
+    const auto column = std::min(static_cast<int>(x * zoneColumns / width), zoneColumns - 1);
+    return (y < height * 0.5f ? 0 : zoneColumns) + column;
+}
+
+int PartySim::step()
+{
+    ++tick;
+    auto events = static_cast<int>(SIM_EVENT_NONE);
+    moveAndBouncePucks(events);
+    buildGrid();
+    collidePucks(events);
+    collideMallets(events);
+
+    // move mallets
+    malletX = malletNextX;
+    malletY = malletNextY;
+    return events;
+}
+
+void PartySim::moveAndBouncePucks(int& events)
+{
+    const auto dt = AirHockeySim::tickSeconds();
+    const auto minX = puckRadius;
+    const auto maxX = width - puckRadius;
+    const auto minY = puckRadius;
+    const auto maxY = height - puckRadius;
+    const auto goalMinX = width * GOAL_LEFT;
+    const auto goalMaxX = width * GOAL_RIGHT;
+    const auto count = getPuckCount();
+    for (auto i = 0; i < count; ++i)
+    {
+        auto x = puckX[i] + puckVx[i] * dt;
+        auto y = puckY[i] + puckVy[i] * dt;
+
+        if (x < minX || x > maxX)
+        {
+            events |= x < minX ? SIM_EVENT_WALL_LEFT : SIM_EVENT_WALL_RIGHT;
+            x = x < minX ? minX : maxX;
+            puckVx[i] *= WALL_BOUNCE;
+        }
+        if (y < minY || y > maxY)
+        {
+            // a puck crossing a goal line scores for the other court and comes back to the centre
+            if (x >= goalMinX && x <= goalMaxX)
+            {
+                const auto scorer = y < minY ? 2 : 1;
+                scores[scorer - 1]++;
+                events |= scorer == 1 ? SIM_EVENT_GOAL_PLAYER1 : SIM_EVENT_GOAL_PLAYER2;
+                respawnPuck(i);
+                continue;
+            }
+            events |= y < minY ? SIM_EVENT_WALL_BOTTOM : SIM_EVENT_WALL_TOP;
+            y = y < minY ? minY : maxY;
+            puckVy[i] *= WALL_BOUNCE;
+        }
+        puckX[i] = x;
+        puckY[i] = y;
+    }
+}
+
+void PartySim::respawnPuck(int index)
+{
+    puckX[index] = width * 0.5f;
+    puckY[index] = height * 0.5f;
+    puckVx[index] = 0.0f;
+    puckVy[index] = 0.0f;
+}
+
+int PartySim::cellOf(float x, float y) const
+{
+    auto column = static_cast<int>(x / _cellSize);
+    auto row = static_cast<int>(y / _cellSize);
+    column = column < 0 ? 0 : (column >= _columns ? _columns - 1 : column);
+    row = row < 0 ? 0 : (row >= _rows ? _rows - 1 : row);
+    return row * _columns + column;
+}
+
+void PartySim::buildGrid()
+{
+    // counting sort of the pucks by cell, positions are copied in that order for the kernel
+    const auto count = getPuckCount();
+    std::fill(_cellStart.begin(), _cellStart.end(), 0);
+    for (auto i = 0; i < count; ++i)
+    {
+        _puckCell[i] = cellOf(puckX[i], puckY[i]);
+        _cellStart[_puckCell[i] + 1]++;
+    }
+    const auto cellCount = _columns * _rows;
+    for (auto cell = 0; cell < cellCount; ++cell)
+    {
+        _cellStart[cell + 1] += _cellStart[cell];
+        _cellCursor[cell] = _cellStart[cell];
+    }
+    for (auto i = 0; i < count; ++i)
+    {
+        const auto slot = _cellCursor[_puckCell[i]]++;
+        _sortedIndex[slot] = i;
+        _sortedX[slot] = puckX[i];
+        _sortedY[slot] = puckY[i];
+    }
+}
+
+void PartySim::collidePucks(int& events)
+{
+    const auto sumRadius = 2.0f * puckRadius;
+    const auto sumSquareRadius = sumRadius * sumRadius;
+    const auto count = getPuckCount();
+    for (auto a = 0; a < count; ++a)
+    {
+        // test each pair once: the rest of this cell and the right cell on this row,
+        // then the three cells on the row above. Cells on a row are contiguous in sorted order.
+        const auto cell = _puckCell[_sortedIndex[a]];
+        const auto row = cell / _columns;
+        const auto column = cell % _columns;
+        const auto left = column > 0 ? column - 1 : 0;
+        const auto right = column + 1 < _columns ? column + 1 : column;
+
+        auto hitCount = findOverlaps(_sortedX[a], _sortedY[a], _sortedX.data(), _sortedY.data(),
+            a + 1, _cellStart[row * _columns + right + 1], sumSquareRadius, _hits.data());
+        if (row + 1 < _rows)
+        {
+            const auto rowStart = (row + 1) * _columns;
+            hitCount += findOverlaps(_sortedX[a], _sortedY[a], _sortedX.data(), _sortedY.data(),
+                _cellStart[rowStart + left], _cellStart[rowStart + right + 1], sumSquareRadius, _hits.data() + hitCount);
+        }
+
+        for (auto h = 0; h < hitCount; ++h)
+        {
+            const auto i = _sortedIndex[a];
+            const auto j = _sortedIndex[_hits[h]];
+            auto nx = puckX[j] - puckX[i];
+            auto ny = puckY[j] - puckY[i];
+            const auto dist = std::sqrt(nx * nx + ny * ny);
+            if (dist >= sumRadius)
+            {
+                continue;
+            }
+            nx = dist > 0.0f ? nx / dist : 1.0f;
+            ny = dist > 0.0f ? ny / dist : 0.0f;
+
+            // push both pucks apart, then exchange the closing speed (same mass)
+            const auto push = (sumRadius - dist) * 0.5f;
+            puckX[i] -= nx * push;
+            puckY[i] -= ny * push;
+            puckX[j] += nx * push;
+            puckY[j] += ny * push;
+            const auto closing = (puckVx[i] - puckVx[j]) * nx + (puckVy[i] - puckVy[j]) * ny;
+            events |= SIM_EVENT_PUCK_HIT;
+            if (closing > 0.0f)
+            {
+                const auto impulse = closing * (1.0f + PUCK_BOUNCE) * 0.5f;
+                puckVx[i] -= impulse * nx;
+                puckVy[i] -= impulse * ny;
+                puckVx[j] += impulse * nx;
+                puckVy[j] += impulse * ny;
+            }
+        }
+    }
+}
+
+void PartySim::collideMallets(int& events)
+{
+    const auto sumRadius = malletRadius + puckRadius;
+    const auto sumSquareRadius = sumRadius * sumRadius;
+    const auto mallets = getMalletCount();
+    for (auto m = 0; m < mallets; ++m)
+    {
+        const auto mx = malletNextX[m];
+        const auto my = malletNextY[m];
+        const auto firstCell = cellOf(mx - sumRadius, my - sumRadius);
+        const auto lastCell = cellOf(mx + sumRadius, my + sumRadius);
+        const auto left = firstCell % _columns;
+        const auto right = lastCell % _columns;
+        for (auto row = firstCell / _columns; row <= lastCell / _columns; ++row)
+        {
+            const auto hitCount = findOverlaps(mx, my, _sortedX.data(), _sortedY.data(),
+                _cellStart[row * _columns + left], _cellStart[row * _columns + right + 1], sumSquareRadius, _hits.data());
+            for (auto h = 0; h < hitCount; ++h)
+            {
+                const auto i = _sortedIndex[_hits[h]];
+                auto nx = puckX[i] - mx;
+                auto ny = puckY[i] - my;
+                const auto dist = std::sqrt(nx * nx + ny * ny);
+                if (dist >= sumRadius)
+                {
+                    continue;
+                }
+                nx = dist > 0.0f ? nx / dist : 0.0f;
+                ny = dist > 0.0f ? ny / dist : 1.0f;
+
+                // same rule as AirHockeySim: the puck leaves along the normal with both speeds
+                const auto magPuck = puckVx[i] * puckVx[i] + puckVy[i] * puckVy[i];
+                const auto magMallet = malletVx[m] * malletVx[m] + malletVy[m] * malletVy[m];
+                const auto force = std::sqrt(magPuck + magMallet);
+                puckVx[i] = force * nx;
+                puckVy[i] = force * ny;
+                puckX[i] = mx + sumRadius * nx;
+                puckY[i] = my + sumRadius * ny;
+                events |= SIM_EVENT_MALLET_HIT;
+            }
+        }
+    }
+}
@@ -0,0 +1,97 @@
+﻿#pragma once
+#include "AirHockeySim.h"
+#include <vector>
+
+/**
+ * \brief Renderer-free party mode: any number of pucks and mallets on one table.
+ *
+ * Bodies are stored as structure of arrays, so the narrowphase can test several
+ * pucks at once with SSE/NEON. A uniform grid, rebuilt every tick, keeps the tests
+ * to the neighbour cells. It uses the same tick and SimEvent flags as AirHockeySim.
+ * Even mallets play for the bottom court, odd mallets for the top court. Each court is split into
+ * zone columns side by side and a team deals its mallets to them in turn: 4 mallets in 2 columns
+ * make a 2v2 table of quadrants.
+ */
+class PartySim
+{
+public:
+    // pucks
+    std::vector<float> puckX;
+    std::vector<float> puckY;
+    std::vector<float> puckVx;
+    std::vector<float> puckVy;
+    float puckRadius;
+
+    // mallets, they move to next position in step()
+    std::vector<float> malletX;
+    std::vector<float> malletY;
+    std::vector<float> malletNextX;
+    std::vector<float> malletNextY;
+    std::vector<float> malletVx;
+    std::vector<float> malletVy;
+    std::vector<unsigned int> malletMoveTicks;
+    float malletRadius;
+
+    // zoneColumns zones per court, row by row from the bottom court, and the zone of each mallet
+    std::vector<SimZone> zones;
+    std::vector<int> malletZones;
+    int zoneColumns;
+
+    float width;
+    float height;
+    int scores[AirHockeySim::PLAYER_COUNT];
+    unsigned int tick;
+
+    PartySim();
+
+    /**
+     * \brief Set table size and zones, then place the mallets on the base lines of their zones and the pucks
+     * on the centre line
+     */
+    void init(float tableWidth, float tableHeight, int puckCount, float puckRadius_, int malletCount, float malletRadius_,
+        int zoneColumns_);
+
+    /**
+     * \brief Move a mallet toward a tap, the target is clamped to the zone of the mallet
+     */
+    void moveMallet(int index, float tapX, float tapY);
+
+    /**
+     * \brief Stop a mallet when its touch is released
+     */
+    void releaseMallet(int index);
+
+    /**
+     * \brief Advance the match by one tick of AirHockeySim::tickSeconds()
+     * \return SimEvent flags of what happened during this tick
+     */
+    int step();
+
+    /**
+     * \brief Zone holding a point of the table, -1 outside of the table
+     */
+    int zoneAt(float x, float y) const;
+
+    int getPuckCount() const { return static_cast<int>(puckX.size()); }
+    int getMalletCount() const { return static_cast<int>(malletX.size()); }
+
+private:
+    void moveAndBouncePucks(int& events);
+    void buildGrid();
+    void collidePucks(int& events);
+    void collideMallets(int& events);
+    void respawnPuck(int index);
+    int cellOf(float x, float y) const;
+
+    // uniform grid, cells are sorted row by row so neighbour cells of a row are contiguous
+    float _cellSize;
+    int _columns;
+    int _rows;
+    std::vector<int> _cellStart;
+    std::vector<int> _cellCursor;
+    std::vector<int> _puckCell;
+    std::vector<int> _sortedIndex;
+    std::vector<float> _sortedX;
+    std::vector<float> _sortedY;
+    std::vector<int> _hits;
+};
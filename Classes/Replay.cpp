@@ -0,0 +1,350 @@
+﻿#include "Replay.h"
+#include <algorithm>
+#include <cstring>
+
+#define REPLAY_MAGIC "AHRP"
+#define REPLAY_INDEX_MAGIC "AHIX"
+#define REPLAY_VERSION 1
+// the buffer is handed to the writer thread when it is this full
+#define REPLAY_FLUSH_SIZE (64 * 1024)
+
+namespace
+{
+    const size_t HEADER_SIZE = 4 + 3 * sizeof(uint32_t);
+    const size_t FOOTER_SIZE = sizeof(uint64_t) + 4;
+
+    template <typename T>
+    bool readValue(const std::vector<char>& data, size_t offset, T& value)
+    {
+        if (offset + sizeof(T) > data.size())
+        {
+            return false;
+        }
+        memcpy(&value, data.data() + offset, sizeof(T));
+        return true;
+    }
+}
+
+ReplayRecorder::ReplayRecorder()
+{
+    _file = nullptr;
+    _keyframeInterval = 0;
+    _hasKeyframe = false;
+    _lastKeyframeTick = 0;
+    _tick = 0;
+    _offset = 0;
+    _hasPending = false;
+    _stopping = false;
+}
+
+ReplayRecorder::~ReplayRecorder()
+{
+    close();
+}
+
+bool ReplayRecorder::open(const std::string& path, unsigned int keyframeInterval)
+{
+    close();
+    _file = fopen(path.c_str(), "wb");
+    if (!_file)
+    {
+        return false;
+    }
+    _keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 1;
+    _hasKeyframe = false;
+    _tick = 0;
+    _offset = 0;
+    _indexTicks.clear();
+    _indexOffsets.clear();
+    _buffer.clear();
+    _buffer.reserve(2 * REPLAY_FLUSH_SIZE);
+    _pending.clear();
+    _pending.reserve(2 * REPLAY_FLUSH_SIZE);
+    _hasPending = false;
+    _stopping = false;
+
+    const uint32_t header[] = { REPLAY_VERSION, sizeof(AirHockeySim), _keyframeInterval };
+    append(REPLAY_MAGIC, 4);
+    append(header, sizeof(header));
+
+    _writer = std::thread(&ReplayRecorder::writerLoop, this);
+    return true;
+}
+
+void ReplayRecorder::close()
+{
+    if (!_file)
+    {
+        return;
+    }
+
+    const uint8_t type = REPLAY_END;
+    const uint32_t endTick = _tick;
+    append(&type, sizeof(type));
+    append(&endTick, sizeof(endTick));
+
+    // let the writer finish what it has, then write the rest here
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _condition.notify_one();
+    _writer.join();
+
+    const auto indexOffset = _offset;
+    const auto count = static_cast<uint32_t>(_indexTicks.size());
+    append(&count, sizeof(count));
+    for (size_t i = 0; i < _indexTicks.size(); ++i)
+    {
+        append(&_indexTicks[i], sizeof(uint32_t));
+        append(&_indexOffsets[i], sizeof(uint64_t));
+    }
+    append(&indexOffset, sizeof(indexOffset));
+    append(REPLAY_INDEX_MAGIC, 4);
+    fwrite(_buffer.data(), 1, _buffer.size(), _file);
+    _buffer.clear();
+
+    fclose(_file);
+    _file = nullptr;
+}
+
+void ReplayRecorder::recordTick(const AirHockeySim& sim)
+{
+    if (!_file)
+    {
+        return;
+    }
+    _tick = sim.tick + 1;
+    if (_hasKeyframe && sim.tick - _lastKeyframeTick < _keyframeInterval)
+    {
+        return;
+    }
+    _hasKeyframe = true;
+    _lastKeyframeTick = sim.tick;
+    _indexTicks.push_back(sim.tick);
+    _indexOffsets.push_back(_offset);
+
+    const uint8_t type = REPLAY_KEYFRAME;
+    const uint32_t tick = sim.tick;
+    append(&type, sizeof(type));
+    append(&tick, sizeof(tick));
+    append(&sim, sizeof(sim));
+    if (_buffer.size() >= REPLAY_FLUSH_SIZE)
+    {
+        flush();
+    }
+}
+
+void ReplayRecorder::recordMove(unsigned int tick, int mallet, float tapX, float tapY)
+{
+    if (!_file)
+    {
+        return;
+    }
+    const uint8_t type = REPLAY_MOVE;
+    const uint32_t recordTick = tick;
+    const uint8_t recordMallet = static_cast<uint8_t>(mallet);
+    append(&type, sizeof(type));
+    append(&recordTick, sizeof(recordTick));
+    append(&recordMallet, sizeof(recordMallet));
+    append(&tapX, sizeof(tapX));
+    append(&tapY, sizeof(tapY));
+}
+
+void ReplayRecorder::recordRelease(unsigned int tick, int mallet)
+{
+    if (!_file)
+    {
+        return;
+    }
+    const uint8_t type = REPLAY_RELEASE;
+    const uint32_t recordTick = tick;
+    const uint8_t recordMallet = static_cast<uint8_t>(mallet);
+    append(&type, sizeof(type));
+    append(&recordTick, sizeof(recordTick));
+    append(&recordMallet, sizeof(recordMallet));
+}
+
+void ReplayRecorder::append(const void* data, size_t size)
+{
+    const auto bytes = static_cast<const char*>(data);
+    _buffer.insert(_buffer.end(), bytes, bytes + size);
+    _offset += size;
+}
+
+void ReplayRecorder::flush()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_hasPending)
+        {
+            // the writer is still busy, keep filling this buffer rather than waiting
+            return;
+        }
+        // both buffers keep their capacity, so swapping does not allocate
+        _pending.swap(_buffer);
+        _buffer.clear();
+        _hasPending = true;
+    }
+    _condition.notify_one();
+}
+
+void ReplayRecorder::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _condition.wait(lock, [this] { return _hasPending || _stopping; });
+        if (_hasPending)
+        {
+            lock.unlock();
+            fwrite(_pending.data(), 1, _pending.size(), _file);
+            _pending.clear();
+            lock.lock();
+            _hasPending = false;
+        }
+        else if (_stopping)
+        {
+            return;
+        }
+    }
+}
+
+ReplayPlayer::ReplayPlayer()
+{
+    _lastTick = 0;
+}
+
+bool ReplayPlayer::load(const std::string& path)
+{
+    _inputs.clear();
+    _keyframes.clear();
+    _lastTick = 0;
+
+    auto file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        return false;
+    }
+    std::vector<char> data;
+    char chunk[64 * 1024];
+    size_t read = 0;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + read);
+    }
+    fclose(file);
+
+    uint32_t version = 0;
+    uint32_t stateSize = 0;
+    if (data.size() < HEADER_SIZE || memcmp(data.data(), REPLAY_MAGIC, 4) != 0
+        || !readValue(data, 4, version) || !readValue(data, 8, stateSize)
+        || version != REPLAY_VERSION || stateSize != sizeof(AirHockeySim))
+    {
+        return false;
+    }
+
+    // keyframes come from the index when the recording was closed, otherwise from the scan below
+    auto end = data.size();
+    uint64_t indexOffset = 0;
+    auto hasIndex = data.size() >= HEADER_SIZE + FOOTER_SIZE
+        && memcmp(data.data() + data.size() - 4, REPLAY_INDEX_MAGIC, 4) == 0
+        && readValue(data, data.size() - FOOTER_SIZE, indexOffset) && indexOffset < data.size();
+    if (hasIndex)
+    {
+        uint32_t count = 0;
+        readValue(data, indexOffset, count);
+        _keyframes.resize(count);
+        for (uint32_t i = 0; i < count && hasIndex; ++i)
+        {
+            const auto entry = indexOffset + sizeof(uint32_t) + i * (sizeof(uint32_t) + sizeof(uint64_t));
+            uint64_t offset = 0;
+            hasIndex = readValue(data, entry, _keyframes[i].tick) && readValue(data, entry + sizeof(uint32_t), offset)
+                && readValue(data, offset + 1 + sizeof(uint32_t), _keyframes[i].sim);
+        }
+        end = indexOffset;
+    }
+    if (!hasIndex)
+    {
+        _keyframes.clear();
+    }
+
+    size_t offset = HEADER_SIZE;
+    while (offset < end)
+    {
+        uint8_t type = 0;
+        Input input = Input();
+        readValue(data, offset, type);
+        if (!readValue(data, offset + 1, input.tick))
+        {
+            break;
+        }
+        if (type == REPLAY_MOVE || type == REPLAY_RELEASE)
+        {
+            input.type = type;
+            if (!readValue(data, offset + 5, input.mallet)
+                || (type == REPLAY_MOVE && (!readValue(data, offset + 6, input.x) || !readValue(data, offset + 10, input.y))))
+            {
+                break;
+            }
+            _inputs.push_back(input);
+            offset += type == REPLAY_MOVE ? 14 : 6;
+        }
+        else if (type == REPLAY_KEYFRAME)
+        {
+            Keyframe keyframe;
+            keyframe.tick = input.tick;
+            if (!readValue(data, offset + 5, keyframe.sim))
+            {
+                break;
+            }
+            if (!hasIndex)
+            {
+                _keyframes.push_back(keyframe);
+            }
+            offset += 5 + sizeof(AirHockeySim);
+        }
+        else if (type == REPLAY_END)
+        {
+            offset += 5;
+        }
+        else
+        {
+            break;
+        }
+        _lastTick = std::max(_lastTick, static_cast<unsigned int>(input.tick));
+    }
+    return !_keyframes.empty();
+}
+
+bool ReplayPlayer::seek(unsigned int tick, AirHockeySim& sim) const
+{
+    // last keyframe at or before tick
+    const auto keyframe = std::upper_bound(_keyframes.begin(), _keyframes.end(), tick,
+        [](unsigned int value, const Keyframe& frame) { return value < frame.tick; });
+    if (keyframe == _keyframes.begin())
+    {
+        return false;
+    }
+    sim = (keyframe - 1)->sim;
+
+    // the keyframe already has the inputs of its own tick, each later tick gets its inputs after the step() that reaches it
+    auto input = std::upper_bound(_inputs.begin(), _inputs.end(), sim.tick,
+        [](unsigned int target, const Input& value) { return target < value.tick; });
+    while (sim.tick < tick)
+    {
+        sim.step();
+        for (; input != _inputs.end() && input->tick == sim.tick; ++input)
+        {
+            if (input->type == REPLAY_MOVE)
+            {
+                sim.moveMallet(input->mallet, input->x, input->y);
+            }
+            else
+            {
+                sim.releaseMallet(input->mallet);
+            }
+        }
+    }
+    return true;
+}
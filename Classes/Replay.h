@@ -0,0 +1,140 @@
+﻿#pragma once
+#include "AirHockeySim.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Replay file, little-endian:
+ * - header: "AHRP", version, sizeof(AirHockeySim), keyframe interval (uint32 each)
+ * - records: a type byte followed by
+ *   - REPLAY_MOVE: tick (uint32), mallet (uint8), tap x, tap y (float), the arguments of AirHockeySim::moveMallet()
+ *   - REPLAY_RELEASE: tick (uint32), mallet (uint8)
+ *   - REPLAY_KEYFRAME: tick (uint32) and the whole AirHockeySim, taken after the inputs and before the step() of its tick
+ *   - REPLAY_END: tick (uint32) reached by the last recorded step()
+ * - index, written when the recording is closed: count (uint32), then tick (uint32) and offset (uint64)
+ *   of each keyframe record
+ * - footer: offset of the index (uint64), "AHIX"
+ * A file without footer (the game was killed) is still readable, its keyframes are found by scanning.
+ */
+enum ReplayRecordType
+{
+    REPLAY_MOVE = 1,
+    REPLAY_RELEASE = 2,
+    REPLAY_KEYFRAME = 3,
+    REPLAY_END = 4
+};
+
+/**
+ * \brief Records the inputs of a match, with keyframes, into a replay file.
+ *
+ * Records are appended to a memory buffer on the game thread, a background thread
+ * writes full buffers to the file, so recording never waits for I/O.
+ */
+class ReplayRecorder
+{
+public:
+    ReplayRecorder();
+    ~ReplayRecorder();
+
+    /**
+     * \brief Start recording into a new file
+     * \param keyframeInterval A keyframe is taken every keyframeInterval ticks
+     */
+    bool open(const std::string& path, unsigned int keyframeInterval);
+
+    /**
+     * \brief Write what is left, the keyframe index and the footer, then close the file
+     */
+    void close();
+
+    bool isOpen() const { return _file != nullptr; }
+
+    /**
+     * \brief Call right before each AirHockeySim::step(), after the inputs of the tick, takes a keyframe when it is due
+     */
+    void recordTick(const AirHockeySim& sim);
+
+    /**
+     * \brief Call with the arguments of AirHockeySim::moveMallet(), tick is AirHockeySim::tick at that time
+     */
+    void recordMove(unsigned int tick, int mallet, float tapX, float tapY);
+
+    /**
+     * \brief Call with the argument of AirHockeySim::releaseMallet()
+     */
+    void recordRelease(unsigned int tick, int mallet);
+
+private:
+    void append(const void* data, size_t size);
+    void flush();
+    void writerLoop();
+
+    FILE* _file;
+    unsigned int _keyframeInterval;
+    bool _hasKeyframe;
+    unsigned int _lastKeyframeTick;
+    unsigned int _tick;
+
+    // file offset of the next appended byte, to index keyframes
+    uint64_t _offset;
+    std::vector<uint32_t> _indexTicks;
+    std::vector<uint64_t> _indexOffsets;
+
+    // the game thread fills _buffer, the writer thread writes _pending
+    std::vector<char> _buffer;
+    std::vector<char> _pending;
+    bool _hasPending;
+    bool _stopping;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::thread _writer;
+};
+
+/**
+ * \brief Reads a replay file and rebuilds the match at any tick.
+ *
+ * seek() loads the last keyframe before the tick and simulates the recorded inputs from there,
+ * so it costs at most one keyframe interval of ticks.
+ */
+class ReplayPlayer
+{
+public:
+    ReplayPlayer();
+
+    bool load(const std::string& path);
+
+    /**
+     * \brief Last tick that can be rebuilt
+     */
+    unsigned int getLastTick() const { return _lastTick; }
+
+    /**
+     * \brief Rebuild the match as it was right before the step() of tick, its inputs applied
+     */
+    bool seek(unsigned int tick, AirHockeySim& sim) const;
+
+private:
+    struct Input
+    {
+        uint32_t tick;
+        uint8_t type;
+        uint8_t mallet;
+        float x;
+        float y;
+    };
+
+    struct Keyframe
+    {
+        uint32_t tick;
+        AirHockeySim sim;
+    };
+
+    std::vector<Input> _inputs;
+    std::vector<Keyframe> _keyframes;
+    unsigned int _lastTick;
+};
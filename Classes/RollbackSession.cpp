@@ -0,0 +1,211 @@
+﻿#include "RollbackSession.h"
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+#define PACKET_MAGIC "AHNP"
+#define PACKET_HEADER_SIZE 13
+#define PACKET_INPUT_SIZE 9
+
+static bool isValidInput(const unsigned char* data)
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    memcpy(&x, data + 1, sizeof(x));
+    memcpy(&y, data + 5, sizeof(y));
+    return (data[0] == NetInput::NONE || data[0] == NetInput::MOVE || data[0] == NetInput::RELEASE)
+        && std::isfinite(x) && std::isfinite(y);
+}
+
+RollbackSession::RollbackSession()
+{
+    _sim = AirHockeySim();
+    _localMallet = 0;
+    _remoteConfirmed = 0;
+    _localAcknowledged = 0;
+    _rollbackTick = 0;
+    _lastRollbackTicks = 0;
+    _rollbackCount = 0;
+    _scoresCorrected = false;
+}
+
+void RollbackSession::init(const AirHockeySim& start, int localMallet)
+{
+    _sim = start;
+    _localMallet = localMallet;
+    for (auto i = 0; i < MAX_ROLLBACK_TICKS; ++i)
+    {
+        _localInputs[i] = NetInput();
+        _remoteInputs[i] = NetInput();
+        _usedRemoteInputs[i] = NetInput();
+        _remoteInputTicks[i] = UINT_MAX;
+    }
+    _remoteConfirmed = _sim.tick;
+    _localAcknowledged = _sim.tick;
+    _rollbackTick = _sim.tick;
+    _lastRollbackTicks = 0;
+    _rollbackCount = 0;
+    _scoresCorrected = false;
+}
+
+bool RollbackSession::canAdvance() const
+{
+    // every tick that may still be corrected, and every input not acknowledged, must stay in the rings
+    return _sim.tick - _remoteConfirmed < MAX_ROLLBACK_TICKS && _sim.tick - _localAcknowledged < MAX_ROLLBACK_TICKS;
+}
+
+int RollbackSession::advance(const NetInput& localInput)
+{
+    _scoresCorrected = false;
+    auto events = this->synchronize();
+    const auto slot = _sim.tick % MAX_ROLLBACK_TICKS;
+    _localInputs[slot] = localInput;
+    events |= this->simulate(slot);
+    _rollbackTick = _sim.tick;
+    return events;
+}
+
+int RollbackSession::synchronize()
+{
+    if (_rollbackTick < _sim.tick)
+    {
+        return this->rollback();
+    }
+    return SIM_EVENT_NONE;
+}
+
+int RollbackSession::rollback()
+{
+    const auto present = _sim.tick;
+    const int predictedScores[AirHockeySim::PLAYER_COUNT] = { _sim.scores[0], _sim.scores[1] };
+    _sim = _snapshots[_rollbackTick % MAX_ROLLBACK_TICKS];
+    while (_sim.tick < present)
+    {
+        // events were already reported when these ticks ran the first time, but not a change of the scores
+        this->simulate(_sim.tick % MAX_ROLLBACK_TICKS);
+    }
+    _lastRollbackTicks = static_cast<int>(present - _rollbackTick);
+    ++_rollbackCount;
+
+    auto goals = static_cast<int>(SIM_EVENT_NONE);
+    for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+    {
+        if (_sim.scores[i] != predictedScores[i])
+        {
+            _scoresCorrected = true;
+        }
+        if (_sim.scores[i] > predictedScores[i])
+        {
+            goals |= i == 0 ? SIM_EVENT_GOAL_PLAYER1 : SIM_EVENT_GOAL_PLAYER2;
+        }
+    }
+    return goals;
+}
+
+int RollbackSession::simulate(unsigned int slot)
+{
+    // predict that the remote player does nothing new, its mallet keeps going to its last target
+    _snapshots[slot] = _sim;
+    _usedRemoteInputs[slot] = this->isRemoteKnown(_sim.tick) ? _remoteInputs[slot] : NetInput();
+
+    const NetInput* inputs[AirHockeySim::PLAYER_COUNT];
+    inputs[_localMallet] = &_localInputs[slot];
+    inputs[1 - _localMallet] = &_usedRemoteInputs[slot];
+    for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+    {
+        // both devices apply the inputs in mallet order, so they compute the same tick
+        if (inputs[i]->type == NetInput::MOVE)
+        {
+            _sim.moveMallet(i, inputs[i]->x, inputs[i]->y);
+        }
+        else if (inputs[i]->type == NetInput::RELEASE)
+        {
+            _sim.releaseMallet(i);
+        }
+    }
+    return _sim.step();
+}
+
+bool RollbackSession::isRemoteKnown(unsigned int tick) const
+{
+    return _remoteInputTicks[tick % MAX_ROLLBACK_TICKS] == tick;
+}
+
+size_t RollbackSession::writePacket(unsigned char* packet) const
+{
+    const uint32_t first = _localAcknowledged;
+    const auto count = static_cast<uint8_t>(_sim.tick - _localAcknowledged);
+    const uint32_t acknowledge = _remoteConfirmed;
+    memcpy(packet, PACKET_MAGIC, 4);
+    memcpy(packet + 4, &first, sizeof(first));
+    memcpy(packet + 8, &count, sizeof(count));
+    memcpy(packet + 9, &acknowledge, sizeof(acknowledge));
+    auto size = static_cast<size_t>(PACKET_HEADER_SIZE);
+    for (auto i = 0; i < count; ++i)
+    {
+        const auto& input = _localInputs[(first + i) % MAX_ROLLBACK_TICKS];
+        packet[size] = input.type;
+        memcpy(packet + size + 1, &input.x, sizeof(input.x));
+        memcpy(packet + size + 5, &input.y, sizeof(input.y));
+        size += PACKET_INPUT_SIZE;
+    }
+    return size;
+}
+
+bool RollbackSession::readPacket(const unsigned char* packet, size_t size)
+{
+    uint32_t first = 0;
+    uint8_t count = 0;
+    uint32_t acknowledge = 0;
+    if (size < PACKET_HEADER_SIZE || memcmp(packet, PACKET_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+    memcpy(&first, packet + 4, sizeof(first));
+    memcpy(&count, packet + 8, sizeof(count));
+    memcpy(&acknowledge, packet + 9, sizeof(acknowledge));
+    if (size < PACKET_HEADER_SIZE + static_cast<size_t>(count) * PACKET_INPUT_SIZE)
+    {
+        return false;
+    }
+    for (auto i = 0; i < count; ++i)
+    {
+        // one bad input would make the mallet and then the puck NaN on both devices for the rest of the match
+        if (!isValidInput(packet + PACKET_HEADER_SIZE + i * PACKET_INPUT_SIZE))
+        {
+            return false;
+        }
+    }
+
+    // packets can come out of order, an old acknowledge does not go back
+    if (acknowledge > _localAcknowledged && acknowledge <= _sim.tick)
+    {
+        _localAcknowledged = acknowledge;
+    }
+
+    for (auto i = 0; i < count; ++i)
+    {
+        const auto tick = first + i;
+        // before: already known, after: the slot is still used by a tick that may be corrected, it is sent again
+        if (tick < _remoteConfirmed || tick >= _remoteConfirmed + MAX_ROLLBACK_TICKS || this->isRemoteKnown(tick))
+        {
+            continue;
+        }
+        const auto slot = tick % MAX_ROLLBACK_TICKS;
+        const auto data = packet + PACKET_HEADER_SIZE + i * PACKET_INPUT_SIZE;
+        auto& input = _remoteInputs[slot];
+        input.type = data[0];
+        memcpy(&input.x, data + 1, sizeof(input.x));
+        memcpy(&input.y, data + 5, sizeof(input.y));
+        _remoteInputTicks[slot] = tick;
+        if (tick < _sim.tick && input != _usedRemoteInputs[slot] && tick < _rollbackTick)
+        {
+            _rollbackTick = tick;
+        }
+    }
+    while (this->isRemoteKnown(_remoteConfirmed))
+    {
+        ++_remoteConfirmed;
+    }
+    return true;
+}
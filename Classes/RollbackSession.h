@@ -0,0 +1,134 @@
+﻿#pragma once
+#include "AirHockeySim.h"
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * \brief What a player did to its mallet during one tick
+ */
+struct NetInput
+{
+    enum Type
+    {
+        NONE = 0,
+        MOVE = 1,       // AirHockeySim::moveMallet() to x, y
+        RELEASE = 2     // AirHockeySim::releaseMallet()
+    };
+
+    uint8_t type;
+    float x;
+    float y;
+
+    bool operator==(const NetInput& other) const
+    {
+        return type == other.type && (type != MOVE || (x == other.x && y == other.y));
+    }
+    bool operator!=(const NetInput& other) const { return !(*this == other); }
+};
+
+/**
+ * \brief Rollback netcode for a match between two devices.
+ *
+ * Each device runs the whole simulation. The inputs of the remote player are not known yet when a tick runs,
+ * so they are predicted (the remote does nothing new); when the real input arrives and differs, the match is
+ * restored from the snapshot of that tick and simulated again up to the present tick. Snapshots are plain
+ * copies of AirHockeySim, kept in a ring of MAX_ROLLBACK_TICKS.
+ *
+ * The session only turns inputs into packets and back, see UdpTransport to move them.
+ * Packet, little-endian: "AHNP", tick of the first input (uint32), input count (uint8), last remote tick
+ * received without gap (uint32, acknowledge), then type (uint8), x, y (float) of each input.
+ */
+class RollbackSession
+{
+public:
+    // the local player can not run further ahead of the last confirmed remote input than this
+    static const int MAX_ROLLBACK_TICKS = 32;
+    static const size_t MAX_PACKET_SIZE = 13 + MAX_ROLLBACK_TICKS * 9;
+
+    RollbackSession();
+
+    /**
+     * \param start Match at tick 0, the same on both devices
+     * \param localMallet Mallet played on this device, the other one is remote
+     */
+    void init(const AirHockeySim& start, int localMallet);
+
+    int getLocalMallet() const { return _localMallet; }
+
+    /**
+     * \brief Whether advance() may run, false while waiting for the remote player to catch up
+     */
+    bool canAdvance() const;
+
+    /**
+     * \brief Apply the local input and the remote one (known or predicted) of the current tick, then step
+     * \return SimEvent flags of this tick, with the goals a correction of the past ticks scored and the
+     * prediction had not
+     */
+    int advance(const NetInput& localInput);
+
+    /**
+     * \brief Simulate the corrections received since the last advance() now, advance() also does it
+     * \return SIM_EVENT_GOAL flags of the goals the corrections scored and the prediction had not
+     */
+    int synchronize();
+
+    /**
+     * \brief Predicted state of the match at the current tick
+     */
+    const AirHockeySim& getState() const { return _sim; }
+
+    /**
+     * \brief Every remote input before this tick is known, the match is final up to it
+     */
+    unsigned int getConfirmedTick() const { return _remoteConfirmed; }
+
+    /**
+     * \brief Ticks simulated again by the last correction and the total number of corrections
+     */
+    int getLastRollbackTicks() const { return _lastRollbackTicks; }
+    int getRollbackCount() const { return _rollbackCount; }
+
+    /**
+     * \brief Whether the corrections since the start of the last advance() changed the scores, a predicted goal
+     * was not scored or a goal was not predicted
+     */
+    bool areScoresCorrected() const { return _scoresCorrected; }
+
+    /**
+     * \brief Write the local inputs the remote has not acknowledged yet, and acknowledge the remote ones
+     * \return Packet size
+     */
+    size_t writePacket(unsigned char* packet) const;
+
+    /**
+     * \brief Read a packet of the remote, corrections are simulated by the next advance()
+     * \return false if it is not a packet of this session or one of its inputs is not valid
+     */
+    bool readPacket(const unsigned char* packet, size_t size);
+
+private:
+    int rollback();
+    int simulate(unsigned int slot);
+    bool isRemoteKnown(unsigned int tick) const;
+
+    AirHockeySim _sim;
+    int _localMallet;
+
+    // rings indexed by tick % MAX_ROLLBACK_TICKS: state before the inputs of the tick, and the inputs
+    AirHockeySim _snapshots[MAX_ROLLBACK_TICKS];
+    NetInput _localInputs[MAX_ROLLBACK_TICKS];
+    NetInput _remoteInputs[MAX_ROLLBACK_TICKS];
+    // remote inputs that were used to simulate each tick, known or predicted
+    NetInput _usedRemoteInputs[MAX_ROLLBACK_TICKS];
+    // tick of the remote input held by each slot, the input is known when it matches
+    unsigned int _remoteInputTicks[MAX_ROLLBACK_TICKS];
+
+    unsigned int _remoteConfirmed;
+    unsigned int _localAcknowledged;
+    // earliest tick simulated with a wrong prediction, _sim.tick when there is none
+    unsigned int _rollbackTick;
+    int _lastRollbackTicks;
+    int _rollbackCount;
+    bool _scoresCorrected;
+};
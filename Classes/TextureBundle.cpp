@@ -0,0 +1,195 @@
+﻿#include "TextureBundle.h"
+#include <cstdio>
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define BUNDLE_MAGIC "AHTB"
+#define BUNDLE_VERSION 1
+// textures start on this boundary, enough for any pixel format
+#define BUNDLE_ALIGNMENT 16
+
+TextureBundle::TextureBundle()
+{
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+#ifdef _WIN32
+    _mapping = nullptr;
+#endif
+}
+
+TextureBundle::~TextureBundle()
+{
+    close();
+}
+
+bool TextureBundle::map(const std::string& path)
+{
+    close();
+#ifdef _WIN32
+    auto file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    LARGE_INTEGER size;
+    _mapping = GetFileSizeEx(file, &size) && size.QuadPart > 0
+        ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    // the mapping keeps the file open
+    CloseHandle(file);
+    if (!_mapping)
+    {
+        return false;
+    }
+    auto data = MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+        return false;
+    }
+    const auto length = static_cast<size_t>(size.QuadPart);
+#else
+    auto file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+        return false;
+    }
+    struct stat status;
+    auto data = fstat(file, &status) == 0 && status.st_size > 0
+        ? mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0) : MAP_FAILED;
+    // the mapping keeps the file open
+    ::close(file);
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+    const auto length = static_cast<size_t>(status.st_size);
+#endif
+    if (!open(static_cast<const unsigned char*>(data), length))
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+#else
+        munmap(data, length);
+#endif
+        return false;
+    }
+    _mapped = true;
+    return true;
+}
+
+bool TextureBundle::open(const unsigned char* data, size_t size)
+{
+    close();
+    uint32_t header[3];
+    if (!data || size < 4 + sizeof(header) || memcmp(data, BUNDLE_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+    memcpy(header, data + 4, sizeof(header));
+    if (header[0] != BUNDLE_VERSION || header[1] != sizeof(TextureBundleEntry))
+    {
+        return false;
+    }
+    const auto count = header[2];
+    const auto indexEnd = 4 + sizeof(header) + static_cast<size_t>(count) * sizeof(TextureBundleEntry);
+    if (indexEnd > size)
+    {
+        return false;
+    }
+    _entries.resize(count);
+    memcpy(_entries.data(), data + 4 + sizeof(header), count * sizeof(TextureBundleEntry));
+    for (auto& entry : _entries)
+    {
+        entry.name[sizeof(entry.name) - 1] = '\0';
+        if (entry.offset < indexEnd || entry.offset > size || entry.size > size - entry.offset)
+        {
+            _entries.clear();
+            return false;
+        }
+    }
+    _data = data;
+    _size = size;
+    return true;
+}
+
+void TextureBundle::close()
+{
+    if (_mapped)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(_data);
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+#else
+        munmap(const_cast<unsigned char*>(_data), _size);
+#endif
+    }
+    _data = nullptr;
+    _size = 0;
+    _mapped = false;
+    _entries.clear();
+}
+
+const unsigned char* TextureBundle::find(const std::string& name, size_t& size) const
+{
+    // a handful of entries, a search costs less than building a map
+    for (const auto& entry : _entries)
+    {
+        if (name == entry.name)
+        {
+            size = entry.size;
+            return _data + entry.offset;
+        }
+    }
+    size = 0;
+    return nullptr;
+}
+
+bool TextureBundle::write(const std::string& path, const std::vector<std::pair<std::string, std::vector<unsigned char>>>& textures)
+{
+    const uint32_t header[] = { BUNDLE_VERSION, sizeof(TextureBundleEntry), static_cast<uint32_t>(textures.size()) };
+    std::vector<TextureBundleEntry> entries(textures.size());
+    auto offset = 4 + sizeof(header) + entries.size() * sizeof(TextureBundleEntry);
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        if (textures[i].first.size() >= sizeof(entries[i].name))
+        {
+            return false;
+        }
+        memset(entries[i].name, 0, sizeof(entries[i].name));
+        memcpy(entries[i].name, textures[i].first.c_str(), textures[i].first.size());
+        offset = (offset + BUNDLE_ALIGNMENT - 1) / BUNDLE_ALIGNMENT * BUNDLE_ALIGNMENT;
+        entries[i].offset = static_cast<uint32_t>(offset);
+        entries[i].size = static_cast<uint32_t>(textures[i].second.size());
+        offset += textures[i].second.size();
+    }
+
+    auto file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    fwrite(BUNDLE_MAGIC, 1, 4, file);
+    fwrite(header, sizeof(header), 1, file);
+    fwrite(entries.data(), sizeof(TextureBundleEntry), entries.size(), file);
+    auto position = 4 + sizeof(header) + entries.size() * sizeof(TextureBundleEntry);
+    const unsigned char padding[BUNDLE_ALIGNMENT] = {};
+    for (size_t i = 0; i < textures.size(); ++i)
+    {
+        fwrite(padding, 1, entries[i].offset - position, file);
+        fwrite(textures[i].second.data(), 1, textures[i].second.size(), file);
+        position = entries[i].offset + textures[i].second.size();
+    }
+    return fclose(file) == 0;
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * \brief One texture of a bundle, as it is stored in the index
+ */
+struct TextureBundleEntry
+{
+    // file name the texture replaces, e.g. "table.png", zero padded
+    char name[56];
+    // from the start of the bundle, a multiple of 16
+    uint32_t offset;
+    uint32_t size;
+};
+
+/**
+ * \brief Read-only archive of cooked textures, memory-mapped so a texture goes from the page cache to
+ * Image without being read into a buffer first.
+ *
+ * Each texture is a PVR v3 file as Image reads it: ETC1, with its alpha as a second ETC1 texture named
+ * "<name>@alpha" (TextureCache::getETC1AlphaFileSuffix()), or uncompressed with premultiplied alpha.
+ * File: "AHTB", version, sizeof(TextureBundleEntry), entry count (uint32 each), the entries, then the
+ * textures. See MyGame_texturecook.
+ * It does not depend on cocos2d.
+ */
+class TextureBundle
+{
+public:
+    TextureBundle();
+    ~TextureBundle();
+
+    /**
+     * \brief Map a file, fails where the file is not on the file system (Android assets), then use open()
+     */
+    bool map(const std::string& path);
+
+    /**
+     * \brief Read a bundle from memory, the caller keeps data alive until close()
+     */
+    bool open(const unsigned char* data, size_t size);
+
+    void close();
+
+    bool isOpen() const { return _data != nullptr; }
+    int getEntryCount() const { return static_cast<int>(_entries.size()); }
+
+    /**
+     * \return The texture, nullptr if the bundle does not have it
+     */
+    const unsigned char* find(const std::string& name, size_t& size) const;
+
+    /**
+     * \brief Write a bundle, for the cooker
+     * \param textures name and bytes of each texture
+     */
+    static bool write(const std::string& path, const std::vector<std::pair<std::string, std::vector<unsigned char>>>& textures);
+
+private:
+    const unsigned char* _data;
+    size_t _size;
+    std::vector<TextureBundleEntry> _entries;
+    // whether _data is a mapping to undo in close()
+    bool _mapped;
+#ifdef _WIN32
+    void* _mapping;
+#endif
+};
@@ -0,0 +1,66 @@
+﻿#include "TouchPredictor.h"
+#include <cmath>
+
+// weight of the newest sample in the smoothed velocity
+#define VELOCITY_SMOOTHING 0.5f
+// samples closer than this come from the same hardware report, they carry no velocity
+#define MIN_SAMPLE_INTERVAL 0.001f
+
+TouchPredictor::TouchPredictor()
+{
+    reset();
+}
+
+void TouchPredictor::reset()
+{
+    _sampleCount = 0;
+    _x = 0.0f;
+    _y = 0.0f;
+    _vx = 0.0f;
+    _vy = 0.0f;
+}
+
+void TouchPredictor::addSample(float x, float y, std::chrono::steady_clock::time_point time)
+{
+    if (_sampleCount > 0)
+    {
+        const auto dt = std::chrono::duration<float>(time - _time).count();
+        if (dt < MIN_SAMPLE_INTERVAL)
+        {
+            _x = x;
+            _y = y;
+            return;
+        }
+        const auto vx = (x - _x) / dt;
+        const auto vy = (y - _y) / dt;
+        // the first velocity is taken as it is, later ones are smoothed
+        const auto weight = _sampleCount == 1 ? 1.0f : VELOCITY_SMOOTHING;
+        _vx += (vx - _vx) * weight;
+        _vy += (vy - _vy) * weight;
+    }
+    _x = x;
+    _y = y;
+    _time = time;
+    ++_sampleCount;
+}
+
+void TouchPredictor::predict(std::chrono::steady_clock::time_point time, float maxDistance, float& x, float& y) const
+{
+    x = _x;
+    y = _y;
+    if (_sampleCount < 2 || time <= _time)
+    {
+        return;
+    }
+    const auto dt = std::chrono::duration<float>(time - _time).count();
+    auto dx = _vx * dt;
+    auto dy = _vy * dt;
+    const auto distance = std::sqrt(dx * dx + dy * dy);
+    if (distance > maxDistance)
+    {
+        dx *= maxDistance / distance;
+        dy *= maxDistance / distance;
+    }
+    x += dx;
+    y += dy;
+}
@@ -0,0 +1,36 @@
+﻿#pragma once
+#include <chrono>
+
+/**
+ * \brief Extrapolates a finger from its last samples, to draw the mallet where the finger is now
+ * rather than where it was when the touch was sampled.
+ *
+ * The velocity is smoothed over the samples, so one noisy sample does not throw the mallet.
+ * It does not depend on cocos2d.
+ */
+class TouchPredictor
+{
+public:
+    TouchPredictor();
+
+    /**
+     * \brief Forget the samples, call when a new touch starts
+     */
+    void reset();
+
+    void addSample(float x, float y, std::chrono::steady_clock::time_point time);
+
+    /**
+     * \brief Where the finger is expected at the given time
+     * \param maxDistance The prediction goes at most this far from the last sample
+     */
+    void predict(std::chrono::steady_clock::time_point time, float maxDistance, float& x, float& y) const;
+
+private:
+    int _sampleCount;
+    float _x;
+    float _y;
+    float _vx;
+    float _vy;
+    std::chrono::steady_clock::time_point _time;
+};
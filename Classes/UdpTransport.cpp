@@ -0,0 +1,206 @@
+﻿#include "UdpTransport.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#define INVALID_UDP_SOCKET INVALID_SOCKET
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define INVALID_UDP_SOCKET -1
+#define closeSocket ::close
+#endif
+
+static_assert(sizeof(sockaddr_in) <= 16, "UdpTransport::_remote is too small for sockaddr_in");
+
+UdpTransport::UdpTransport()
+{
+    _socket = INVALID_UDP_SOCKET;
+    memset(_remote, 0, sizeof(_remote));
+    _hasRemote = false;
+    _latencyMs = 0.0f;
+    _jitterMs = 0.0f;
+    _lossRate = 0.0f;
+}
+
+UdpTransport::~UdpTransport()
+{
+    close();
+}
+
+bool UdpTransport::open(unsigned short localPort)
+{
+    close();
+#ifdef _WIN32
+    WSADATA data;
+    if (WSAStartup(MAKEWORD(2, 2), &data) != 0)
+    {
+        return false;
+    }
+#endif
+    _socket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (_socket == INVALID_UDP_SOCKET)
+    {
+        return false;
+    }
+
+    // receive() polls once per frame, it must never block the game
+#ifdef _WIN32
+    u_long nonBlocking = 1;
+    ioctlsocket(_socket, FIONBIO, &nonBlocking);
+#else
+    fcntl(_socket, F_SETFL, fcntl(_socket, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(localPort);
+    if (bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void UdpTransport::close()
+{
+    if (_socket != INVALID_UDP_SOCKET)
+    {
+        closeSocket(_socket);
+        _socket = INVALID_UDP_SOCKET;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+    }
+    _hasRemote = false;
+    _delayed.clear();
+}
+
+unsigned short UdpTransport::getLocalPort() const
+{
+    sockaddr_in address;
+    socklen_t size = sizeof(address);
+    if (_socket == INVALID_UDP_SOCKET || getsockname(_socket, reinterpret_cast<sockaddr*>(&address), &size) != 0)
+    {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+bool UdpTransport::setRemote(const std::string& host, unsigned short port)
+{
+    addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result)
+    {
+        return false;
+    }
+    sockaddr_in address;
+    memcpy(&address, result->ai_addr, sizeof(address));
+    freeaddrinfo(result);
+    address.sin_port = htons(port);
+    memcpy(_remote, &address, sizeof(address));
+    _hasRemote = true;
+    return true;
+}
+
+void UdpTransport::simulate(float latencyMs, float jitterMs, float lossRate, unsigned int seed)
+{
+    _latencyMs = latencyMs;
+    _jitterMs = jitterMs;
+    _lossRate = lossRate;
+    _random.seed(seed);
+}
+
+void UdpTransport::send(const void* data, size_t size)
+{
+    if (_latencyMs <= 0.0f && _jitterMs <= 0.0f && _lossRate <= 0.0f)
+    {
+        sendNow(data, size);
+        return;
+    }
+
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    if (chance(_random) < _lossRate)
+    {
+        return;
+    }
+    const auto delayMs = _latencyMs + _jitterMs * chance(_random);
+    DelayedPacket packet;
+    packet.due = std::chrono::steady_clock::now()
+        + std::chrono::microseconds(static_cast<long long>(delayMs * 1000.0f));
+    packet.data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    _delayed.push_back(std::move(packet));
+    sendDue();
+}
+
+size_t UdpTransport::receive(void* buffer, size_t capacity)
+{
+    sendDue();
+    if (_socket == INVALID_UDP_SOCKET)
+    {
+        return 0;
+    }
+    for (;;)
+    {
+        sockaddr_in source;
+        socklen_t sourceSize = sizeof(source);
+        const auto size = recvfrom(_socket, static_cast<char*>(buffer), static_cast<int>(capacity), 0,
+            reinterpret_cast<sockaddr*>(&source), &sourceSize);
+        if (size <= 0)
+        {
+            return 0;
+        }
+        // the port is open to anyone, only the remote plays this match
+        sockaddr_in remote;
+        memcpy(&remote, _remote, sizeof(remote));
+        if (_hasRemote && source.sin_family == AF_INET && source.sin_addr.s_addr == remote.sin_addr.s_addr
+            && source.sin_port == remote.sin_port)
+        {
+            return static_cast<size_t>(size);
+        }
+    }
+}
+
+void UdpTransport::sendNow(const void* data, size_t size)
+{
+    if (_socket == INVALID_UDP_SOCKET || !_hasRemote)
+    {
+        return;
+    }
+    sockaddr_in remote;
+    memcpy(&remote, _remote, sizeof(remote));
+    sendto(_socket, static_cast<const char*>(data), static_cast<int>(size), 0,
+        reinterpret_cast<const sockaddr*>(&remote), sizeof(remote));
+}
+
+void UdpTransport::sendDue()
+{
+    const auto now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < _delayed.size();)
+    {
+        if (_delayed[i].due <= now)
+        {
+            sendNow(_delayed[i].data.data(), _delayed[i].data.size());
+            _delayed[i] = std::move(_delayed.back());
+            _delayed.pop_back();
+        }
+        else
+        {
+            ++i;
+        }
+    }
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Non-blocking UDP socket between two devices, with an optional bad network simulator.
+ *
+ * The simulator delays every sent packet by a latency plus a random jitter and drops some of them,
+ * so netcode can be tried on loopback as if it ran over a mobile network. Jitter also reorders packets.
+ * It does not depend on cocos2d.
+ */
+class UdpTransport
+{
+public:
+    UdpTransport();
+    ~UdpTransport();
+
+    /**
+     * \brief Bind the local port, 0 for any free port
+     */
+    bool open(unsigned short localPort);
+    void close();
+
+    /**
+     * \brief Port bound by open(), useful when it was 0
+     */
+    unsigned short getLocalPort() const;
+
+    /**
+     * \brief Where send() goes, host is an IPv4 address or a host name
+     */
+    bool setRemote(const std::string& host, unsigned short port);
+
+    /**
+     * \brief Simulate a bad network on the packets sent from here, all 0 to turn it off
+     * \param latencyMs Delay of every packet
+     * \param jitterMs A random extra delay between 0 and jitterMs
+     * \param lossRate Fraction of the packets that are dropped
+     */
+    void simulate(float latencyMs, float jitterMs, float lossRate, unsigned int seed);
+
+    void send(const void* data, size_t size);
+
+    /**
+     * \brief Next packet received from the remote, also sends the delayed packets that are due.
+     * Packets from other hosts or ports are dropped.
+     * \return Packet size, 0 when nothing was received
+     */
+    size_t receive(void* buffer, size_t capacity);
+
+private:
+    struct DelayedPacket
+    {
+        std::chrono::steady_clock::time_point due;
+        std::vector<char> data;
+    };
+
+    void sendNow(const void* data, size_t size);
+    void sendDue();
+
+#ifdef _WIN32
+    typedef uintptr_t Socket;
+#else
+    typedef int Socket;
+#endif
+    Socket _socket;
+    // sockaddr_in of the remote, kept as bytes so the socket headers stay out of this header
+    char _remote[16];
+    bool _hasRemote;
+
+    float _latencyMs;
+    float _jitterMs;
+    float _lossRate;
+    std::mt19937 _random;
+    std::vector<DelayedPacket> _delayed;
+};
@@ -15,6 +15,11 @@ macro (SelectModule)
   set(BUILD_LUA_TESTS_DEFAULT ON)
   set(BUILD_JS_LIBS_DEFAULT ON)
   set(BUILD_JS_TESTS_DEFAULT ON)
+  # the benchmarks open a desktop window for their GL context
+  set(BUILD_COCOS2D_BENCH_DEFAULT ON)
+  if(ANDROID OR IOS OR WINRT OR WP8)
+    set(BUILD_COCOS2D_BENCH_DEFAULT OFF)
+  endif()
   # TODO: fix test samples for MSVC
   if(MSVC)
     set(BUILD_CPP_EMPTY_TEST_DEFAULT OFF)
@@ -43,6 +48,7 @@ macro (SelectModule)
   option(BUILD_LUA_TESTS "Build TestLua samples" ${BUILD_LUA_TESTS_DEFAULT})
   option(BUILD_JS_LIBS "Build js libraries" ${BUILD_JS_LIBS_DEFAULT})
   option(BUILD_JS_TESTS "Build TestJS samples" ${BUILD_JS_TESTS_DEFAULT})
+  option(BUILD_COCOS2D_BENCH "Build the cocos2d_bench engine benchmarks" ${BUILD_COCOS2D_BENCH_DEFAULT})
   option(USE_PREBUILT_LIBS "Use prebuilt libraries in external directory" ${USE_PREBUILT_LIBS_DEFAULT})
   option(USE_SOURCES_EXTERNAL "Use sources in external directory (automatically ON when USE_PREBUILT_LIBS is ON)" OFF)
 
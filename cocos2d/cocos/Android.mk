@@ -132,6 +132,10 @@ base/CCEventListenerMouse.cpp \
 base/CCEventListenerTouch.cpp \
 base/CCEventMouse.cpp \
 base/CCEventTouch.cpp \
+base/CCFrameStats.cpp \
+base/CCFrameTelemetry.cpp \
+base/CCDispatchQueue.cpp \
+base/CCFrameArena.cpp \
 base/CCIMEDispatcher.cpp \
 base/CCNS.cpp \
 base/CCProfiling.cpp \
@@ -1,5 +1,4 @@
 /****************************************************************************
-Copyright (c) 2010      cocos2d-x.org
 Copyright (c) 2013-2017 Chukong Technologies Inc.
 
 http://www.cocos2d-x.org
@@ -24,11 +23,79 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "base/CCAsyncTaskPool.h"
+#include <algorithm>
+#include <deque>
 
 NS_CC_BEGIN
 
 AsyncTaskPool* AsyncTaskPool::s_asyncTaskPool = nullptr;
 
+struct AsyncTaskPool::TaskNode
+{
+    TaskNode()
+    : priority(Priority::NORMAL)
+    , serialLane(-1)
+    , waitingFor(1)
+    , finished(false)
+    {
+    }
+
+    std::function<void()> work;
+    Priority priority;
+    // its lane when it is serial, -1 otherwise
+    int serialLane;
+    CancellationToken token;
+    CancellationToken laneToken;
+    std::function<void()> callback;
+    // dependencies not finished yet, plus one while submitTask() registers them
+    std::atomic<int> waitingFor;
+
+    std::mutex mutex;
+    bool finished;
+    std::vector<TaskHandle> dependents;
+};
+
+struct AsyncTaskPool::Worker
+{
+    std::mutex mutex;
+    std::deque<TaskHandle> queues[int(Priority::MAX_PRIORITY)];
+    std::thread thread;
+};
+
+// the callbacks of the finished tasks, performed in one batch on the cocos thread
+struct AsyncTaskPool::Completions
+{
+    std::mutex mutex;
+    std::vector<std::function<void()>> callbacks;
+    // cocos thread only
+    std::vector<std::function<void()>> performing;
+
+    void perform()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            performing.swap(callbacks);
+        }
+        for (const auto& callback : performing)
+        {
+            callback();
+        }
+        performing.clear();
+    }
+};
+
+AsyncTaskPool::CancellationToken::CancellationToken()
+: _cancelled(std::make_shared<std::atomic<bool>>(false))
+{
+}
+
+AsyncTaskPool::TaskOptions::TaskOptions()
+: type(TaskType::TASK_OTHER)
+, priority(Priority::NORMAL)
+, serial(false)
+{
+}
+
 AsyncTaskPool* AsyncTaskPool::getInstance()
 {
     if (s_asyncTaskPool == nullptr)
@@ -45,11 +112,274 @@ void AsyncTaskPool::destroyInstance()
 }
 
 AsyncTaskPool::AsyncTaskPool()
+: _nextWorker(0)
+, _queuedTasks(0)
+, _stopping(false)
+, _completions(std::make_shared<Completions>())
 {
+    for (int i = 0; i < int(TaskType::TASK_MAX_TYPE); ++i)
+    {
+        _serialRunning[i] = false;
+    }
+
+    // the cocos thread keeps a core, and a task blocked on IO must not stop the others on a single core
+    const auto threadCount = std::max(2, static_cast<int>(std::thread::hardware_concurrency()) - 1);
+    for (int i = 0; i < threadCount; ++i)
+    {
+        _workers.push_back(std::unique_ptr<Worker>(new (std::nothrow) Worker()));
+    }
+
+    // the workers wait for every thread to be created before looking for work
+    std::lock_guard<std::mutex> lock(_sleepMutex);
+    for (int i = 0; i < threadCount; ++i)
+    {
+        _workers[i]->thread = std::thread(&AsyncTaskPool::workerLoop, this, i);
+    }
 }
 
 AsyncTaskPool::~AsyncTaskPool()
 {
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+        _stopping = true;
+    }
+    _wakeUp.notify_all();
+
+    // the workers stop once every task submitted ran, or was cancelled
+    for (auto& worker : _workers)
+    {
+        worker->thread.join();
+    }
+}
+
+void AsyncTaskPool::stopTasks(TaskType type)
+{
+    std::lock_guard<std::mutex> lock(_laneMutex);
+    // the waiting tasks of the lane keep the cancelled token, the next ones get a new one
+    _laneTokens[(int)type].cancel();
+    _laneTokens[(int)type] = CancellationToken();
+}
+
+void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, TaskCallBack callback, void* callbackParam, std::function<void()> task)
+{
+    TaskOptions options;
+    options.type = type;
+    // each lane had its own thread, the callers rely on their tasks running in order
+    options.serial = true;
+    if (callback)
+    {
+        options.callback = std::bind(std::move(callback), callbackParam);
+    }
+    submitTask(std::move(task), options);
+}
+
+void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, std::function<void()> task)
+{
+    enqueue(type, nullptr, nullptr, std::move(task));
+}
+
+AsyncTaskPool::TaskHandle AsyncTaskPool::submitTask(std::function<void()> work, const TaskOptions& options)
+{
+    auto task = std::make_shared<TaskNode>();
+    task->work = std::move(work);
+    task->priority = options.priority;
+    task->token = options.token;
+    task->callback = options.callback;
+    if (options.serial || options.type == TaskType::TASK_IO)
+    {
+        task->serialLane = (int)options.type;
+    }
+    {
+        std::lock_guard<std::mutex> lock(_laneMutex);
+        task->laneToken = _laneTokens[(int)options.type];
+    }
+
+    for (const auto& dependency : options.dependencies)
+    {
+        if (dependency)
+        {
+            std::lock_guard<std::mutex> lock(dependency->mutex);
+            if (! dependency->finished)
+            {
+                ++task->waitingFor;
+                dependency->dependents.push_back(task);
+            }
+        }
+    }
+    // the last dependency to finish schedules it, or this
+    if (--task->waitingFor == 0)
+    {
+        schedule(task);
+    }
+    return task;
+}
+
+int AsyncTaskPool::currentWorker() const
+{
+    const auto id = std::this_thread::get_id();
+    for (size_t i = 0; i < _workers.size(); ++i)
+    {
+        if (_workers[i]->thread.get_id() == id)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+void AsyncTaskPool::schedule(const TaskHandle& task)
+{
+    if (task->serialLane >= 0)
+    {
+        std::lock_guard<std::mutex> lock(_laneMutex);
+        if (_serialRunning[task->serialLane])
+        {
+            // run() pushes it once the tasks before it finished
+            _serialTasks[task->serialLane].push_back(task);
+            return;
+        }
+        _serialRunning[task->serialLane] = true;
+    }
+    push(task);
+}
+
+void AsyncTaskPool::push(const TaskHandle& task)
+{
+    // a worker queues the tasks it makes ready itself, the other threads spread theirs
+    auto index = currentWorker();
+    if (index < 0)
+    {
+        index = static_cast<int>(_nextWorker.fetch_add(1, std::memory_order_relaxed) % _workers.size());
+    }
+    {
+        auto& worker = *_workers[index];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queues[(int)task->priority].push_back(task);
+    }
+    _queuedTasks.fetch_add(1);
+
+    {
+        // a worker that just found nothing to do is waiting, or still holds the mutex and will see the task
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    _wakeUp.notify_one();
+}
+
+AsyncTaskPool::TaskHandle AsyncTaskPool::take(int index)
+{
+    if (_queuedTasks.load() == 0)
+    {
+        return nullptr;
+    }
+
+    // by priority, from its own queues first, then the others'; the oldest task of a queue first
+    const auto count = static_cast<int>(_workers.size());
+    for (int priority = 0; priority < int(Priority::MAX_PRIORITY); ++priority)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            auto& worker = *_workers[(index + i) % count];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            auto& queue = worker.queues[priority];
+            if (! queue.empty())
+            {
+                auto task = std::move(queue.front());
+                queue.pop_front();
+                _queuedTasks.fetch_sub(1);
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void AsyncTaskPool::run(const TaskHandle& task)
+{
+    const auto cancelled = task->token.isCancelled() || task->laneToken.isCancelled();
+    if (! cancelled)
+    {
+        task->work();
+    }
+    // a task dropped without running breaks the promise of its result here
+    task->work = nullptr;
+
+    if (! cancelled && task->callback)
+    {
+        auto first = false;
+        {
+            std::lock_guard<std::mutex> lock(_completions->mutex);
+            first = _completions->callbacks.empty();
+            _completions->callbacks.push_back(std::move(task->callback));
+        }
+        // one function performs every callback queued until the next frame
+        if (first)
+        {
+            auto completions = _completions;
+            Director::getInstance()->getScheduler()->performFunctionInCocosThread([completions]() {
+                completions->perform();
+            });
+        }
+    }
+
+    std::vector<TaskHandle> dependents;
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->finished = true;
+        dependents.swap(task->dependents);
+    }
+    for (const auto& dependent : dependents)
+    {
+        if (--dependent->waitingFor == 0)
+        {
+            schedule(dependent);
+        }
+    }
+
+    if (task->serialLane >= 0)
+    {
+        TaskHandle next;
+        {
+            std::lock_guard<std::mutex> lock(_laneMutex);
+            auto& waiting = _serialTasks[task->serialLane];
+            if (waiting.empty())
+            {
+                _serialRunning[task->serialLane] = false;
+            }
+            else
+            {
+                next = std::move(waiting.front());
+                waiting.pop_front();
+            }
+        }
+        if (next)
+        {
+            push(next);
+        }
+    }
+}
+
+void AsyncTaskPool::workerLoop(int index)
+{
+    {
+        std::lock_guard<std::mutex> lock(_sleepMutex);
+    }
+    for (;;)
+    {
+        auto task = take(index);
+        if (task)
+        {
+            run(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(_sleepMutex);
+        // a task still running queues the tasks waiting for it, the worker running it takes them
+        if (_stopping && _queuedTasks.load() == 0)
+        {
+            break;
+        }
+        _wakeUp.wait(lock, [this]() { return _stopping || _queuedTasks.load() > 0; });
+    }
 }
 
 NS_CC_END
@@ -28,7 +28,9 @@ THE SOFTWARE.
 #include "platform/CCPlatformMacros.h"
 #include "base/CCDirector.h"
 #include "base/CCScheduler.h"
+#include <atomic>
 #include <vector>
+#include <deque>
 #include <queue>
 #include <memory>
 #include <thread>
@@ -37,6 +39,7 @@ THE SOFTWARE.
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <type_traits>
 
 /**
 * @addtogroup base
@@ -48,6 +51,29 @@ NS_CC_BEGIN
 /**
  * @class AsyncTaskPool
  * @brief This class allows to perform background operations without having to manipulate threads.
+ *
+ * The tasks run on a pool of worker threads, one per core but the cocos thread's and at least two. Each worker
+ * has its own queues, one per priority, and a worker with nothing to do steals the oldest tasks of the others,
+ * so a burst of tasks, decoding assets for example, spreads over every core. A higher priority task always
+ * starts before a lower one, whichever queue it waits in.
+ *
+ * The serial tasks of a lane run one at a time, in the order they became ready, as they did when each lane
+ * had its own thread: the TASK_IO tasks and the tasks given to enqueue(), which FileUtils, Sprite3D and
+ * AssetsManagerEx rely on. Only the others run concurrently.
+ *
+ * A task can depend on other tasks, it starts once they finished, and a CancellationToken drops the tasks
+ * given it which have not started yet. The callbacks of the tasks which finished are called on the cocos
+ * thread in one batch per frame. Destroying the pool waits for every task already submitted.
+ *
+ * @code
+ * auto pool = AsyncTaskPool::getInstance();
+ * auto decode = pool->submit([path]() { return decodeImage(path); });
+ *
+ * AsyncTaskPool::TaskOptions options;
+ * options.dependencies.push_back(decode.handle);
+ * options.callback = []() { log("both done"); };
+ * pool->submit([]() { ... }, options);
+ * @endcode
  * @js NA
  */
 class CC_DLL AsyncTaskPool
@@ -55,6 +81,7 @@ class CC_DLL AsyncTaskPool
 public:
     typedef std::function<void(void*)> TaskCallBack;
     
+    /** The lane of a task: stopTasks() drops the waiting tasks of a lane. */
     enum class TaskType
     {
         TASK_IO,
@@ -63,6 +90,55 @@ public:
         TASK_MAX_TYPE,
     };
 
+    enum class Priority
+    {
+        HIGH,
+        NORMAL,
+        LOW,
+        MAX_PRIORITY,
+    };
+
+    /**
+     * Cancels the tasks it was given to: those which have not started are dropped, and a running task can
+     * poll isCancelled() to stop early. Copies share the same state.
+     */
+    class CC_DLL CancellationToken
+    {
+    public:
+        CancellationToken();
+        void cancel() { _cancelled->store(true, std::memory_order_release); }
+        bool isCancelled() const { return _cancelled->load(std::memory_order_acquire); }
+    private:
+        std::shared_ptr<std::atomic<bool>> _cancelled;
+    };
+
+    struct TaskNode;
+    /** Identifies a submitted task, for other tasks to depend on it. */
+    typedef std::shared_ptr<TaskNode> TaskHandle;
+
+    struct CC_DLL TaskOptions
+    {
+        TaskOptions();
+
+        TaskType type;
+        Priority priority;
+        /** Runs after the serial tasks of its lane which became ready before it, one at a time. Always for TASK_IO. */
+        bool serial;
+        CancellationToken token;
+        /** The task starts once these finished, whether they ran or were cancelled. */
+        std::vector<TaskHandle> dependencies;
+        /** Called on the cocos thread after the task ran, not when it was cancelled. */
+        std::function<void()> callback;
+    };
+
+    /** A submitted task: its handle, and the future of its result. A dropped task breaks the promise of its result. */
+    template <typename R>
+    struct Task
+    {
+        TaskHandle handle;
+        std::future<R> result;
+    };
+
     /**
      * Returns the shared instance of the async task pool.
      */
@@ -86,7 +162,7 @@ public:
     /**
      * Enqueue a asynchronous task.
      *
-     * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+     * @param type task type is io task, network task or others.
      * @param callback callback when the task is finished. The callback is called in the main thread instead of task thread.
      * @param callbackParam parameter used by the callback.
      * @param task: task can be lambda function to be performed off thread.
@@ -97,134 +173,70 @@ public:
     /**
     * Enqueue a asynchronous task.
     *
-    * @param type task type is io task, network task or others, each type of task has a thread to deal with it.
+    * @param type task type is io task, network task or others.
     * @param task: task can be lambda function to be performed off thread.
     * @lua NA
     */
     void enqueue(AsyncTaskPool::TaskType type, std::function<void()> task);
+
+    /**
+     * Submits a task, from any thread.
+     *
+     * @param task Function or lambda without parameters, what it returns is the result of the task.
+     * @lua NA
+     */
+    template <typename F>
+    Task<typename std::result_of<F()>::type> submit(F task, const TaskOptions& options = TaskOptions());
+
+    int getThreadCount() const { return static_cast<int>(_workers.size()); }
     
 CC_CONSTRUCTOR_ACCESS:
     AsyncTaskPool();
     ~AsyncTaskPool();
     
 protected:
-    
-    // thread tasks internally used
-    class ThreadTasks {
-        struct AsyncTaskCallBack
-        {
-            TaskCallBack          callback;
-            void*                 callbackParam;
-        };
-    public:
-        ThreadTasks()
-        : _stop(false)
-        {
-            _thread = std::thread(
-                                  [this]
-                                  {
-                                      for(;;)
-                                      {
-                                          std::function<void()> task;
-                                          AsyncTaskCallBack callback;
-                                          {
-                                              std::unique_lock<std::mutex> lock(this->_queueMutex);
-                                              this->_condition.wait(lock,
-                                                                    [this]{ return this->_stop || !this->_tasks.empty(); });
-                                              if(this->_stop && this->_tasks.empty())
-                                                  return;
-                                              task = std::move(this->_tasks.front());
-                                              callback = std::move(this->_taskCallBacks.front());
-                                              this->_tasks.pop();
-                                              this->_taskCallBacks.pop();
-                                          }
-                                          
-                                          task();
-                                          Director::getInstance()->getScheduler()->performFunctionInCocosThread(std::bind(callback.callback, callback.callbackParam));
-                                      }
-                                  }
-                                  );
-        }
-        ~ThreadTasks()
-        {
-            {
-                std::unique_lock<std::mutex> lock(_queueMutex);
-                _stop = true;
-                
-                while(_tasks.size())
-                    _tasks.pop();
-                while (_taskCallBacks.size())
-                    _taskCallBacks.pop();
-            }
-            _condition.notify_all();
-            _thread.join();
-        }
-        void clear()
-        {
-            std::unique_lock<std::mutex> lock(_queueMutex);
-            while(_tasks.size())
-                _tasks.pop();
-            while (_taskCallBacks.size())
-                _taskCallBacks.pop();
-        }
-
-        void enqueue(TaskCallBack callback, void* callbackParam, std::function<void()> task)
-        {
-            AsyncTaskCallBack taskCallBack;
-            taskCallBack.callback = std::move(callback);
-            taskCallBack.callbackParam = callbackParam;
-
-            {
-                std::unique_lock<std::mutex> lock(_queueMutex);
-                
-                // don't allow enqueueing after stopping the pool
-                if(_stop)
-                {
-                    CC_ASSERT(0 && "already stop");
-                    return;
-                }
-                
-                _tasks.push(std::move(task));
-                _taskCallBacks.push(std::move(taskCallBack));
-            }
-            _condition.notify_one();
-        }
-    private:
-        
-        // need to keep track of thread so we can join them
-        std::thread _thread;
-        // the task queue
-        std::queue< std::function<void()> > _tasks;
-        std::queue<AsyncTaskCallBack> _taskCallBacks;
-        
-        // synchronization
-        std::mutex _queueMutex;
-        std::condition_variable _condition;
-        bool _stop;
-    };
-    
-    //tasks
-    ThreadTasks _threadTasks[int(TaskType::TASK_MAX_TYPE)];
+    struct Worker;
+    struct Completions;
+
+    TaskHandle submitTask(std::function<void()> work, const TaskOptions& options);
+    void schedule(const TaskHandle& task);
+    void push(const TaskHandle& task);
+    TaskHandle take(int worker);
+    void run(const TaskHandle& task);
+    void workerLoop(int worker);
+    int currentWorker() const;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic<unsigned int> _nextWorker;
+    // tasks waiting in the queues of the workers
+    std::atomic<int> _queuedTasks;
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+    std::atomic<bool> _stopping;
+
+    std::mutex _laneMutex;
+    CancellationToken _laneTokens[int(TaskType::TASK_MAX_TYPE)];
+    // the serial tasks ready behind the one running of each lane
+    std::deque<TaskHandle> _serialTasks[int(TaskType::TASK_MAX_TYPE)];
+    bool _serialRunning[int(TaskType::TASK_MAX_TYPE)];
+
+    // shared with the batches waiting to be performed on the cocos thread, which may outlive the pool
+    std::shared_ptr<Completions> _completions;
     
     static AsyncTaskPool* s_asyncTaskPool;
 };
 
-inline void AsyncTaskPool::stopTasks(TaskType type)
-{
-    auto& threadTask = _threadTasks[(int)type];
-    threadTask.clear();
-}
-
-inline void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, TaskCallBack callback, void* callbackParam, std::function<void()> task)
-{
-    auto& threadTask = _threadTasks[(int)type];
-    
-    threadTask.enqueue(std::move(callback), callbackParam, std::move(task));
-}
-
-inline void AsyncTaskPool::enqueue(AsyncTaskPool::TaskType type, std::function<void()> task)
+template <typename F>
+AsyncTaskPool::Task<typename std::result_of<F()>::type> AsyncTaskPool::submit(F task, const TaskOptions& options)
 {
-    enqueue(type, [](void*) {}, nullptr, std::move(task));
+    typedef typename std::result_of<F()>::type Result;
+    // not running it breaks the promise
+    auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+
+    Task<Result> submitted;
+    submitted.result = packagedTask->get_future();
+    submitted.handle = submitTask([packagedTask]() { (*packagedTask)(); }, options);
+    return submitted;
 }
 
 NS_CC_END
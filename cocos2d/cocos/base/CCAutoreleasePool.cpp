@@ -65,11 +65,24 @@ void AutoreleasePool::clear()
 #if defined(COCOS2D_DEBUG) && (COCOS2D_DEBUG > 0)
     _isClearing = true;
 #endif
-    std::vector<Ref*> releasings;
-    releasings.swap(_managedObjectArray);
-    for (const auto &obj : releasings)
+    if (_releasingObjectArray.empty())
     {
-        obj->release();
+        _releasingObjectArray.swap(_managedObjectArray);
+        for (const auto &obj : _releasingObjectArray)
+        {
+            obj->release();
+        }
+        _releasingObjectArray.clear();
+    }
+    else
+    {
+        // cleared again by a destructor while clearing
+        std::vector<Ref*> releasings;
+        releasings.swap(_managedObjectArray);
+        for (const auto &obj : releasings)
+        {
+            obj->release();
+        }
     }
 #if defined(COCOS2D_DEBUG) && (COCOS2D_DEBUG > 0)
     _isClearing = false;
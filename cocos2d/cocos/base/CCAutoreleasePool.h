@@ -133,6 +133,12 @@ private:
      * is in the pool.
      */
     std::vector<Ref*> _managedObjectArray;
+    /**
+     * The objects being released by clear(). It trades places with
+     * _managedObjectArray, so that neither array gives its memory back and
+     * the pool does not grow again every frame.
+     */
+    std::vector<Ref*> _releasingObjectArray;
     std::string _name;
     
 #if defined(COCOS2D_DEBUG) && (COCOS2D_DEBUG > 0)
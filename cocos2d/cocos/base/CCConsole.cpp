@@ -62,6 +62,7 @@
 #include "base/CCScheduler.h"
 #include "platform/CCPlatformConfig.h"
 #include "base/CCConfiguration.h"
+#include "base/CCFrameTelemetry.h"
 #include "2d/CCScene.h"
 #include "platform/CCFileUtils.h"
 #include "renderer/CCTextureCache.h"
@@ -407,6 +408,7 @@ Console::Console()
     createCommandConfig();
     createCommandDebugMsg();
     createCommandDirector();
+    createCommandDispatch();
     createCommandExit();
     createCommandFileUtils();
     createCommandFps();
@@ -414,6 +416,7 @@ Console::Console()
     createCommandProjection();
     createCommandResolution();
     createCommandSceneGraph();
+    createCommandTelemetry();
     createCommandTexture();
     createCommandTouch();
     createCommandUpload();
@@ -945,6 +948,12 @@ void Console::createCommandDirector()
         CC_CALLBACK_2(Console::commandDirectorSubCommandEnd, this)});
 }
 
+void Console::createCommandDispatch()
+{
+    addCommand({"dispatch", "Print the queue of the functions performed in the cocos thread.",
+        CC_CALLBACK_2(Console::commandDispatch, this)});
+}
+
 void Console::createCommandExit()
 {
     addCommand({"exit", "Close connection to the console. Args: [-h | help | ]", CC_CALLBACK_2(Console::commandExit, this)});
@@ -992,6 +1001,18 @@ void Console::createCommandSceneGraph()
     addCommand({"scenegraph", "Print the scene graph", CC_CALLBACK_2(Console::commandSceneGraph, this)});
 }
 
+void Console::createCommandTelemetry()
+{
+    addCommand({"telemetry", "Record frame timings and markers, and save them. Args: [-h | help | start | stop | save | ]",
+        CC_CALLBACK_2(Console::commandTelemetry, this)});
+    addSubCommand("telemetry", {"start", "telemetry start [frames]: record at most frames frames, 3600 by default.",
+        CC_CALLBACK_2(Console::commandTelemetrySubCommandStart, this)});
+    addSubCommand("telemetry", {"stop", "Stop recording.",
+        CC_CALLBACK_2(Console::commandTelemetrySubCommandStop, this)});
+    addSubCommand("telemetry", {"save", "telemetry save [file]: save to file in the writable path, as CSV if it ends with .csv, else as a Chrome trace.",
+        CC_CALLBACK_2(Console::commandTelemetrySubCommandSave, this)});
+}
+
 void Console::createCommandTexture()
 {
     addCommand({"texture", "Flush or print the TextureCache info. Args: [-h | help | flush | ] ",
@@ -1088,6 +1109,20 @@ void Console::commandDirectorSubCommandEnd(int /*fd*/, const std::string& /*args
     director->end();
 }
 
+void Console::commandDispatch(int fd, const std::string& /*args*/)
+{
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [fd, sched](){
+        // the stats of the frame before, this function is being performed in this one
+        const auto& stats = sched->getDispatchQueue().getStats();
+        Console::Utility::mydprintf(fd, "Last frame: %u performed in %.3f ms, %u left%s, budget %.3f ms\n",
+            stats.performed, stats.milliseconds, stats.depth, stats.overBudget ? " over budget" : "", sched->getDispatchBudget() * 1000.0f);
+        Console::Utility::mydprintf(fd, "Total: %llu performed, max depth %u, %u frames over budget, %u overflowed\n",
+            static_cast<unsigned long long>(stats.performedCount), stats.maxDepth, stats.overBudgetCount, stats.overflowCount);
+        Console::Utility::sendPrompt(fd);
+    });
+}
+
 void Console::commandExit(int fd, const std::string& /*args*/)
 {
     FD_CLR(fd, &_read_set);
@@ -1215,6 +1250,63 @@ void Console::commandSceneGraph(int fd, const std::string& /*args*/)
     sched->performFunctionInCocosThread( std::bind(&Console::printSceneGraphBoot, this, fd) );
 }
 
+void Console::commandTelemetry(int fd, const std::string& /*args*/)
+{
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [fd](){
+        auto telemetry = FrameTelemetry::getInstance();
+        Console::Utility::mydprintf(fd, "Telemetry is: %s, %d frames, %d markers, %d dropped\n",
+            telemetry->isRecording() ? "recording" : "stopped",
+            telemetry->getFrameCount(), telemetry->getMarkerCount(), telemetry->getDroppedCount());
+        Console::Utility::sendPrompt(fd);
+    });
+}
+
+void Console::commandTelemetrySubCommandStart(int fd, const std::string& args)
+{
+    auto argv = Console::Utility::split(args, ' ');
+    int frames = FrameTelemetry::DEFAULT_MAX_FRAMES;
+    if (argv.size() == 2 && Console::Utility::isFloat(argv[1]))
+    {
+        frames = static_cast<int>(utils::atof(argv[1].c_str()));
+    }
+    else if (argv.size() != 1)
+    {
+        const char msg[] = "telemetry: invalid arguments.\n";
+        Console::Utility::sendToConsole(fd, msg, strlen(msg));
+        return;
+    }
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [frames](){
+        FrameTelemetry::getInstance()->start(frames);
+    });
+}
+
+void Console::commandTelemetrySubCommandStop(int /*fd*/, const std::string& /*args*/)
+{
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [](){
+        FrameTelemetry::getInstance()->stop();
+    });
+}
+
+void Console::commandTelemetrySubCommandSave(int fd, const std::string& args)
+{
+    auto argv = Console::Utility::split(args, ' ');
+    std::string filename = argv.size() > 1 ? argv[1] : "telemetry.json";
+    auto path = FileUtils::getInstance()->isAbsolutePath(filename) ? filename : FileUtils::getInstance()->getWritablePath() + filename;
+    const bool csv = path.size() > 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+
+    // the buffers belong to the cocos thread
+    Scheduler *sched = Director::getInstance()->getScheduler();
+    sched->performFunctionInCocosThread( [fd, path, csv](){
+        auto telemetry = FrameTelemetry::getInstance();
+        const bool saved = csv ? telemetry->saveCSV(path) : telemetry->saveChromeTrace(path);
+        Console::Utility::mydprintf(fd, saved ? "Telemetry saved to %s\n" : "Can not save telemetry to %s\n", path.c_str());
+        Console::Utility::sendPrompt(fd);
+    });
+}
+
 void Console::commandTextures(int fd, const std::string& /*args*/)
 {
     Scheduler *sched = Director::getInstance()->getScheduler();
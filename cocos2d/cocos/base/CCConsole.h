@@ -200,6 +200,7 @@ protected:
     void createCommandConfig();
     void createCommandDebugMsg();
     void createCommandDirector();
+    void createCommandDispatch();
     void createCommandExit();
     void createCommandFileUtils();
     void createCommandFps();
@@ -207,6 +208,7 @@ protected:
     void createCommandProjection();
     void createCommandResolution();
     void createCommandSceneGraph();
+    void createCommandTelemetry();
     void createCommandTexture();
     void createCommandTouch();
     void createCommandUpload();
@@ -222,6 +224,7 @@ protected:
     void commandDirectorSubCommandStop(int fd, const std::string& args);
     void commandDirectorSubCommandStart(int fd, const std::string& args);
     void commandDirectorSubCommandEnd(int fd, const std::string& args);
+    void commandDispatch(int fd, const std::string& args);
     void commandExit(int fd, const std::string& args);
     void commandFileUtils(int fd, const std::string& args);
     void commandFileUtilsSubCommandFlush(int fd, const std::string& args);
@@ -234,6 +237,10 @@ protected:
     void commandResolution(int fd, const std::string& args);
     void commandResolutionSubCommandEmpty(int fd, const std::string& args);
     void commandSceneGraph(int fd, const std::string& args);
+    void commandTelemetry(int fd, const std::string& args);
+    void commandTelemetrySubCommandStart(int fd, const std::string& args);
+    void commandTelemetrySubCommandStop(int fd, const std::string& args);
+    void commandTelemetrySubCommandSave(int fd, const std::string& args);
     void commandTextures(int fd, const std::string& args);
     void commandTexturesSubCommandFlush(int fd, const std::string& args);
     void commandTouchSubCommandTap(int fd, const std::string& args);
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 // standard includes
 #include <string>
+#include <algorithm>
 
 #include "2d/CCDrawingPrimitives.h"
 #include "2d/CCSpriteFrameCache.h"
@@ -42,6 +43,7 @@ THE SOFTWARE.
 #include "2d/CCTransition.h"
 #include "2d/CCFontFreeType.h"
 #include "2d/CCLabelAtlas.h"
+#include "2d/CCDrawNode.h"
 #include "renderer/CCGLProgramCache.h"
 #include "renderer/CCGLProgramStateCache.h"
 #include "renderer/CCTextureCache.h"
@@ -58,6 +60,7 @@ THE SOFTWARE.
 #include "base/CCEventCustom.h"
 #include "base/CCConsole.h"
 #include "base/CCAutoreleasePool.h"
+#include "base/CCFrameArena.h"
 #include "base/CCConfiguration.h"
 #include "base/CCAsyncTaskPool.h"
 #include "platform/CCApplication.h"
@@ -135,6 +138,8 @@ bool Director::init(void)
     _accumDt = 0.0f;
     _frameRate = 0.0f;
     _FPSLabel = _drawnBatchesLabel = _drawnVerticesLabel = nullptr;
+    std::fill(std::begin(_frameStatsLabels), std::end(_frameStatsLabels), nullptr);
+    _frameTimeHistogram = nullptr;
     _totalFrames = 0;
     _lastUpdate = std::chrono::steady_clock::now();
     
@@ -144,6 +149,9 @@ bool Director::init(void)
     // paused ?
     _paused = false;
 
+    // idle ?
+    _idle = false;
+
     // purge ?
     _purgeDirectorInNextLoop = false;
     
@@ -207,6 +215,11 @@ Director::~Director(void)
     CC_SAFE_RELEASE(_FPSLabel);
     CC_SAFE_RELEASE(_drawnVerticesLabel);
     CC_SAFE_RELEASE(_drawnBatchesLabel);
+    for (auto label : _frameStatsLabels)
+    {
+        CC_SAFE_RELEASE(label);
+    }
+    CC_SAFE_RELEASE(_frameTimeHistogram);
 
     CC_SAFE_RELEASE(_runningScene);
     CC_SAFE_RELEASE(_notificationNode);
@@ -240,7 +253,7 @@ void Director::setDefaultValues(void)
 
     // default FPS
     double fps = conf->getValue("cocos2d.x.fps", Value(kDefaultFPS)).asDouble();
-    _oldAnimationInterval = _animationInterval = 1.0 / fps;
+    _awakeAnimationInterval = _oldAnimationInterval = _animationInterval = 1.0 / fps;
 
     // Display FPS
     _displayStats = conf->getValue("cocos2d.x.display_fps", Value(false)).asBool();
@@ -285,6 +298,7 @@ void Director::drawScene()
 {
     // calculate "global" dt
     calculateDeltaTime();
+    _frameStats.beginFrame();
     
     if (_openGLView)
     {
@@ -294,9 +308,11 @@ void Director::drawScene()
     //tick before glClear: issue #533
     if (! _paused)
     {
+        _frameStats.begin(FrameStats::Section::UPDATE);
         _eventDispatcher->dispatchEvent(_eventBeforeUpdate);
         _scheduler->update(_deltaTime);
         _eventDispatcher->dispatchEvent(_eventAfterUpdate);
+        _frameStats.end();
     }
 
     _renderer->clear();
@@ -317,21 +333,27 @@ void Director::drawScene()
     if (_runningScene)
     {
 #if (CC_USE_PHYSICS || (CC_USE_3D_PHYSICS && CC_ENABLE_BULLET_INTEGRATION) || CC_USE_NAVMESH)
+        _frameStats.begin(FrameStats::Section::PHYSICS);
         _runningScene->stepPhysicsAndNavigation(_deltaTime);
+        _frameStats.end();
 #endif
         //clear draw stats
         _renderer->clearDrawStats();
         
-        //render the scene
+        //render the scene, the renderer times its own sort and flush
+        _frameStats.begin(FrameStats::Section::VISIT);
         _openGLView->renderScene(_runningScene, _renderer);
         
         _eventDispatcher->dispatchEvent(_eventAfterVisit);
+        _frameStats.end();
     }
 
     // draw the notifications node
     if (_notificationNode)
     {
+        _frameStats.begin(FrameStats::Section::VISIT);
         _notificationNode->visit(_renderer, Mat4::IDENTITY, 0);
+        _frameStats.end();
     }
 
     updateFrameRate();
@@ -354,7 +376,9 @@ void Director::drawScene()
     // swap buffers
     if (_openGLView)
     {
+        _frameStats.begin(FrameStats::Section::SWAP);
         _openGLView->swapBuffers();
+        _frameStats.end();
     }
 
     if (_displayStats)
@@ -363,6 +387,8 @@ void Director::drawScene()
         calculateMPF();
 #endif
     }
+
+    _frameStats.endFrame();
 }
 
 void Director::calculateDeltaTime()
@@ -1091,6 +1117,11 @@ void Director::reset()
     CC_SAFE_RELEASE_NULL(_FPSLabel);
     CC_SAFE_RELEASE_NULL(_drawnBatchesLabel);
     CC_SAFE_RELEASE_NULL(_drawnVerticesLabel);
+    for (auto& label : _frameStatsLabels)
+    {
+        CC_SAFE_RELEASE_NULL(label);
+    }
+    CC_SAFE_RELEASE_NULL(_frameTimeHistogram);
     
     // purge bitmap cache
     FontFNT::purgeCachedData();
@@ -1226,7 +1257,9 @@ void Director::pause()
         return;
     }
 
-    _oldAnimationInterval = _animationInterval;
+    // resume() returns to the frame rate of the game, not to the idle one
+    _oldAnimationInterval = _idle ? _awakeAnimationInterval : _animationInterval;
+    _idle = false;
 
     // when paused, don't consume CPU
     setAnimationInterval(1 / 4.0, SetIntervalReason::BY_DIRECTOR_PAUSE);
@@ -1248,6 +1281,39 @@ void Director::resume()
     setNextDeltaTimeZero(true);
 }
 
+void Director::requestFrameRate(float framesPerSecond)
+{
+    if (framesPerSecond <= 0)
+    {
+        wakeUp();
+        return;
+    }
+    if (_paused)
+    {
+        return;
+    }
+
+    if (! _idle)
+    {
+        _awakeAnimationInterval = _animationInterval;
+        _idle = true;
+    }
+    // the same path as pause(), the platforms already treat it as a temporary lower frame rate
+    setAnimationInterval(1 / framesPerSecond, SetIntervalReason::BY_DIRECTOR_PAUSE);
+}
+
+void Director::wakeUp()
+{
+    if (! _idle)
+    {
+        return;
+    }
+
+    _idle = false;
+    // startAnimation() makes the next delta time 0
+    setAnimationInterval(_awakeAnimationInterval, SetIntervalReason::BY_ENGINE);
+}
+
 void Director::updateFrameRate()
 {
 //    static const float FPS_FILTER = 0.1f;
@@ -1292,6 +1358,8 @@ void Director::showStats()
             _FPSLabel->setString(buffer);
             _accumDt = 0;
             _frames = 0;
+
+            updateFrameStats();
         }
 
         auto currentCalls = (unsigned long)_renderer->getDrawnBatches();
@@ -1312,6 +1380,52 @@ void Director::showStats()
         _drawnVerticesLabel->visit(_renderer, identity, 0);
         _drawnBatchesLabel->visit(_renderer, identity, 0);
         _FPSLabel->visit(_renderer, identity, 0);
+        for (auto label : _frameStatsLabels)
+        {
+            if (label)
+            {
+                label->visit(_renderer, identity, 0);
+            }
+        }
+        if (_frameTimeHistogram)
+        {
+            _frameTimeHistogram->visit(_renderer, identity, 0);
+        }
+    }
+}
+
+void Director::updateFrameStats()
+{
+    char buffer[40] = {0};
+    for (int i = 0; i < static_cast<int>(FrameStats::Section::COUNT); ++i)
+    {
+        if (_frameStatsLabels[i])
+        {
+            // min / avg / p99 in milliseconds
+            const auto section = static_cast<FrameStats::Section>(i);
+            const auto summary = _frameStats.getSummary(section);
+            snprintf(buffer, sizeof(buffer), "%-7s %.2f/%.2f/%.2f", FrameStats::getSectionName(section),
+                summary.minMs, summary.avgMs, summary.p99Ms);
+            _frameStatsLabels[i]->setString(buffer);
+        }
+    }
+
+    if (_frameTimeHistogram)
+    {
+        unsigned int counts[FrameStats::HISTOGRAM_SIZE];
+        _frameStats.getHistogram(counts);
+        const auto maxCount = *std::max_element(counts, counts + FrameStats::HISTOGRAM_SIZE);
+        const float barWidth = 6 / CC_CONTENT_SCALE_FACTOR();
+        const float barHeight = 40 / CC_CONTENT_SCALE_FACTOR();
+        _frameTimeHistogram->clear();
+        for (int i = 0; i < FrameStats::HISTOGRAM_SIZE && maxCount > 0; ++i)
+        {
+            // red when the bucket ends past the animation interval, from 16-18 ms at 60 fps
+            const auto late = (i + 1) * FrameStats::HISTOGRAM_BUCKET_MS > _animationInterval * 1000;
+            const auto height = barHeight * counts[i] / maxCount;
+            _frameTimeHistogram->drawSolidRect(Vec2(i * barWidth, 0), Vec2((i + 1) * barWidth - 1, height),
+                late ? Color4F(1, 0.2f, 0.2f, 0.8f) : Color4F(0.2f, 1, 0.2f, 0.8f));
+        }
     }
 }
 
@@ -1396,12 +1510,33 @@ void Director::createStatsLabel()
     _drawnVerticesLabel->setScale(scaleFactor);
 
 
+    for (auto& label : _frameStatsLabels)
+    {
+        std::string frameStatsString = label ? label->getString() : "";
+        CC_SAFE_RELEASE_NULL(label);
+        label = LabelAtlas::create();
+        label->retain();
+        label->setIgnoreContentScaleFactor(true);
+        label->initWithString(frameStatsString, texture, 12, 32, '.');
+        label->setScale(scaleFactor);
+    }
+    CC_SAFE_RELEASE_NULL(_frameTimeHistogram);
+    _frameTimeHistogram = DrawNode::create();
+    _frameTimeHistogram->retain();
+
     Texture2D::setDefaultAlphaPixelFormat(currentFormat);
 
     const int height_spacing = 22 / CC_CONTENT_SCALE_FACTOR();
     _drawnVerticesLabel->setPosition(Vec2(0, height_spacing*2) + CC_DIRECTOR_STATS_POSITION);
     _drawnBatchesLabel->setPosition(Vec2(0, height_spacing*1) + CC_DIRECTOR_STATS_POSITION);
     _FPSLabel->setPosition(Vec2(0, height_spacing*0)+CC_DIRECTOR_STATS_POSITION);
+    // the frame stats above, the whole frame first, and the histogram on top
+    const int frameStatsCount = static_cast<int>(FrameStats::Section::COUNT);
+    for (int i = 0; i < frameStatsCount; ++i)
+    {
+        _frameStatsLabels[i]->setPosition(Vec2(0, height_spacing*(3 + frameStatsCount - 1 - i)) + CC_DIRECTOR_STATS_POSITION);
+    }
+    _frameTimeHistogram->setPosition(Vec2(0, height_spacing*(3 + frameStatsCount)) + CC_DIRECTOR_STATS_POSITION);
 }
 
 #endif // #if !CC_STRIP_FPS
@@ -1499,6 +1634,9 @@ void Director::mainLoop()
      
         // release the objects
         PoolManager::getInstance()->getCurrentPool()->clear();
+#if CC_ENABLE_FRAME_ARENA
+        FrameArena::getInstance()->endFrame();
+#endif
     }
 }
 
@@ -1516,6 +1654,12 @@ void Director::stopAnimation()
 
 void Director::setAnimationInterval(float interval)
 {
+    if (_idle)
+    {
+        // takes effect on wakeUp()
+        _awakeAnimationInterval = interval;
+        return;
+    }
     setAnimationInterval(interval, SetIntervalReason::BY_GAME);
 }
 
@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "platform/CCPlatformMacros.h"
 #include "base/CCRef.h"
 #include "base/CCVector.h"
+#include "base/CCFrameStats.h"
 #include "2d/CCScene.h"
 #include "math/CCMath.h"
 #include "platform/CCGL.h"
@@ -49,6 +50,7 @@ NS_CC_BEGIN
 
 /* Forward declarations. */
 class LabelAtlas;
+class DrawNode;
 //class GLView;
 class DirectorDelegate;
 class Node;
@@ -177,6 +179,9 @@ public:
     /** Get seconds per frame. */
     float getSecondsPerFrame() { return _secondsPerFrame; }
 
+    /** Gets the time of each part of the last frames, displayed with the other stats by setDisplayStats(). */
+    FrameStats& getFrameStats() { return _frameStats; }
+
     /** 
      * Get the GLView.
      * @lua NA
@@ -338,6 +343,22 @@ public:
      * The "delta time" will be 0 (as if the game wasn't paused).
      */
     void resume();
+
+    /** Lowers the frame rate while the game has nothing to animate, e.g. a scene at rest.
+     * The animation interval of the game is kept, wakeUp() returns to it. Touches call wakeUp(), so the
+     * first frame after a touch is not delayed by the low frame rate.
+     * It does nothing while the Director is paused, which already draws at 4 FPS.
+     * @param framesPerSecond The frame rate while idle, 0 to return to the frame rate of the game.
+     */
+    void requestFrameRate(float framesPerSecond);
+
+    /** Returns to the frame rate of the game after requestFrameRate().
+     * The "delta time" of the next frame will be 0, the time spent idle does not reach the scheduled timers.
+     */
+    void wakeUp();
+
+    /** Whether or not a lower frame rate is requested by requestFrameRate(). */
+    bool isIdle() const { return _idle; }
     
     /*
      * Restart the director. 
@@ -595,6 +616,7 @@ protected:
     void updateFrameRate();
 #if !CC_STRIP_FPS
     void showStats();
+    void updateFrameStats();
     void createStatsLabel();
     void calculateMPF();
     void getFPSImageData(unsigned char** datapointer, ssize_t* length);
@@ -645,6 +667,9 @@ protected:
 
     float _animationInterval;
     float _oldAnimationInterval;
+    /* the animation interval of the game while idle, see requestFrameRate() */
+    float _awakeAnimationInterval;
+    bool _idle;
 
     /* landscape mode ? */
     bool _landscape;
@@ -656,6 +681,10 @@ protected:
     LabelAtlas *_FPSLabel;
     LabelAtlas *_drawnBatchesLabel;
     LabelAtlas *_drawnVerticesLabel;
+    /* one line per FrameStats section, and the histogram of the frame time */
+    LabelAtlas *_frameStatsLabels[static_cast<int>(FrameStats::Section::COUNT)];
+    DrawNode *_frameTimeHistogram;
+    FrameStats _frameStats;
     
     /** Whether or not the Director is paused */
     bool _paused;
@@ -0,0 +1,219 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCDispatchQueue.h"
+#include <algorithm>
+#include <chrono>
+
+NS_CC_BEGIN
+
+DispatchQueue::DispatchQueue(unsigned int capacity)
+: _cells(nullptr)
+, _mask(0)
+, _enqueuePosition(0)
+, _dequeuePosition(0)
+, _pushed(0)
+, _taken(0)
+, _clearedBefore(0)
+, _overflowing(false)
+, _overflowCount(0)
+, _pendingIndex(0)
+{
+    size_t size = 2;
+    while (size < capacity)
+    {
+        size <<= 1;
+    }
+    _cells = new Cell[size];
+    for (size_t i = 0; i < size; ++i)
+    {
+        _cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    _mask = size - 1;
+    _stats = Stats();
+}
+
+DispatchQueue::~DispatchQueue()
+{
+    delete [] _cells;
+}
+
+bool DispatchQueue::tryPush(std::function<void()>& function, uint64_t order)
+{
+    auto position = _enqueuePosition.load(std::memory_order_relaxed);
+    Cell* cell = nullptr;
+    for (;;)
+    {
+        cell = &_cells[position & _mask];
+        const auto sequence = cell->sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+        if (difference == 0)
+        {
+            if (_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if (difference < 0)
+        {
+            // full, the consumer has not taken what was written here a lap ago
+            return false;
+        }
+        else
+        {
+            // another producer took this cell
+            position = _enqueuePosition.load(std::memory_order_relaxed);
+        }
+    }
+    cell->entry.function = std::move(function);
+    cell->entry.order = order;
+    cell->sequence.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+bool DispatchQueue::tryPop(Entry& entry)
+{
+    auto cell = &_cells[_dequeuePosition & _mask];
+    if (cell->sequence.load(std::memory_order_acquire) != _dequeuePosition + 1)
+    {
+        // empty, or its producer is still writing it
+        return false;
+    }
+    entry.function = std::move(cell->entry.function);
+    entry.order = cell->entry.order;
+    cell->entry.function = nullptr;
+    cell->sequence.store(_dequeuePosition + _mask + 1, std::memory_order_release);
+    ++_dequeuePosition;
+    return true;
+}
+
+bool DispatchQueue::takeNext(Entry& entry)
+{
+    if (_pendingIndex == _pending.size())
+    {
+        if (tryPop(entry))
+        {
+            _taken.store(_taken.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return true;
+        }
+        // the overflow list only goes after every cell claimed before it, or a thread's functions could be
+        // reordered: a cell still being written waits for the next call
+        if (!_overflowing.load(std::memory_order_acquire)
+            || _dequeuePosition != _enqueuePosition.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        _pending.clear();
+        _pendingIndex = 0;
+        std::lock_guard<std::mutex> lock(_overflowMutex);
+        _pending.swap(_overflow);
+        _overflowing.store(false, std::memory_order_release);
+        if (_pending.empty())
+        {
+            return false;
+        }
+    }
+    entry = std::move(_pending[_pendingIndex++]);
+    _taken.store(_taken.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void DispatchQueue::push(std::function<void()> function)
+{
+    const auto order = _pushed.fetch_add(1, std::memory_order_relaxed);
+    if (!_overflowing.load(std::memory_order_acquire) && tryPush(function, order))
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_overflowMutex);
+    _overflow.push_back({ std::move(function), order });
+    _overflowing.store(true, std::memory_order_release);
+    _overflowCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void DispatchQueue::perform(float budgetSeconds)
+{
+    const auto depth = getDepth();
+    _stats.maxDepth = std::max(_stats.maxDepth, depth);
+    _stats.overflowCount = _overflowCount.load(std::memory_order_relaxed);
+    if (depth == 0)
+    {
+        _stats.performed = 0;
+        _stats.milliseconds = 0.0f;
+        _stats.depth = 0;
+        _stats.overBudget = false;
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::chrono::duration<float> budget(budgetSeconds);
+    unsigned int performed = 0;
+    auto stopped = false;
+    Entry entry;
+    // the functions queued by those performed wait for the next call, a function queuing itself can not loop here
+    for (auto left = depth; left > 0 && takeNext(entry); --left)
+    {
+        // read again each time, a function performed can clear the queue
+        if (entry.order < _clearedBefore.load(std::memory_order_acquire))
+        {
+            entry.function = nullptr;
+            continue;
+        }
+        entry.function();
+        // what it captured is released now, not with the next one
+        entry.function = nullptr;
+        ++performed;
+        if (budgetSeconds > 0.0f && std::chrono::steady_clock::now() - start >= budget)
+        {
+            stopped = true;
+            break;
+        }
+    }
+
+    _stats.performed = performed;
+    _stats.milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    _stats.depth = getDepth();
+    _stats.overBudget = stopped && _stats.depth > 0;
+    _stats.overBudgetCount += _stats.overBudget ? 1 : 0;
+    _stats.performedCount += performed;
+}
+
+void DispatchQueue::clear()
+{
+    const auto position = _pushed.load(std::memory_order_acquire);
+    auto clearedBefore = _clearedBefore.load(std::memory_order_relaxed);
+    while (clearedBefore < position
+        && !_clearedBefore.compare_exchange_weak(clearedBefore, position, std::memory_order_release))
+    {
+    }
+}
+
+unsigned int DispatchQueue::getDepth() const
+{
+    const auto taken = _taken.load(std::memory_order_relaxed);
+    const auto pushed = _pushed.load(std::memory_order_relaxed);
+    return pushed > taken ? static_cast<unsigned int>(pushed - taken) : 0;
+}
+
+NS_CC_END
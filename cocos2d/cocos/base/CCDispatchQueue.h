@@ -0,0 +1,150 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __BASE_CCDISPATCHQUEUE_H__
+#define __BASE_CCDISPATCHQUEUE_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base
+ * @{
+ */
+
+/**
+ * @brief The functions other threads send to the cocos thread, which the Scheduler performs once a frame.
+ *
+ * push() can be called from any thread. It takes a cell of a bounded ring with one compare-and-swap and
+ * never locks while the ring has room. When the ring is full the function waits in an overflow list behind a
+ * mutex instead, and is counted: nothing is dropped, and the functions of one thread are performed in the
+ * order it pushed them.
+ *
+ * perform() is only called by the consumer, the cocos thread. It stops once its time budget is spent; the
+ * functions left are performed first on the next call.
+ */
+class CC_DLL DispatchQueue
+{
+public:
+    /** Cells of the ring unless the constructor is told otherwise. */
+    static const unsigned int DEFAULT_CAPACITY = 1024;
+
+    /** What the last perform() did, and totals since the queue was created. */
+    struct Stats
+    {
+        /** Functions performed by the last perform(), and the milliseconds they took. */
+        unsigned int performed;
+        float milliseconds;
+        /** Functions still waiting when the last perform() returned. */
+        unsigned int depth;
+        /** Whether the last perform() stopped on its budget with functions left. */
+        bool overBudget;
+        /** The deepest the queue was when perform() was called. */
+        unsigned int maxDepth;
+        /** Calls to perform() that stopped on their budget. */
+        unsigned int overBudgetCount;
+        /** Functions pushed while the ring was full, which waited in the overflow list. */
+        unsigned int overflowCount;
+        uint64_t performedCount;
+    };
+
+    /** @param capacity Cells of the ring, rounded up to a power of 2. */
+    explicit DispatchQueue(unsigned int capacity = DEFAULT_CAPACITY);
+    ~DispatchQueue();
+
+    /** Queues a function for the consumer. Thread safe. */
+    void push(std::function<void()> function);
+
+    /**
+     * Performs the functions queued before the call, at least one, until budgetSeconds is spent. Consumer
+     * thread only.
+     * @param budgetSeconds 0 performs every function queued.
+     */
+    void perform(float budgetSeconds);
+
+    /**
+     * Drops the functions queued so far, they will not be performed. Those queued after it returns are kept.
+     * Thread safe: the consumer destroys the dropped functions, on its next perform().
+     */
+    void clear();
+
+    /** Functions waiting, approximate while other threads push. Thread safe. */
+    unsigned int getDepth() const;
+
+    /** Consumer thread only. */
+    const Stats& getStats() const { return _stats; }
+
+private:
+    struct Entry
+    {
+        std::function<void()> function;
+        // position among all the pushes, clear() drops the entries before a position
+        uint64_t order;
+    };
+    struct Cell
+    {
+        // the ring position this cell can be written at, that position + 1 once written
+        std::atomic<size_t> sequence;
+        Entry entry;
+    };
+
+    bool tryPush(std::function<void()>& function, uint64_t order);
+    bool tryPop(Entry& entry);
+    // the next entry: left by the last perform(), then the ring, then the overflow list
+    bool takeNext(Entry& entry);
+
+    Cell* _cells;
+    size_t _mask;
+    // producers and consumer write these, the padding keeps them off each other's cache line
+    char _padding0[64];
+    std::atomic<size_t> _enqueuePosition;
+    char _padding1[64];
+    size_t _dequeuePosition;
+    std::atomic<uint64_t> _pushed;
+    std::atomic<uint64_t> _taken;
+    std::atomic<uint64_t> _clearedBefore;
+
+    // once a function waits in the overflow list, the next ones follow it there, to keep their order
+    std::atomic<bool> _overflowing;
+    std::mutex _overflowMutex;
+    std::vector<Entry> _overflow;
+    std::atomic<unsigned int> _overflowCount;
+
+    std::vector<Entry> _pending;
+    size_t _pendingIndex;
+    Stats _stats;
+};
+
+// end of base group
+/** @} */
+
+NS_CC_END
+
+#endif // __BASE_CCDISPATCHQUEUE_H__
@@ -0,0 +1,179 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#include "base/CCFrameArena.h"
+#include <cstdint>
+#include "base/ccMacros.h"
+
+NS_CC_BEGIN
+
+// read by Ref::operator new and delete on any thread
+static std::atomic<FrameArena*> s_sharedFrameArena(nullptr);
+
+namespace
+{
+    const FrameArena::Stats EMPTY_STATS = { 0, 0, 0, false };
+}
+
+FrameArena::Scope::Scope()
+{
+    auto arena = FrameArena::getInstance();
+    CCASSERT(std::this_thread::get_id() == arena->_cocosThread, "FrameArena::Scope must be opened on the cocos thread");
+    arena->_scopeDepth.fetch_add(1, std::memory_order_relaxed);
+}
+
+FrameArena::Scope::~Scope()
+{
+    FrameArena::getInstance()->_scopeDepth.fetch_sub(1, std::memory_order_relaxed);
+}
+
+FrameArena* FrameArena::getInstance()
+{
+    auto arena = s_sharedFrameArena.load(std::memory_order_acquire);
+    if (! arena)
+    {
+        arena = new (std::nothrow) FrameArena();
+        s_sharedFrameArena.store(arena, std::memory_order_release);
+    }
+    return arena;
+}
+
+void FrameArena::destroyInstance()
+{
+    auto arena = s_sharedFrameArena.load(std::memory_order_acquire);
+    if (! arena)
+    {
+        return;
+    }
+    if (arena->getLiveCount() > 0)
+    {
+        // their delete must still find the block
+        CCLOG("FrameArena: %u objects are still alive, the arena is not freed", arena->getLiveCount());
+        return;
+    }
+    s_sharedFrameArena.store(nullptr, std::memory_order_release);
+    delete arena;
+}
+
+FrameArena::FrameArena()
+: _cocosThread(std::this_thread::get_id())
+, _scopeDepth(0)
+, _begin(nullptr)
+, _end(nullptr)
+, _capacity(0)
+, _offset(0)
+, _liveCount(0)
+, _frame(EMPTY_STATS)
+, _lastFrame(EMPTY_STATS)
+{
+}
+
+FrameArena::~FrameArena()
+{
+    delete [] _begin.load(std::memory_order_relaxed);
+}
+
+bool FrameArena::setCapacity(size_t bytes)
+{
+    bytes = (bytes + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (bytes == _capacity)
+    {
+        return true;
+    }
+    if (_scopeDepth.load(std::memory_order_relaxed) > 0 || getLiveCount() > 0)
+    {
+        return false;
+    }
+
+    char* block = nullptr;
+    if (bytes > 0)
+    {
+        block = new (std::nothrow) char[bytes];
+        if (! block)
+        {
+            return false;
+        }
+    }
+    delete [] _begin.load(std::memory_order_relaxed);
+    _begin.store(block, std::memory_order_release);
+    _end.store(block ? block + bytes : nullptr, std::memory_order_release);
+    _capacity = bytes;
+    _offset = 0;
+    return true;
+}
+
+void FrameArena::endFrame()
+{
+    _lastFrame = _frame;
+    _lastFrame.pinned = _liveCount.load(std::memory_order_acquire) > 0;
+    if (! _lastFrame.pinned)
+    {
+        _offset = 0;
+    }
+    _frame = EMPTY_STATS;
+}
+
+void* FrameArena::allocate(size_t size)
+{
+    auto arena = s_sharedFrameArena.load(std::memory_order_acquire);
+    if (! arena || arena->_scopeDepth.load(std::memory_order_relaxed) == 0 || arena->_capacity == 0
+        || std::this_thread::get_id() != arena->_cocosThread)
+    {
+        return nullptr;
+    }
+
+    size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+    if (size > arena->_capacity - arena->_offset)
+    {
+        ++arena->_frame.overflows;
+        return nullptr;
+    }
+    auto pointer = arena->_begin.load(std::memory_order_relaxed) + arena->_offset;
+    arena->_offset += size;
+    ++arena->_frame.allocations;
+    arena->_frame.bytes += size;
+    arena->_liveCount.fetch_add(1, std::memory_order_relaxed);
+    return pointer;
+}
+
+bool FrameArena::deallocate(void* pointer)
+{
+    auto arena = s_sharedFrameArena.load(std::memory_order_acquire);
+    if (! arena)
+    {
+        return false;
+    }
+    const auto address = reinterpret_cast<uintptr_t>(pointer);
+    if (address < reinterpret_cast<uintptr_t>(arena->_begin.load(std::memory_order_acquire))
+        || address >= reinterpret_cast<uintptr_t>(arena->_end.load(std::memory_order_acquire)))
+    {
+        return false;
+    }
+    // the object may have been released on another thread, endFrame() must see its memory is no longer used
+    arena->_liveCount.fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+NS_CC_END
@@ -0,0 +1,135 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+
+#ifndef __BASE_CCFRAMEARENA_H__
+#define __BASE_CCFRAMEARENA_H__
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base
+ * @{
+ */
+
+/**
+ * @brief A bump allocator for the Refs that only live for a frame, the objects created with create() and
+ * dropped before the AutoreleasePool is cleared.
+ *
+ * It needs CC_ENABLE_FRAME_ARENA, and is off until setCapacity() gives it a block. Then, while a
+ * FrameArena::Scope is open on the cocos thread, Ref::operator new places the objects in the block instead
+ * of the heap; once it is full they go to the heap again, counted as overflows. The Director calls endFrame()
+ * after clearing the pool, which rewinds the block in O(1) when every object placed in it has been deleted.
+ * An object still alive pins the block: it is not rewound, so nothing is overwritten, until that object is
+ * gone too.
+ *
+ * Only objects created inside a scope are placed, and a scope is only for autoreleased objects that nothing
+ * retains, such as an action, which the node running it keeps for frames, would pin the block:
+ * @code
+ * {
+ *     FrameArena::Scope arena;
+ *     // drawCardinalSpline() reads the points, it does not keep them
+ *     auto points = PointArray::create(count);
+ *     ...
+ *     drawNode->drawCardinalSpline(points, 0.5f, 32, Color4F::WHITE);
+ * }
+ * @endcode
+ */
+class CC_DLL FrameArena
+{
+public:
+    /** The placement alignment, enough for any Ref. */
+    static const size_t ALIGNMENT = 16;
+
+    /** Places the Refs created on the cocos thread in the arena, from its construction to the end of the scope. Scopes nest. */
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+    };
+
+    /** What a frame placed in the arena. */
+    struct Stats
+    {
+        unsigned int allocations;
+        size_t bytes;
+        /** Allocations that did not fit and went to the heap. */
+        unsigned int overflows;
+        /** Whether objects of this frame or an earlier one were still alive at its end, so the block was not rewound. */
+        bool pinned;
+    };
+
+    /** Gets the arena, creating it on the first call, which must be on the cocos thread. */
+    static FrameArena* getInstance();
+    /** Frees the block, unless objects placed in it are still alive. */
+    static void destroyInstance();
+
+    /**
+     * Allocates the block, 0 turns the arena off. It can only change while no scope is open and no object
+     * lives in the arena.
+     * @return false when it can not change now, or the block can not be allocated.
+     */
+    bool setCapacity(size_t bytes);
+    size_t getCapacity() const { return _capacity; }
+
+    /** Rewinds the block when it is not pinned and starts counting the next frame, called by the Director. */
+    void endFrame();
+
+    const Stats& getLastFrameStats() const { return _lastFrame; }
+    /** Objects placed in the arena and not deleted yet. */
+    unsigned int getLiveCount() const { return _liveCount.load(std::memory_order_relaxed); }
+
+    /** For Ref::operator new: memory in the arena if a scope is open on this thread and it fits, nullptr otherwise. */
+    static void* allocate(size_t size);
+    /** For Ref::operator delete: false when pointer is not in the arena, the heap frees it then. */
+    static bool deallocate(void* pointer);
+
+private:
+    FrameArena();
+    ~FrameArena();
+
+    std::thread::id _cocosThread;
+    std::atomic<int> _scopeDepth;
+    // the block, also read by deallocate() on other threads
+    std::atomic<char*> _begin;
+    std::atomic<char*> _end;
+    size_t _capacity;
+    size_t _offset;
+    std::atomic<unsigned int> _liveCount;
+    Stats _frame;
+    Stats _lastFrame;
+};
+
+// end of base group
+/** @} */
+
+NS_CC_END
+
+#endif // __BASE_CCFRAMEARENA_H__
@@ -0,0 +1,171 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCFrameStats.h"
+#include <algorithm>
+#include "base/CCFrameTelemetry.h"
+
+NS_CC_BEGIN
+
+const float FrameStats::HISTOGRAM_BUCKET_MS = 2.0f;
+
+FrameStats::FrameStats()
+: _frameCount(0)
+, _lastFrame(HISTORY_SIZE - 1)
+, _depth(0)
+{
+    std::fill(_current, _current + SECTION_COUNT, 0LL);
+    _frameStart = _mark = std::chrono::steady_clock::now();
+}
+
+const char* FrameStats::getSectionName(Section section)
+{
+    switch (section)
+    {
+        case Section::UPDATE: return "update";
+        case Section::PHYSICS: return "physics";
+        case Section::VISIT: return "visit";
+        case Section::SORT: return "sort";
+        case Section::FLUSH: return "flush";
+        case Section::SWAP: return "swap";
+        case Section::OTHER: return "other";
+        case Section::FRAME: return "frame";
+        default: return "";
+    }
+}
+
+void FrameStats::beginFrame()
+{
+    std::fill(_current, _current + SECTION_COUNT, 0LL);
+    _depth = 0;
+    _frameStart = _mark = std::chrono::steady_clock::now();
+    // the telemetry takes the same clock reads
+    auto telemetry = FrameTelemetry::getInstance();
+    if (telemetry->isRecording())
+    {
+        telemetry->beginMarker("frame", _mark);
+    }
+}
+
+void FrameStats::endFrame()
+{
+    const auto now = std::chrono::steady_clock::now();
+    charge(now);
+    _current[static_cast<int>(Section::FRAME)] = std::chrono::duration_cast<std::chrono::nanoseconds>(now - _frameStart).count();
+
+    _lastFrame = (_lastFrame + 1) % HISTORY_SIZE;
+    for (int i = 0; i < SECTION_COUNT; ++i)
+    {
+        _history[_lastFrame][i] = _current[i] / 1000000.0f;
+    }
+    _frameCount = std::min(_frameCount + 1, static_cast<int>(HISTORY_SIZE));
+
+    auto telemetry = FrameTelemetry::getInstance();
+    if (telemetry->isRecording())
+    {
+        telemetry->endMarker(now);
+        telemetry->recordFrame(*this);
+    }
+}
+
+void FrameStats::begin(Section section)
+{
+    const auto now = std::chrono::steady_clock::now();
+    charge(now);
+    auto telemetry = FrameTelemetry::getInstance();
+    if (telemetry->isRecording())
+    {
+        telemetry->beginMarker(getSectionName(section), now);
+    }
+    if (_depth < MAX_DEPTH)
+    {
+        _stack[_depth] = section;
+    }
+    ++_depth;
+}
+
+void FrameStats::end()
+{
+    const auto now = std::chrono::steady_clock::now();
+    charge(now);
+    auto telemetry = FrameTelemetry::getInstance();
+    if (telemetry->isRecording())
+    {
+        telemetry->endMarker(now);
+    }
+    if (_depth > 0)
+    {
+        --_depth;
+    }
+}
+
+void FrameStats::charge(std::chrono::steady_clock::time_point now)
+{
+    // sections deeper than MAX_DEPTH are counted in the deepest one recorded
+    const auto section = _depth > 0 ? _stack[std::min(_depth, static_cast<int>(MAX_DEPTH)) - 1] : Section::OTHER;
+    _current[static_cast<int>(section)] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - _mark).count();
+    _mark = now;
+}
+
+float FrameStats::getLastMs(Section section) const
+{
+    return _frameCount > 0 ? _history[_lastFrame][static_cast<int>(section)] : 0.0f;
+}
+
+FrameStats::Summary FrameStats::getSummary(Section section) const
+{
+    Summary summary = { 0.0f, 0.0f, 0.0f };
+    if (_frameCount == 0)
+    {
+        return summary;
+    }
+
+    // the order of the frames does not matter here, and the ring fills from index 0
+    float values[HISTORY_SIZE];
+    float sum = 0.0f;
+    for (int i = 0; i < _frameCount; ++i)
+    {
+        values[i] = _history[i][static_cast<int>(section)];
+        sum += values[i];
+    }
+    summary.minMs = *std::min_element(values, values + _frameCount);
+    summary.avgMs = sum / _frameCount;
+    auto p99 = values + std::min(_frameCount - 1, _frameCount * 99 / 100);
+    std::nth_element(values, p99, values + _frameCount);
+    summary.p99Ms = *p99;
+    return summary;
+}
+
+void FrameStats::getHistogram(unsigned int* counts) const
+{
+    std::fill(counts, counts + HISTOGRAM_SIZE, 0u);
+    for (int i = 0; i < _frameCount; ++i)
+    {
+        const auto frameMs = _history[i][static_cast<int>(Section::FRAME)];
+        const auto bucket = std::min(static_cast<int>(frameMs / HISTOGRAM_BUCKET_MS), static_cast<int>(HISTOGRAM_SIZE) - 1);
+        ++counts[bucket];
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,126 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __BASE_CCFRAMESTATS_H__
+#define __BASE_CCFRAMESTATS_H__
+
+#include <chrono>
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base
+ * @{
+ */
+
+/**
+ * @brief Where the time of the last frames went, per part of Director::drawScene.
+ *
+ * Sections nest, a section started inside another one is not counted in the outer one. The time of a frame
+ * in no section is counted as OTHER. Recording costs one clock read per begin() and end(), and nothing
+ * allocates, so it is recorded in release builds too. While FrameTelemetry records, the sections are
+ * recorded there as markers.
+ */
+class CC_DLL FrameStats
+{
+public:
+    enum class Section
+    {
+        /** Scheduler::update, with the before and after update events. */
+        UPDATE,
+        /** Scene::stepPhysicsAndNavigation. */
+        PHYSICS,
+        /** Scene visit, creating the render commands. */
+        VISIT,
+        /** Renderer sorting its render queues. */
+        SORT,
+        /** Renderer issuing the render commands to GL. */
+        FLUSH,
+        /** GLView::swapBuffers. */
+        SWAP,
+        /** The rest of the frame. */
+        OTHER,
+        /** The whole frame, from beginFrame() to endFrame(). */
+        FRAME,
+        COUNT
+    };
+
+    /** Number of recent frames the summaries and the histogram are computed over. */
+    static const int HISTORY_SIZE = 120;
+    /** Buckets of the frame time histogram, the last one also has the longer frames. */
+    static const int HISTOGRAM_SIZE = 16;
+    static const float HISTOGRAM_BUCKET_MS;
+
+    struct Summary
+    {
+        float minMs;
+        float avgMs;
+        float p99Ms;
+    };
+
+    FrameStats();
+
+    static const char* getSectionName(Section section);
+
+    void beginFrame();
+    void endFrame();
+
+    /** Starts a section, the time until the matching end() goes to it. */
+    void begin(Section section);
+    void end();
+
+    /** Number of frames in the history, at most HISTORY_SIZE. */
+    int getFrameCount() const { return _frameCount; }
+    /** Time of the section in the last frame. */
+    float getLastMs(Section section) const;
+    /** Over the frames in the history. */
+    Summary getSummary(Section section) const;
+    /** Frames of the history per HISTOGRAM_BUCKET_MS of frame time, counts must hold HISTOGRAM_SIZE values. */
+    void getHistogram(unsigned int* counts) const;
+
+private:
+    static const int MAX_DEPTH = 8;
+    static const int SECTION_COUNT = static_cast<int>(Section::COUNT);
+
+    void charge(std::chrono::steady_clock::time_point now);
+
+    float _history[HISTORY_SIZE][SECTION_COUNT];
+    int _frameCount;
+    int _lastFrame;
+
+    // the frame being recorded, in nanoseconds
+    long long _current[SECTION_COUNT];
+    std::chrono::steady_clock::time_point _frameStart;
+    std::chrono::steady_clock::time_point _mark;
+    Section _stack[MAX_DEPTH];
+    int _depth;
+};
+
+// end of base group
+/** @} */
+
+NS_CC_END
+
+#endif // __BASE_CCFRAMESTATS_H__
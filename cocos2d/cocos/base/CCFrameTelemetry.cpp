@@ -0,0 +1,243 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "base/CCFrameTelemetry.h"
+#include <cstdio>
+#include "platform/CCFileUtils.h"
+
+NS_CC_BEGIN
+
+static FrameTelemetry* s_sharedFrameTelemetry = nullptr;
+
+namespace
+{
+    // marker names are usually literals, but the JSON must stay valid whatever they are
+    void writeJSONString(FILE* file, const char* text)
+    {
+        fputc('"', file);
+        for (; *text; ++text)
+        {
+            if (*text == '"' || *text == '\\')
+            {
+                fputc('\\', file);
+            }
+            if (static_cast<unsigned char>(*text) >= 0x20)
+            {
+                fputc(*text, file);
+            }
+        }
+        fputc('"', file);
+    }
+}
+
+FrameTelemetry::Scope::Scope(const char* name)
+: _recording(FrameTelemetry::getInstance()->isRecording())
+{
+    if (_recording)
+    {
+        FrameTelemetry::getInstance()->beginMarker(name);
+    }
+}
+
+FrameTelemetry::Scope::~Scope()
+{
+    if (_recording)
+    {
+        FrameTelemetry::getInstance()->endMarker();
+    }
+}
+
+FrameTelemetry* FrameTelemetry::getInstance()
+{
+    if (! s_sharedFrameTelemetry)
+    {
+        s_sharedFrameTelemetry = new (std::nothrow) FrameTelemetry();
+    }
+    return s_sharedFrameTelemetry;
+}
+
+FrameTelemetry::FrameTelemetry()
+: _recording(false)
+, _frameCount(0)
+, _markerCount(0)
+, _dropped(0)
+, _depth(0)
+{
+}
+
+void FrameTelemetry::start(int maxFrames)
+{
+    // all the allocation happens here, recording only writes into the buffers
+    _frames.resize(maxFrames > 0 ? maxFrames : 1);
+    _markers.resize(_frames.size() * MARKERS_PER_FRAME);
+    _frameCount = 0;
+    _markerCount = 0;
+    _dropped = 0;
+    _depth = 0;
+    _startTime = std::chrono::steady_clock::now();
+    _recording = true;
+}
+
+void FrameTelemetry::stop()
+{
+    if (! _recording)
+    {
+        return;
+    }
+    while (_depth > 0)
+    {
+        endMarker();
+    }
+    _recording = false;
+}
+
+long long FrameTelemetry::toNanoseconds(std::chrono::steady_clock::time_point time) const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time - _startTime).count();
+}
+
+void FrameTelemetry::beginMarker(const char* name, std::chrono::steady_clock::time_point time)
+{
+    if (! _recording)
+    {
+        return;
+    }
+    int index = -1;
+    if (_markerCount < static_cast<int>(_markers.size()))
+    {
+        index = _markerCount++;
+        auto& marker = _markers[index];
+        marker.name = name;
+        marker.beginNs = toNanoseconds(time);
+        marker.endNs = -1;
+    }
+    else
+    {
+        ++_dropped;
+    }
+    if (_depth < MAX_DEPTH)
+    {
+        _openMarkers[_depth] = index;
+    }
+    ++_depth;
+}
+
+void FrameTelemetry::endMarker(std::chrono::steady_clock::time_point time)
+{
+    // a marker begun before start() has nothing to end
+    if (! _recording || _depth == 0)
+    {
+        return;
+    }
+    --_depth;
+    if (_depth < MAX_DEPTH && _openMarkers[_depth] >= 0)
+    {
+        _markers[_openMarkers[_depth]].endNs = toNanoseconds(time);
+    }
+}
+
+void FrameTelemetry::recordFrame(const FrameStats& stats)
+{
+    if (! _recording)
+    {
+        return;
+    }
+    if (_frameCount == static_cast<int>(_frames.size()))
+    {
+        ++_dropped;
+        return;
+    }
+    auto& frame = _frames[_frameCount++];
+    frame.endNs = toNanoseconds(std::chrono::steady_clock::now());
+    for (int i = 0; i < static_cast<int>(FrameStats::Section::COUNT); ++i)
+    {
+        frame.ms[i] = stats.getLastMs(static_cast<FrameStats::Section>(i));
+    }
+}
+
+bool FrameTelemetry::saveChromeTrace(const std::string& path) const
+{
+    auto file = fopen(FileUtils::getInstance()->getSuitableFOpen(path).c_str(), "w");
+    if (! file)
+    {
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"cocos thread\"}}");
+    for (int i = 0; i < _markerCount; ++i)
+    {
+        const auto& marker = _markers[i];
+        // still open while recording
+        if (marker.endNs < 0)
+        {
+            continue;
+        }
+        fprintf(file, ",\n{\"name\":");
+        writeJSONString(file, marker.name);
+        fprintf(file, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+            marker.beginNs / 1000.0, (marker.endNs - marker.beginNs) / 1000.0);
+    }
+    for (int i = 0; i < _frameCount; ++i)
+    {
+        const auto& frame = _frames[i];
+        fprintf(file, ",\n{\"name\":\"frame ms\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{", frame.endNs / 1000.0);
+        for (int j = 0; j < static_cast<int>(FrameStats::Section::COUNT); ++j)
+        {
+            fprintf(file, "%s\"%s\":%.3f", j > 0 ? "," : "", FrameStats::getSectionName(static_cast<FrameStats::Section>(j)), frame.ms[j]);
+        }
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%d}}\n", _dropped);
+    return fclose(file) == 0;
+}
+
+bool FrameTelemetry::saveCSV(const std::string& path) const
+{
+    auto file = fopen(FileUtils::getInstance()->getSuitableFOpen(path).c_str(), "w");
+    if (! file)
+    {
+        return false;
+    }
+
+    fprintf(file, "index,end_ms");
+    for (int j = 0; j < static_cast<int>(FrameStats::Section::COUNT); ++j)
+    {
+        fprintf(file, ",%s", FrameStats::getSectionName(static_cast<FrameStats::Section>(j)));
+    }
+    fprintf(file, "\n");
+    for (int i = 0; i < _frameCount; ++i)
+    {
+        const auto& frame = _frames[i];
+        fprintf(file, "%d,%.3f", i, frame.endNs / 1000000.0);
+        for (int j = 0; j < static_cast<int>(FrameStats::Section::COUNT); ++j)
+        {
+            fprintf(file, ",%.3f", frame.ms[j]);
+        }
+        fprintf(file, "\n");
+    }
+    return fclose(file) == 0;
+}
+
+NS_CC_END
@@ -0,0 +1,129 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __BASE_CCFRAMETELEMETRY_H__
+#define __BASE_CCFRAMETELEMETRY_H__
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "base/CCFrameStats.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup base
+ * @{
+ */
+
+/**
+ * @brief Records the timings of every frame and scoped markers while the game runs, to save them as a Chrome
+ * trace (chrome://tracing, https://ui.perfetto.dev) or as CSV.
+ *
+ * The buffers are allocated by start(), recording only writes into them; once they are full the rest is
+ * counted as dropped. The FrameStats sections of the Director are recorded as markers too.
+ * Markers must be recorded on the cocos thread. The console controls it with the "telemetry" command.
+ */
+class CC_DLL FrameTelemetry
+{
+public:
+    static const int DEFAULT_MAX_FRAMES = 3600;
+    static const int MARKERS_PER_FRAME = 32;
+
+    /** Records a marker from its construction to the end of the scope, see CC_TELEMETRY_SCOPE. */
+    class Scope
+    {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+    private:
+        bool _recording;
+    };
+
+    static FrameTelemetry* getInstance();
+
+    /** Starts recording, for at most maxFrames frames and maxFrames * MARKERS_PER_FRAME markers. */
+    void start(int maxFrames = DEFAULT_MAX_FRAMES);
+    void stop();
+    bool isRecording() const { return _recording; }
+
+    /** @param name Must live until the recording is saved, usually a string literal. */
+    void beginMarker(const char* name, std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now());
+    void endMarker(std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now());
+
+    /** Records the sections of the frame that just ended, called by FrameStats. */
+    void recordFrame(const FrameStats& stats);
+
+    int getFrameCount() const { return _frameCount; }
+    int getMarkerCount() const { return _markerCount; }
+    /** Frames and markers that did not fit in the buffers. */
+    int getDroppedCount() const { return _dropped; }
+
+    /** Saves the markers as complete events and the frame times as counters of the Chrome trace event format. */
+    bool saveChromeTrace(const std::string& path) const;
+    /** Saves one line per frame, with the time of each FrameStats section in milliseconds. */
+    bool saveCSV(const std::string& path) const;
+
+private:
+    static const int MAX_DEPTH = 32;
+
+    struct Marker
+    {
+        const char* name;
+        long long beginNs;
+        long long endNs;
+    };
+
+    struct Frame
+    {
+        long long endNs;
+        float ms[static_cast<int>(FrameStats::Section::COUNT)];
+    };
+
+    FrameTelemetry();
+    long long toNanoseconds(std::chrono::steady_clock::time_point time) const;
+
+    bool _recording;
+    std::chrono::steady_clock::time_point _startTime;
+    std::vector<Frame> _frames;
+    std::vector<Marker> _markers;
+    int _frameCount;
+    int _markerCount;
+    int _dropped;
+    // markers not ended yet, -1 for one that was dropped
+    int _openMarkers[MAX_DEPTH];
+    int _depth;
+};
+
+/** Records a telemetry marker named name until the end of the enclosing scope. */
+#define CC_TELEMETRY_SCOPE(name) cocos2d::FrameTelemetry::Scope CC_TELEMETRY_SCOPE_VARIABLE(__LINE__)(name)
+#define CC_TELEMETRY_SCOPE_VARIABLE(line) CC_TELEMETRY_SCOPE_CONCAT(ccTelemetryScope, line)
+#define CC_TELEMETRY_SCOPE_CONCAT(a, b) a##b
+
+// end of base group
+/** @} */
+
+NS_CC_END
+
+#endif // __BASE_CCFRAMETELEMETRY_H__
@@ -27,6 +27,7 @@ THE SOFTWARE.
 #include "base/CCAutoreleasePool.h"
 #include "base/ccMacros.h"
 #include "base/CCScriptSupport.h"
+#include "base/CCFrameArena.h"
 
 #if CC_REF_LEAK_DETECTION
 #include <algorithm>    // std::find
@@ -150,6 +151,36 @@ void Ref::release()
     }
 }
 
+#if CC_ENABLE_FRAME_ARENA
+void* Ref::operator new(std::size_t size)
+{
+    auto memory = FrameArena::allocate(size);
+    return memory ? memory : ::operator new(size);
+}
+
+void* Ref::operator new(std::size_t size, const std::nothrow_t& nothrow) throw()
+{
+    auto memory = FrameArena::allocate(size);
+    return memory ? memory : ::operator new(size, nothrow);
+}
+
+void Ref::operator delete(void* pointer) throw()
+{
+    if (! FrameArena::deallocate(pointer))
+    {
+        ::operator delete(pointer);
+    }
+}
+
+void Ref::operator delete(void* pointer, const std::nothrow_t& nothrow) throw()
+{
+    if (! FrameArena::deallocate(pointer))
+    {
+        ::operator delete(pointer, nothrow);
+    }
+}
+#endif // CC_ENABLE_FRAME_ARENA
+
 Ref* Ref::autorelease()
 {
     PoolManager::getInstance()->getCurrentPool()->addObject(this);
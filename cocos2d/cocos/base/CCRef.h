@@ -29,6 +29,10 @@ THE SOFTWARE.
 #include "platform/CCPlatformMacros.h"
 #include "base/ccConfig.h"
 
+#if CC_ENABLE_FRAME_ARENA
+#include <new>
+#endif
+
 #define CC_REF_LEAK_DETECTION 0
 
 /**
@@ -142,6 +146,21 @@ public:
      */
     virtual ~Ref();
 
+#if CC_ENABLE_FRAME_ARENA
+    /**
+     * Allocates in the FrameArena while a FrameArena::Scope is open, on the heap otherwise.
+     *
+     * @js NA
+     * @lua NA
+     */
+    static void* operator new(std::size_t size);
+    static void* operator new(std::size_t size, const std::nothrow_t& nothrow) throw();
+    static void* operator new(std::size_t /*size*/, void* where) throw() { return where; }
+    static void operator delete(void* pointer) throw();
+    static void operator delete(void* pointer, const std::nothrow_t& nothrow) throw();
+    static void operator delete(void* /*pointer*/, void* /*where*/) throw() {}
+#endif
+
 protected:
     /// count of references
     unsigned int _referenceCount;
@@ -26,46 +26,40 @@ THE SOFTWARE.
 ****************************************************************************/
 
 #include "base/CCScheduler.h"
+#include <algorithm>
 #include "base/ccMacros.h"
 #include "base/CCDirector.h"
-#include "base/utlist.h"
-#include "base/ccCArray.h"
 #include "base/CCScriptSupport.h"
 
 NS_CC_BEGIN
 
-// data structures
+// the length of a tick of the timer wheel is 1 / TIMER_TICKS_PER_SECOND seconds
+#define TIMER_TICKS_PER_SECOND 256.0
 
-// A list double-linked list used for "updates with priority"
-typedef struct _listEntry
-{
-    struct _listEntry   *prev, *next;
-    ccSchedulerFunc     callback;
-    void                *target;
-    int                 priority;
-    bool                paused;
-    bool                markedForDeletion; // selector will no longer be called and entry will be removed at end of the next tick
-} tListEntry;
+// data structures
 
-typedef struct _hashUpdateEntry
+// A timer with the state the wheel needs
+struct Scheduler::TimerEntry
 {
-    tListEntry          **list;        // Which list does it belong to ?
-    tListEntry          *entry;        // entry in the list
-    void                *target;
-    ccSchedulerFunc     callback;
-    UT_hash_handle      hh;
-} tHashUpdateEntry;
-
-// Hash Element used for "selectors with interval"
-typedef struct _hashSelectorEntry
+    Timer               *timer;
+    TimerTarget         *owner;
+    double              lastUpdate;  // scheduler time of the last update of the timer
+    uint64_t            dueTick;     // first tick at which it may trigger
+    std::vector<TimerEntry*> *slot;  // wheel slot it waits in, nullptr while it is updated or paused
+    size_t              slotIndex;
+    bool                parked;      // its target is paused, it is out of the wheel until resumed
+    bool                updating;    // in the due timers of the running frame
+    bool                removed;     // unscheduled, deleted once the due timers are updated
+};
+
+// The "selectors with interval" of a target
+struct Scheduler::TimerTarget
 {
-    ccArray             *timers;
     void                *target;
-    int                 timerIndex;
-    Timer               *currentTimer;
+    std::vector<TimerEntry*> timers;
     bool                paused;
-    UT_hash_handle      hh;
-} tHashTimerEntry;
+    double              pausedAt;
+};
 
 // implementation Timer
 
@@ -150,6 +144,19 @@ bool Timer::isExhausted() const
     return !_runForever && _timesExecuted > _repeat;
 }
 
+float Timer::getTimeToTrigger() const
+{
+    if (_elapsed == -1)
+    {
+        return 0.0f;
+    }
+    if (_useDelay)
+    {
+        return std::max(0.0f, _delay - _elapsed);
+    }
+    return (_interval > 0) ? std::max(0.0f, _interval - _elapsed) : 0.0f;
+}
+
 // TimerTargetSelector
 
 TimerTargetSelector::TimerTargetSelector()
@@ -248,23 +255,21 @@ const int Scheduler::PRIORITY_SYSTEM = INT_MIN;
 
 // Minimum priority level for user scheduling.
 const int Scheduler::PRIORITY_NON_SYSTEM_MIN = PRIORITY_SYSTEM + 1;
+const float Scheduler::DEFAULT_DISPATCH_BUDGET = 0.004f;
 
 Scheduler::Scheduler(void)
 : _timeScale(1.0f)
-, _updatesNegList(nullptr)
-, _updates0List(nullptr)
-, _updatesPosList(nullptr)
-, _hashForUpdates(nullptr)
-, _hashForTimers(nullptr)
-, _currentTarget(nullptr)
-, _currentTargetSalvaged(false)
-, _updateHashLocked(false)
+, _time(0.0)
+, _removedUpdates(0)
+, _updatesLocked(false)
+, _wheelTick(0)
+, _currentTimer(nullptr)
+, _timersLocked(false)
 #if CC_ENABLE_SCRIPT_BINDING
 , _scriptHandlerEntries(20)
 #endif
+, _dispatchBudget(DEFAULT_DISPATCH_BUDGET)
 {
-    // I don't expect to have more than 30 functions to all per frame
-    _functionsToPerform.reserve(30);
 }
 
 Scheduler::~Scheduler(void)
@@ -272,65 +277,251 @@ Scheduler::~Scheduler(void)
     unscheduleAll();
 }
 
-void Scheduler::removeHashElement(_hashSelectorEntry *element)
+Scheduler::TimerTarget* Scheduler::findTimerTarget(const void *target) const
 {
-    ccArrayFree(element->timers);
-    HASH_DEL(_hashForTimers, element);
-    free(element);
+    auto found = _timerTargets.find(target);
+    return found != _timerTargets.end() ? found->second : nullptr;
 }
 
-void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, bool paused, const std::string& key)
+Scheduler::TimerTarget* Scheduler::timerTargetFor(void *target, bool paused)
 {
-    this->schedule(callback, target, interval, CC_REPEAT_FOREVER, 0.0f, paused, key);
+    auto owner = findTimerTarget(target);
+    if (! owner)
+    {
+        owner = new (std::nothrow) TimerTarget();
+        owner->target = target;
+        // Is this the 1st element ? Then set the pause level to all the selectors of this target
+        owner->paused = paused;
+        owner->pausedAt = _time;
+        _timerTargets[target] = owner;
+    }
+    else
+    {
+        CCASSERT(owner->paused == paused, "element's paused should be paused!");
+    }
+    return owner;
 }
 
-void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, const std::string& key)
+void Scheduler::addTimer(TimerTarget *owner, Timer *timer)
 {
-    CCASSERT(target, "Argument target must be non-nullptr");
-    CCASSERT(!key.empty(), "key should not be empty!");
+    auto entry = new (std::nothrow) TimerEntry();
+    entry->timer = timer;
+    entry->owner = owner;
+    entry->slot = nullptr;
+    entry->slotIndex = 0;
+    entry->updating = false;
+    entry->removed = false;
+    owner->timers.push_back(entry);
+    restartTimer(entry);
+}
 
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
+void Scheduler::restartTimer(TimerEntry *entry)
+{
+    detachTimer(entry);
+    // a paused target's time starts counting when it is resumed
+    entry->lastUpdate = entry->owner->paused ? entry->owner->pausedAt : _time;
+    entry->parked = entry->owner->paused;
+    // the update loop places a due timer again once it is updated
+    if (!entry->parked && !entry->updating)
+    {
+        insertTimer(entry);
+    }
+}
 
-    if (! element)
+void Scheduler::removeTimer(TimerEntry *entry)
+{
+    auto owner = entry->owner;
+    detachTimer(entry);
+    owner->timers.erase(std::find(owner->timers.begin(), owner->timers.end(), entry));
+    entry->removed = true;
+
+    if (entry == _currentTimer)
+    {
+        // stops it from triggering again in the update that is running
+        entry->timer->setAborted();
+    }
+    if (_timersLocked)
+    {
+        _removedTimers.push_back(entry);
+    }
+    else
+    {
+        entry->timer->release();
+        delete entry;
+    }
+
+    if (owner->timers.empty())
     {
-        element = (tHashTimerEntry *)calloc(sizeof(*element), 1);
-        element->target = target;
+        _timerTargets.erase(owner->target);
+        delete owner;
+    }
+}
 
-        HASH_ADD_PTR(_hashForTimers, target, element);
+void Scheduler::insertTimer(TimerEntry *entry)
+{
+    // a timer waits in one slot at most
+    detachTimer(entry);
+    const auto due = entry->lastUpdate + entry->timer->getTimeToTrigger();
+    entry->dueTick = static_cast<uint64_t>(due * TIMER_TICKS_PER_SECOND);
+    placeTimer(entry);
+}
 
-        // Is this the 1st element ? Then set the pause level to all the selectors of this target
-        element->paused = paused;
+void Scheduler::placeTimer(TimerEntry *entry)
+{
+    if (entry->dueTick <= _wheelTick)
+    {
+        entry->slot = &_nextFrameTimers;
     }
     else
     {
-        CCASSERT(element->paused == paused, "element's paused should be paused!");
+        // the level of the highest digit where the due tick and the current tick differ, the slot of that level
+        // is reached, and its timers are placed again in a lower level, before the due tick
+        auto level = 0;
+        while (level < WHEEL_LEVELS
+            && (entry->dueTick >> (WHEEL_BITS * (level + 1))) != (_wheelTick >> (WHEEL_BITS * (level + 1))))
+        {
+            ++level;
+        }
+        if (level == WHEEL_LEVELS)
+        {
+            // further than the wheel turns: it waits in the next slot of the last level, and moves again from there
+            level = WHEEL_LEVELS - 1;
+            const auto next = (_wheelTick >> (WHEEL_BITS * level)) + 1;
+            entry->slot = &_wheel[level][next & (WHEEL_SLOTS - 1)];
+        }
+        else
+        {
+            entry->slot = &_wheel[level][(entry->dueTick >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)];
+        }
+    }
+    entry->slotIndex = entry->slot->size();
+    entry->slot->push_back(entry);
+}
+
+void Scheduler::detachTimer(TimerEntry *entry)
+{
+    if (entry->slot)
+    {
+        auto& slot = *entry->slot;
+        slot[entry->slotIndex] = slot.back();
+        slot[entry->slotIndex]->slotIndex = entry->slotIndex;
+        slot.pop_back();
+        entry->slot = nullptr;
+    }
+}
+
+void Scheduler::drainSlot(std::vector<TimerEntry*>& slot)
+{
+    for (auto entry : slot)
+    {
+        entry->slot = nullptr;
+        entry->updating = true;
+        _dueTimers.push_back(entry);
     }
+    slot.clear();
+}
 
-    if (element->timers == nullptr)
+void Scheduler::advanceWheel()
+{
+    const auto tick = static_cast<uint64_t>(_time * TIMER_TICKS_PER_SECOND);
+    if (tick - _wheelTick > static_cast<uint64_t>(WHEEL_SLOTS * WHEEL_SLOTS))
     {
-        element->timers = ccArrayNew(10);
+        // a long frame: every timer is updated, and placed again from the new tick
+        for (auto& level : _wheel)
+        {
+            for (auto& slot : level)
+            {
+                drainSlot(slot);
+            }
+        }
+        _wheelTick = tick;
+        drainSlot(_nextFrameTimers);
+        return;
     }
-    else 
+
+    std::vector<TimerEntry*> cascading;
+    while (_wheelTick < tick)
     {
-        for (int i = 0; i < element->timers->num; ++i)
+        ++_wheelTick;
+        // when a lower level wraps around, the timers of the next slot of the level above move down
+        for (auto level = WHEEL_LEVELS - 1; level > 0; --level)
         {
-            TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(element->timers->arr[i]);
+            if ((_wheelTick & ((static_cast<uint64_t>(1) << (WHEEL_BITS * level)) - 1)) == 0)
+            {
+                cascading.swap(_wheel[level][(_wheelTick >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)]);
+                for (auto entry : cascading)
+                {
+                    placeTimer(entry);
+                }
+                cascading.clear();
+            }
+        }
+        drainSlot(_wheel[0][_wheelTick & (WHEEL_SLOTS - 1)]);
+    }
+    // last, with the timers the cascades found due already
+    drainSlot(_nextFrameTimers);
+}
+
+void Scheduler::pauseTimerTarget(TimerTarget *owner)
+{
+    if (! owner->paused)
+    {
+        owner->paused = true;
+        owner->pausedAt = _time;
+    }
+}
 
-            if (timer && !timer->isExhausted() && key == timer->getKey())
+void Scheduler::resumeTimerTarget(TimerTarget *owner)
+{
+    if (! owner->paused)
+    {
+        return;
+    }
+    owner->paused = false;
+    // the time spent paused does not count
+    const auto pausedFor = _time - owner->pausedAt;
+    for (auto entry : owner->timers)
+    {
+        entry->lastUpdate += pausedFor;
+        if (entry->parked)
+        {
+            entry->parked = false;
+            // restarted while it is updated: the update loop places it
+            if (!entry->updating)
             {
-                CCLOG("CCScheduler#schedule. Reiniting timer with interval %.4f, repeat %u, delay %.4f", interval, repeat, delay);
-                timer->setupTimerWithInterval(interval, repeat, delay);
-                return;
+                insertTimer(entry);
             }
         }
-        ccArrayEnsureExtraCapacity(element->timers, 1);
+    }
+}
+
+void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, bool paused, const std::string& key)
+{
+    this->schedule(callback, target, interval, CC_REPEAT_FOREVER, 0.0f, paused, key);
+}
+
+void Scheduler::schedule(const ccSchedulerFunc& callback, void *target, float interval, unsigned int repeat, float delay, bool paused, const std::string& key)
+{
+    CCASSERT(target, "Argument target must be non-nullptr");
+    CCASSERT(!key.empty(), "key should not be empty!");
+
+    auto owner = timerTargetFor(target, paused);
+    for (auto entry : owner->timers)
+    {
+        TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(entry->timer);
+
+        if (timer && !timer->isExhausted() && key == timer->getKey())
+        {
+            CCLOG("CCScheduler#schedule. Reiniting timer with interval %.4f, repeat %u, delay %.4f", interval, repeat, delay);
+            timer->setupTimerWithInterval(interval, repeat, delay);
+            restartTimer(entry);
+            return;
+        }
     }
 
     TimerTargetCallback *timer = new (std::nothrow) TimerTargetCallback();
     timer->initWithCallback(this, callback, target, key, interval, repeat, delay);
-    ccArrayAppendObject(element->timers, timer);
-    timer->release();
+    addTimer(owner, timer);
 }
 
 void Scheduler::unschedule(const std::string &key, void *target)
@@ -341,137 +532,78 @@ void Scheduler::unschedule(const std::string &key, void *target)
         return;
     }
 
-    //CCASSERT(target);
-    //CCASSERT(selector);
-
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-
-    if (element)
+    auto owner = findTimerTarget(target);
+    if (owner)
     {
-        for (int i = 0; i < element->timers->num; ++i)
+        for (auto entry : owner->timers)
         {
-            TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(element->timers->arr[i]);
+            TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(entry->timer);
 
             if (timer && key == timer->getKey())
             {
-                if (timer == element->currentTimer && (! timer->isAborted()))
-                {
-                    timer->retain();
-                    timer->setAborted();
-                }
-
-                ccArrayRemoveObjectAtIndex(element->timers, i, true);
-
-                // update timerIndex in case we are in tick:, looping over the actions
-                if (element->timerIndex >= i)
-                {
-                    element->timerIndex--;
-                }
-
-                if (element->timers->num == 0)
-                {
-                    if (_currentTarget == element)
-                    {
-                        _currentTargetSalvaged = true;
-                    }
-                    else
-                    {
-                        removeHashElement(element);
-                    }
-                }
-
+                removeTimer(entry);
                 return;
             }
         }
     }
 }
 
-void Scheduler::priorityIn(tListEntry **list, const ccSchedulerFunc& callback, void *target, int priority, bool paused)
+Scheduler::UpdateEntry* Scheduler::findUpdate(const void *target)
 {
-    tListEntry *listElement = new (std::nothrow) tListEntry();
-
-    listElement->callback = callback;
-    listElement->target = target;
-    listElement->priority = priority;
-    listElement->paused = paused;
-    listElement->next = listElement->prev = nullptr;
-    listElement->markedForDeletion = false;
-
-    // empty list ?
-    if (! *list)
+    auto found = _updateIndices.find(target);
+    if (found != _updateIndices.end())
     {
-        DL_APPEND(*list, listElement);
+        return &_updates[found->second];
     }
-    else
+    for (auto& entry : _updatesToAdd)
     {
-        bool added = false;
-
-        for (tListEntry *element = *list; element; element = element->next)
+        if (entry.target == target)
         {
-            if (priority < element->priority)
-            {
-                if (element == *list)
-                {
-                    DL_PREPEND(*list, listElement);
-                }
-                else
-                {
-                    listElement->next = element;
-                    listElement->prev = element->prev;
-
-                    element->prev->next = listElement;
-                    element->prev = listElement;
-                }
-
-                added = true;
-                break;
-            }
+            return &entry;
         }
+    }
+    return nullptr;
+}
 
-        // Not added? priority has the higher value. Append it.
-        if (! added)
+void Scheduler::insertUpdate(UpdateEntry&& entry)
+{
+    // after the updates of the same priority
+    auto position = std::upper_bound(_updates.begin(), _updates.end(), entry.priority,
+        [](int priority, const UpdateEntry& update) { return priority < update.priority; });
+    auto index = static_cast<size_t>(position - _updates.begin());
+    _updates.insert(position, std::move(entry));
+
+    for (auto i = index; i < _updates.size(); ++i)
+    {
+        if (! _updates[i].removed)
         {
-            DL_APPEND(*list, listElement);
+            _updateIndices[_updates[i].target] = i;
         }
     }
-
-    // update hash entry for quick access
-    tHashUpdateEntry *hashElement = (tHashUpdateEntry *)calloc(sizeof(*hashElement), 1);
-    hashElement->target = target;
-    hashElement->list = list;
-    hashElement->entry = listElement;
-    HASH_ADD_PTR(_hashForUpdates, target, hashElement);
 }
 
-void Scheduler::appendIn(_listEntry **list, const ccSchedulerFunc& callback, void *target, bool paused)
+void Scheduler::compactUpdates()
 {
-    tListEntry *listElement = new (std::nothrow) tListEntry();
-
-    listElement->callback = callback;
-    listElement->target = target;
-    listElement->paused = paused;
-    listElement->priority = 0;
-    listElement->markedForDeletion = false;
-
-    DL_APPEND(*list, listElement);
-
-    // update hash entry for quicker access
-    tHashUpdateEntry *hashElement = (tHashUpdateEntry *)calloc(sizeof(*hashElement), 1);
-    hashElement->target = target;
-    hashElement->list = list;
-    hashElement->entry = listElement;
-    HASH_ADD_PTR(_hashForUpdates, target, hashElement);
+    auto isRemoved = [](const UpdateEntry& update) { return update.removed; };
+    // only the updates after the first removed one move
+    auto first = std::find_if(_updates.begin(), _updates.end(), isRemoved);
+    auto index = static_cast<size_t>(first - _updates.begin());
+    _updates.erase(std::remove_if(first, _updates.end(), isRemoved), _updates.end());
+    _removedUpdates = 0;
+
+    for (auto i = index; i < _updates.size(); ++i)
+    {
+        _updateIndices[_updates[i].target] = i;
+    }
 }
 
 void Scheduler::schedulePerFrame(const ccSchedulerFunc& callback, void *target, int priority, bool paused)
 {
-    tHashUpdateEntry *hashElement = nullptr;
-    HASH_FIND_PTR(_hashForUpdates, &target, hashElement);
-    if (hashElement)
+    auto existing = findUpdate(target);
+    if (existing)
     {
         // change priority: should unschedule it first
-        if (hashElement->entry->priority != priority)
+        if (existing->priority != priority)
         {
             unscheduleUpdate(target);
         }
@@ -483,20 +615,19 @@ void Scheduler::schedulePerFrame(const ccSchedulerFunc& callback, void *target,
         }
     }
 
-    // most of the updates are going to be 0, that's way there
-    // is an special list for updates with priority 0
-    if (priority == 0)
-    {
-        appendIn(&_updates0List, callback, target, paused);
-    }
-    else if (priority < 0)
+    UpdateEntry entry;
+    entry.callback = callback;
+    entry.target = target;
+    entry.priority = priority;
+    entry.paused = paused;
+    entry.removed = false;
+    if (_updatesLocked)
     {
-        priorityIn(&_updatesNegList, callback, target, priority, paused);
+        _updatesToAdd.push_back(std::move(entry));
     }
     else
     {
-        // priority > 0
-        priorityIn(&_updatesPosList, callback, target, priority, paused);
+        insertUpdate(std::move(entry));
     }
 }
 
@@ -505,22 +636,15 @@ bool Scheduler::isScheduled(const std::string& key, const void *target) const
     CCASSERT(!key.empty(), "Argument key must not be empty");
     CCASSERT(target, "Argument target must be non-nullptr");
     
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    
-    if (!element)
-    {
-        return false;
-    }
-    
-    if (element->timers == nullptr)
+    auto owner = findTimerTarget(target);
+    if (!owner)
     {
         return false;
     }
     
-    for (int i = 0; i < element->timers->num; ++i)
+    for (auto entry : owner->timers)
     {
-        TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(element->timers->arr[i]);
+        TimerTargetCallback *timer = dynamic_cast<TimerTargetCallback*>(entry->timer);
         
         if (timer && !timer->isExhausted() && key == timer->getKey())
         {
@@ -531,40 +655,35 @@ bool Scheduler::isScheduled(const std::string& key, const void *target) const
     return false;
 }
 
-void Scheduler::removeUpdateFromHash(struct _listEntry *entry)
+void Scheduler::unscheduleUpdate(void *target)
 {
-    tHashUpdateEntry *element = nullptr;
+    if (target == nullptr)
+    {
+        return;
+    }
 
-    HASH_FIND_PTR(_hashForUpdates, &entry->target, element);
-    if (element)
+    auto found = _updateIndices.find(target);
+    if (found != _updateIndices.end())
     {
-        // list entry
-        DL_DELETE(*element->list, element->entry);
-        if (!_updateHashLocked)
-            CC_SAFE_DELETE(element->entry);
-        else
+        // the entry may be running, it is only removed from the array after the frame
+        _updates[found->second].removed = true;
+        _updateIndices.erase(found);
+        ++_removedUpdates;
+        if (!_updatesLocked && _removedUpdates * 2 > _updates.size())
         {
-            element->entry->markedForDeletion = true;
-            _updateDeleteVector.push_back(element->entry);
+            compactUpdates();
         }
-
-        // hash entry
-        HASH_DEL(_hashForUpdates, element);
-        free(element);
+        return;
     }
-}
 
-void Scheduler::unscheduleUpdate(void *target)
-{
-    if (target == nullptr)
+    for (auto iter = _updatesToAdd.begin(); iter != _updatesToAdd.end(); ++iter)
     {
-        return;
+        if (iter->target == target)
+        {
+            _updatesToAdd.erase(iter);
+            return;
+        }
     }
-
-    tHashUpdateEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForUpdates, &target, element);
-    if (element)
-        this->removeUpdateFromHash(element->entry);
 }
 
 void Scheduler::unscheduleAll(void)
@@ -575,44 +694,32 @@ void Scheduler::unscheduleAll(void)
 void Scheduler::unscheduleAllWithMinPriority(int minPriority)
 {
     // Custom Selectors
-    tHashTimerEntry *element = nullptr;
-    tHashTimerEntry *nextElement = nullptr;
-    for (element = _hashForTimers; element != nullptr;)
+    std::vector<void*> targets;
+    targets.reserve(_timerTargets.size());
+    for (const auto& element : _timerTargets)
     {
-        // element may be removed in unscheduleAllSelectorsForTarget
-        nextElement = (tHashTimerEntry *)element->hh.next;
-        unscheduleAllForTarget(element->target);
-
-        element = nextElement;
+        targets.push_back(element.second->target);
     }
-
-    // Updates selectors
-    tListEntry *entry, *tmp;
-    if(minPriority < 0)
+    for (auto target : targets)
     {
-        DL_FOREACH_SAFE(_updatesNegList, entry, tmp)
-        {
-            if(entry->priority >= minPriority)
-            {
-                unscheduleUpdate(entry->target);
-            }
-        }
+        unscheduleAllForTarget(target);
     }
 
-    if(minPriority <= 0)
+    // Updates selectors
+    for (auto& entry : _updates)
     {
-        DL_FOREACH_SAFE(_updates0List, entry, tmp)
+        if (!entry.removed && entry.priority >= minPriority)
         {
-            unscheduleUpdate(entry->target);
+            entry.removed = true;
+            _updateIndices.erase(entry.target);
+            ++_removedUpdates;
         }
     }
-
-    DL_FOREACH_SAFE(_updatesPosList, entry, tmp)
+    _updatesToAdd.erase(std::remove_if(_updatesToAdd.begin(), _updatesToAdd.end(),
+        [minPriority](const UpdateEntry& entry) { return entry.priority >= minPriority; }), _updatesToAdd.end());
+    if (!_updatesLocked && _removedUpdates > 0)
     {
-        if(entry->priority >= minPriority)
-        {
-            unscheduleUpdate(entry->target);
-        }
+        compactUpdates();
     }
 #if CC_ENABLE_SCRIPT_BINDING
     _scriptHandlerEntries.clear();
@@ -628,26 +735,13 @@ void Scheduler::unscheduleAllForTarget(void *target)
     }
 
     // Custom Selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-
-    if (element)
+    auto owner = findTimerTarget(target);
+    if (owner)
     {
-        if (ccArrayContainsObject(element->timers, element->currentTimer)
-            && (! element->currentTimer->isAborted()))
+        // owner is deleted with its last timer
+        for (auto count = owner->timers.size(); count > 0; --count)
         {
-            element->currentTimer->retain();
-            element->currentTimer->setAborted();
-        }
-        ccArrayRemoveAllObjects(element->timers);
-
-        if (_currentTarget == element)
-        {
-            _currentTargetSalvaged = true;
-        }
-        else
-        {
-            removeHashElement(element);
+            removeTimer(owner->timers.back());
         }
     }
 
@@ -683,20 +777,17 @@ void Scheduler::resumeTarget(void *target)
     CCASSERT(target != nullptr, "target can't be nullptr!");
 
     // custom selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    if (element)
+    auto owner = findTimerTarget(target);
+    if (owner)
     {
-        element->paused = false;
+        resumeTimerTarget(owner);
     }
 
     // update selector
-    tHashUpdateEntry *elementUpdate = nullptr;
-    HASH_FIND_PTR(_hashForUpdates, &target, elementUpdate);
-    if (elementUpdate)
+    auto update = findUpdate(target);
+    if (update)
     {
-        CCASSERT(elementUpdate->entry != nullptr, "elementUpdate's entry can't be nullptr!");
-        elementUpdate->entry->paused = false;
+        update->paused = false;
     }
 }
 
@@ -705,20 +796,17 @@ void Scheduler::pauseTarget(void *target)
     CCASSERT(target != nullptr, "target can't be nullptr!");
 
     // custom selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    if (element)
+    auto owner = findTimerTarget(target);
+    if (owner)
     {
-        element->paused = true;
+        pauseTimerTarget(owner);
     }
 
     // update selector
-    tHashUpdateEntry *elementUpdate = nullptr;
-    HASH_FIND_PTR(_hashForUpdates, &target, elementUpdate);
-    if (elementUpdate)
+    auto update = findUpdate(target);
+    if (update)
     {
-        CCASSERT(elementUpdate->entry != nullptr, "elementUpdate's entry can't be nullptr!");
-        elementUpdate->entry->paused = true;
+        update->paused = true;
     }
 }
 
@@ -727,19 +815,17 @@ bool Scheduler::isTargetPaused(void *target)
     CCASSERT( target != nullptr, "target must be non nil" );
 
     // Custom selectors
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    if( element )
+    auto owner = findTimerTarget(target);
+    if( owner )
     {
-        return element->paused;
+        return owner->paused;
     }
     
     // We should check update selectors if target does not have custom selectors
-    tHashUpdateEntry *elementUpdate = nullptr;
-    HASH_FIND_PTR(_hashForUpdates, &target, elementUpdate);
-    if ( elementUpdate )
+    auto update = findUpdate(target);
+    if ( update )
     {
-        return elementUpdate->entry->paused;
+        return update->paused;
     }
     
     return false;  // should never get here
@@ -755,42 +841,27 @@ std::set<void*> Scheduler::pauseAllTargetsWithMinPriority(int minPriority)
     std::set<void*> idsWithSelectors;
 
     // Custom Selectors
-    for(tHashTimerEntry *element = _hashForTimers; element != nullptr;
-        element = (tHashTimerEntry*)element->hh.next)
+    for (const auto& element : _timerTargets)
     {
-        element->paused = true;
-        idsWithSelectors.insert(element->target);
+        pauseTimerTarget(element.second);
+        idsWithSelectors.insert(element.second->target);
     }
 
     // Updates selectors
-    tListEntry *entry, *tmp;
-    if(minPriority < 0)
+    for (auto& entry : _updates)
     {
-        DL_FOREACH_SAFE( _updatesNegList, entry, tmp ) 
+        if (!entry.removed && entry.priority >= minPriority)
         {
-            if(entry->priority >= minPriority)
-            {
-                entry->paused = true;
-                idsWithSelectors.insert(entry->target);
-            }
+            entry.paused = true;
+            idsWithSelectors.insert(entry.target);
         }
     }
-
-    if(minPriority <= 0)
+    for (auto& entry : _updatesToAdd)
     {
-        DL_FOREACH_SAFE( _updates0List, entry, tmp )
+        if (entry.priority >= minPriority)
         {
-            entry->paused = true;
-            idsWithSelectors.insert(entry->target);
-        }
-    }
-
-    DL_FOREACH_SAFE( _updatesPosList, entry, tmp ) 
-    {
-        if(entry->priority >= minPriority) 
-        {
-            entry->paused = true;
-            idsWithSelectors.insert(entry->target);
+            entry.paused = true;
+            idsWithSelectors.insert(entry.target);
         }
     }
 
@@ -806,109 +877,91 @@ void Scheduler::resumeTargets(const std::set<void*>& targetsToResume)
 
 void Scheduler::performFunctionInCocosThread(std::function<void ()> function)
 {
-    std::lock_guard<std::mutex> lock(_performMutex);
-    _functionsToPerform.push_back(std::move(function));
+    _dispatchQueue.push(std::move(function));
 }
 
 void Scheduler::removeAllFunctionsToBePerformedInCocosThread()
 {
-    std::unique_lock<std::mutex> lock(_performMutex);
-    _functionsToPerform.clear();
+    _dispatchQueue.clear();
 }
 
 // main loop
 void Scheduler::update(float dt)
 {
-    _updateHashLocked = true;
-
     if (_timeScale != 1.0f)
     {
         dt *= _timeScale;
     }
+    _time += dt;
 
     //
     // Selector callbacks
     //
 
-    // Iterate over all the Updates' selectors
-    tListEntry *entry, *tmp;
-
-    // updates with priority < 0
-    DL_FOREACH_SAFE(_updatesNegList, entry, tmp)
+    // Iterate over all the Updates' selectors, by priority. Nothing is inserted or erased while they run,
+    // so the array is not reallocated under them.
+    _updatesLocked = true;
+    for (size_t i = 0, count = _updates.size(); i < count; ++i)
     {
-        if ((! entry->paused) && (! entry->markedForDeletion))
+        const auto& entry = _updates[i];
+        if ((! entry.paused) && (! entry.removed))
         {
-            entry->callback(dt);
+            entry.callback(dt);
         }
     }
+    _updatesLocked = false;
 
-    // updates with priority == 0
-    DL_FOREACH_SAFE(_updates0List, entry, tmp)
+    if (_removedUpdates > 0)
     {
-        if ((! entry->paused) && (! entry->markedForDeletion))
-        {
-            entry->callback(dt);
-        }
+        compactUpdates();
     }
-
-    // updates with priority > 0
-    DL_FOREACH_SAFE(_updatesPosList, entry, tmp)
+    for (auto& entry : _updatesToAdd)
     {
-        if ((! entry->paused) && (! entry->markedForDeletion))
-        {
-            entry->callback(dt);
-        }
+        insertUpdate(std::move(entry));
     }
+    _updatesToAdd.clear();
 
-    // Iterate over all the custom selectors
-    for (tHashTimerEntry *elt = _hashForTimers; elt != nullptr; )
+    // Update the custom selectors that may trigger in this frame
+    advanceWheel();
+    _timersLocked = true;
+    for (size_t i = 0; i < _dueTimers.size(); ++i)
     {
-        _currentTarget = elt;
-        _currentTargetSalvaged = false;
-
-        if (! _currentTarget->paused)
+        auto entry = _dueTimers[i];
+        if (!entry->removed && !entry->owner->paused)
         {
-            // The 'timers' array may change while inside this loop
-            for (elt->timerIndex = 0; elt->timerIndex < elt->timers->num; ++(elt->timerIndex))
-            {
-                elt->currentTimer = (Timer*)(elt->timers->arr[elt->timerIndex]);
-                CCASSERT
-                  ( !elt->currentTimer->isAborted(),
-                    "An aborted timer should not be updated" );
-
-                elt->currentTimer->update(dt);
-
-                if (elt->currentTimer->isAborted())
-                {
-                    // The currentTimer told the remove itself. To prevent the timer from
-                    // accidentally deallocating itself before finishing its step, we retained
-                    // it. Now that step is done, it's safe to release it.
-                    elt->currentTimer->release();
-                }
-
-                elt->currentTimer = nullptr;
-            }
+            const auto elapsed = static_cast<float>(_time - entry->lastUpdate);
+            entry->lastUpdate = _time;
+            _currentTimer = entry;
+            CCASSERT(!entry->timer->isAborted(), "An aborted timer should not be updated");
+            entry->timer->update(elapsed);
+            _currentTimer = nullptr;
         }
+        entry->updating = false;
 
-        // elt, at this moment, is still valid
-        // so it is safe to ask this here (issue #490)
-        elt = (tHashTimerEntry *)elt->hh.next;
-
-        // only delete currentTarget if no actions were scheduled during the cycle (issue #481)
-        if (_currentTargetSalvaged && _currentTarget->timers->num == 0)
+        if (entry->removed)
+        {
+            continue;
+        }
+        if (entry->owner->paused)
         {
-            removeHashElement(_currentTarget);
+            // placed again when its target is resumed
+            entry->parked = true;
+        }
+        else
+        {
+            insertTimer(entry);
         }
     }
- 
-    // delete all updates that are removed in update
-    for (auto &e : _updateDeleteVector)
-        delete e;
+    _dueTimers.clear();
+    _timersLocked = false;
 
-    _updateDeleteVector.clear();
-
-    _updateHashLocked = false;
-    _currentTarget = nullptr;
+    // delete all timers that are removed in update
+    for (auto entry : _removedTimers)
+    {
+        entry->timer->release();
+        delete entry;
+    }
+    _removedTimers.clear();
 
 #if CC_ENABLE_SCRIPT_BINDING
     //
@@ -936,66 +989,32 @@ void Scheduler::update(float dt)
     // Functions allocated from another thread
     //
 
-    // Testing size is faster than locking / unlocking.
-    // And almost never there will be functions scheduled to be called.
-    if( !_functionsToPerform.empty() ) {
-        _performMutex.lock();
-        // fixed #4123: Save the callback functions, they must be invoked after '_performMutex.unlock()', otherwise if new functions are added in callback, it will cause thread deadlock.
-        auto temp = std::move(_functionsToPerform);
-        _performMutex.unlock();
-        
-        for (const auto &function : temp) {
-            function();
-        }
-    }
+    // Nothing is locked while they run, so they can queue more functions, which wait for the next frame
+    // like those left over the budget.
+    _dispatchQueue.perform(_dispatchBudget);
 }
 
 void Scheduler::schedule(SEL_SCHEDULE selector, Ref *target, float interval, unsigned int repeat, float delay, bool paused)
 {
     CCASSERT(target, "Argument target must be non-nullptr");
     
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    
-    if (! element)
+    auto owner = timerTargetFor(target, paused);
+    for (auto entry : owner->timers)
     {
-        element = (tHashTimerEntry *)calloc(sizeof(*element), 1);
-        element->target = target;
+        TimerTargetSelector *timer = dynamic_cast<TimerTargetSelector*>(entry->timer);
         
-        HASH_ADD_PTR(_hashForTimers, target, element);
-        
-        // Is this the 1st element ? Then set the pause level to all the selectors of this target
-        element->paused = paused;
-    }
-    else
-    {
-        CCASSERT(element->paused == paused, "element's paused should be paused.");
-    }
-    
-    if (element->timers == nullptr)
-    {
-        element->timers = ccArrayNew(10);
-    }
-    else
-    {
-        for (int i = 0; i < element->timers->num; ++i)
+        if (timer && !timer->isExhausted() && selector == timer->getSelector())
         {
-            TimerTargetSelector *timer = dynamic_cast<TimerTargetSelector*>(element->timers->arr[i]);
-            
-            if (timer && !timer->isExhausted() && selector == timer->getSelector())
-            {
-                CCLOG("CCScheduler#schedule. Reiniting timer with interval %.4f, repeat %u, delay %.4f", interval, repeat, delay);
-                timer->setupTimerWithInterval(interval, repeat, delay);
-                return;
-            }
+            CCLOG("CCScheduler#schedule. Reiniting timer with interval %.4f, repeat %u, delay %.4f", interval, repeat, delay);
+            timer->setupTimerWithInterval(interval, repeat, delay);
+            restartTimer(entry);
+            return;
         }
-        ccArrayEnsureExtraCapacity(element->timers, 1);
     }
     
     TimerTargetSelector *timer = new (std::nothrow) TimerTargetSelector();
     timer->initWithSelector(this, selector, target, interval, repeat, delay);
-    ccArrayAppendObject(element->timers, timer);
-    timer->release();
+    addTimer(owner, timer);
 }
 
 void Scheduler::schedule(SEL_SCHEDULE selector, Ref *target, float interval, bool paused)
@@ -1008,22 +1027,15 @@ bool Scheduler::isScheduled(SEL_SCHEDULE selector, const Ref *target) const
     CCASSERT(selector, "Argument selector must be non-nullptr");
     CCASSERT(target, "Argument target must be non-nullptr");
     
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    
-    if (!element)
-    {
-        return false;
-    }
-    
-    if (element->timers == nullptr)
+    auto owner = findTimerTarget(target);
+    if (!owner)
     {
         return false;
     }
 
-    for (int i = 0; i < element->timers->num; ++i)
+    for (auto entry : owner->timers)
     {
-        TimerTargetSelector *timer = dynamic_cast<TimerTargetSelector*>(element->timers->arr[i]);
+        TimerTargetSelector *timer = dynamic_cast<TimerTargetSelector*>(entry->timer);
         
         if (timer && !timer->isExhausted() && selector == timer->getSelector())
         {
@@ -1042,43 +1054,16 @@ void Scheduler::unschedule(SEL_SCHEDULE selector, Ref *target)
         return;
     }
     
-    tHashTimerEntry *element = nullptr;
-    HASH_FIND_PTR(_hashForTimers, &target, element);
-    
-    if (element)
+    auto owner = findTimerTarget(target);
+    if (owner)
     {
-        for (int i = 0; i < element->timers->num; ++i)
+        for (auto entry : owner->timers)
         {
-            TimerTargetSelector *timer = dynamic_cast<TimerTargetSelector*>(element->timers->arr[i]);
+            TimerTargetSelector *timer = dynamic_cast<TimerTargetSelector*>(entry->timer);
             
             if (timer && selector == timer->getSelector())
             {
-                if (timer == element->currentTimer && !timer->isAborted())
-                {
-                    timer->retain();
-                    timer->setAborted();
-                }
-                
-                ccArrayRemoveObjectAtIndex(element->timers, i, true);
-                
-                // update timerIndex in case we are in tick:, looping over the actions
-                if (element->timerIndex >= i)
-                {
-                    element->timerIndex--;
-                }
-                
-                if (element->timers->num == 0)
-                {
-                    if (_currentTarget == element)
-                    {
-                        _currentTargetSalvaged = true;
-                    }
-                    else
-                    {
-                        removeHashElement(element);
-                    }
-                }
-                
+                removeTimer(entry);
                 return;
             }
         }
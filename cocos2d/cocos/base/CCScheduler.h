@@ -28,13 +28,16 @@ THE SOFTWARE.
 #ifndef __CCSCHEDULER_H__
 #define __CCSCHEDULER_H__
 
+#include <cstdint>
 #include <functional>
 #include <mutex>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
+#include "base/CCDispatchQueue.h"
 #include "base/CCRef.h"
 #include "base/CCVector.h"
-#include "base/uthash.h"
 
 NS_CC_BEGIN
 
@@ -54,6 +57,8 @@ public:
     void setAborted() { _aborted = true; }
     bool isAborted() const { return _aborted; }
     bool isExhausted() const;
+    /** Seconds of update() before it triggers again, 0 when the next update() may trigger. */
+    float getTimeToTrigger() const;
     
     virtual void trigger(float dt) = 0;
     virtual void cancel() = 0;
@@ -139,10 +144,6 @@ private:
  * @{
  */
 
-struct _listEntry;
-struct _hashSelectorEntry;
-struct _hashUpdateEntry;
-
 #if CC_ENABLE_SCRIPT_BINDING
 class SchedulerScriptHandlerEntry;
 #endif
@@ -157,6 +158,11 @@ There are 2 different types of callbacks (selectors):
 
 The 'custom selectors' should be avoided when possible. It is faster, and consumes less memory to use the 'update selector'.
 
+The update selectors are kept in one array sorted by priority, iterated in order every frame; an unscheduled
+one is only marked as removed, and the array is compacted after the frame. The custom selectors wait in a
+hierarchical timer wheel and are only updated in the frames where they may trigger, so a timer with a long
+interval costs nothing in the frames in between.
+
 */
 class CC_DLL Scheduler : public Ref
 {
@@ -174,6 +180,13 @@ public:
      * @js NA
      */
     static const int PRIORITY_NON_SYSTEM_MIN;
+
+    /** Seconds a frame spends on the functions queued by performFunctionInCocosThread, a quarter of a 60 fps frame.
+     *
+     * @lua NA
+     * @js NA
+     */
+    static const float DEFAULT_DISPATCH_BUDGET;
     
     /**
      * Constructor
@@ -421,7 +434,8 @@ public:
     void resumeTargets(const std::set<void*>& targetsToResume);
 
     /** Calls a function on the cocos2d thread. Useful when you need to call a cocos2d function from another thread.
-     This function is thread safe.
+     This function is thread safe, it does not lock unless DispatchQueue::DEFAULT_CAPACITY functions are already waiting.
+     The functions are performed in update(), in the order each thread queued them, until the dispatch budget is spent.
      @param function The function to be run in cocos2d thread.
      @since v3.0
      @js NA
@@ -436,6 +450,20 @@ public:
      * @js NA
      */
     void removeAllFunctionsToBePerformedInCocosThread();
+
+    /** Sets how long update() keeps performing the functions queued by performFunctionInCocosThread, at least
+     one is performed each frame and the others wait for the next frames. 0 performs them all, as before.
+     The default is DEFAULT_DISPATCH_BUDGET.
+     @param seconds The budget in seconds.
+     @js NA
+     */
+    void setDispatchBudget(float seconds) { _dispatchBudget = seconds; }
+    float getDispatchBudget() const { return _dispatchBudget; }
+
+    /** The queue of performFunctionInCocosThread, for its depth and what each frame performed.
+     @js NA
+     */
+    const DispatchQueue& getDispatchQueue() const { return _dispatchQueue; }
     
     /////////////////////////////////////
     
@@ -505,41 +533,75 @@ protected:
      @js _schedulePerFrame
      */
     void schedulePerFrame(const ccSchedulerFunc& callback, void *target, int priority, bool paused);
-    
-    void removeHashElement(struct _hashSelectorEntry *element);
-    void removeUpdateFromHash(struct _listEntry *entry);
 
-    // update specific
+    // the timer wheel: WHEEL_LEVELS levels of WHEEL_SLOTS slots, a slot of level n lasts WHEEL_SLOTS^n ticks
+    static const int WHEEL_BITS = 6;
+    static const int WHEEL_SLOTS = 1 << WHEEL_BITS;
+    static const int WHEEL_LEVELS = 4;
+
+    struct UpdateEntry
+    {
+        ccSchedulerFunc callback;
+        void *target;
+        int priority;
+        bool paused;
+        // unscheduled, it stays in place until the array is compacted
+        bool removed;
+    };
+    struct TimerEntry;
+    struct TimerTarget;
 
-    void priorityIn(struct _listEntry **list, const ccSchedulerFunc& callback, void *target, int priority, bool paused);
-    void appendIn(struct _listEntry **list, const ccSchedulerFunc& callback, void *target, bool paused);
+    // update specific
 
+    UpdateEntry* findUpdate(const void *target);
+    void insertUpdate(UpdateEntry&& entry);
+    void compactUpdates();
+
+    // timer specific
+
+    TimerTarget* findTimerTarget(const void *target) const;
+    TimerTarget* timerTargetFor(void *target, bool paused);
+    void addTimer(TimerTarget *owner, Timer *timer);
+    void restartTimer(TimerEntry *entry);
+    void removeTimer(TimerEntry *entry);
+    void insertTimer(TimerEntry *entry);
+    void placeTimer(TimerEntry *entry);
+    void detachTimer(TimerEntry *entry);
+    void advanceWheel();
+    void drainSlot(std::vector<TimerEntry*>& slot);
+    void pauseTimerTarget(TimerTarget *owner);
+    void resumeTimerTarget(TimerTarget *owner);
 
     float _timeScale;
+    // scaled time since the scheduler was created
+    double _time;
 
     //
     // "updates with priority" stuff
     //
-    struct _listEntry *_updatesNegList;        // list of priority < 0
-    struct _listEntry *_updates0List;            // list priority == 0
-    struct _listEntry *_updatesPosList;        // list priority > 0
-    struct _hashUpdateEntry *_hashForUpdates; // hash used to fetch quickly the list entries for pause,delete,etc
-    std::vector<struct _listEntry *> _updateDeleteVector; // the vector holds list entries that needs to be deleted after update
+    std::vector<UpdateEntry> _updates; // sorted by priority, then by the order they were scheduled in
+    std::unordered_map<const void*, size_t> _updateIndices; // index in _updates of each scheduled target, for pause, delete, etc
+    std::vector<UpdateEntry> _updatesToAdd; // scheduled while _updates is iterated, inserted after
+    size_t _removedUpdates;
+    bool _updatesLocked;
 
     // Used for "selectors with interval"
-    struct _hashSelectorEntry *_hashForTimers;
-    struct _hashSelectorEntry *_currentTarget;
-    bool _currentTargetSalvaged;
-    // If true unschedule will not remove anything from a hash. Elements will only be marked for deletion.
-    bool _updateHashLocked;
+    std::unordered_map<const void*, TimerTarget*> _timerTargets;
+    std::vector<TimerEntry*> _wheel[WHEEL_LEVELS][WHEEL_SLOTS];
+    std::vector<TimerEntry*> _nextFrameTimers; // due in the tick that already began
+    std::vector<TimerEntry*> _dueTimers; // updated this frame
+    std::vector<TimerEntry*> _removedTimers; // unscheduled while _dueTimers is iterated, deleted after
+    uint64_t _wheelTick;
+    TimerEntry *_currentTimer;
+    bool _timersLocked;
     
 #if CC_ENABLE_SCRIPT_BINDING
     Vector<SchedulerScriptHandlerEntry*> _scriptHandlerEntries;
 #endif
     
     // Used for "perform Function"
-    std::vector<std::function<void()>> _functionsToPerform;
-    std::mutex _performMutex;
+    DispatchQueue _dispatchQueue;
+    float _dispatchBudget;
 };
 
 // end of base group
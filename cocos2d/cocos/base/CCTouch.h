@@ -26,6 +26,8 @@ THE SOFTWARE.
 #ifndef __CC_TOUCH_H__
 #define __CC_TOUCH_H__
 
+#include <chrono>
+
 #include "base/CCRef.h"
 #include "math/CCGeometry.h"
 
@@ -153,6 +155,22 @@ public:
     {
         return _id;
     }
+    /** Set when the current touch sample was received, GLView does it.
+     *
+     * @param timestamp Time of the sample on the steady clock.
+     */
+    void setTimestamp(const std::chrono::steady_clock::time_point& timestamp)
+    {
+        _timestamp = timestamp;
+    }
+    /** Returns when GLView received the current touch sample, to measure input latency.
+     *
+     * @return Time of the sample on the steady clock.
+     */
+    const std::chrono::steady_clock::time_point& getTimestamp() const
+    {
+        return _timestamp;
+    }
     /** Returns the current touch force for 3d touch.
      *
      * @return The current touch force for 3d touch.
@@ -172,6 +190,7 @@ private:
     Vec2 _prevPoint;
     float _curForce;
     float _maxForce;
+    std::chrono::steady_clock::time_point _timestamp;
 };
 
 // end of base group
@@ -348,6 +348,16 @@ THE SOFTWARE.
   #endif
 #endif
 
+/** @def CC_ENABLE_FRAME_ARENA
+ * Route the allocations of Ref through FrameArena, which stays off until
+ * FrameArena::setCapacity() is called. Off by default: every Ref delete then
+ * checks whether the object is in the arena, which only pays off for a game
+ * that opens FrameArena::Scope around the objects it drops within the frame.
+ */
+#ifndef CC_ENABLE_FRAME_ARENA
+# define CC_ENABLE_FRAME_ARENA 0
+#endif
+
 /** @def CC_ENABLE_ALLOCATOR
  * Turn on creation of global allocator and pool allocators
  * as specified by CC_ALLOCATOR_GLOBAL below.
@@ -44,6 +44,10 @@ THE SOFTWARE.
 #include "base/CCConsole.h"
 #include "base/CCData.h"
 #include "base/CCDirector.h"
+#include "base/CCFrameStats.h"
+#include "base/CCFrameTelemetry.h"
+#include "base/CCFrameArena.h"
+#include "base/CCDispatchQueue.h"
 #include "base/CCIMEDelegate.h"
 #include "base/CCIMEDispatcher.h"
 #include "base/CCMap.h"
@@ -25,6 +25,9 @@ THE SOFTWARE.
 
 #include "platform/CCGLView.h"
 
+#include <algorithm>
+#include <thread>
+
 #include "base/CCTouch.h"
 #include "base/CCDirector.h"
 #include "base/CCEventDispatcher.h"
@@ -127,6 +130,13 @@ void GLView::pollEvents()
 {
 }
 
+void GLView::waitEvents(float timeout)
+{
+    // without a way to wait for events, poll them every few milliseconds
+    pollEvents();
+    std::this_thread::sleep_for(std::chrono::duration<float>(std::min(timeout, 0.005f)));
+}
+
 void GLView::updateDesignResolutionSize()
 {
     if (_screenSize.width > 0 && _screenSize.height > 0
@@ -294,6 +304,10 @@ void GLView::handleTouchesBegin(int num, intptr_t ids[], float xs[], float ys[])
     float y = 0.0f;
     int unusedIndex = 0;
     EventTouch touchEvent;
+    // one clock read for the whole batch, the samples arrived together
+    const auto timestamp = std::chrono::steady_clock::now();
+    // a touch brings an idle Director back to its frame rate before it is dispatched
+    Director::getInstance()->wakeUp();
     
     for (int i = 0; i < num; ++i)
     {
@@ -317,6 +331,7 @@ void GLView::handleTouchesBegin(int num, intptr_t ids[], float xs[], float ys[])
             Touch* touch = g_touches[unusedIndex] = new (std::nothrow) Touch();
             touch->setTouchInfo(unusedIndex, (x - _viewPortRect.origin.x) / _scaleX,
                                      (y - _viewPortRect.origin.y) / _scaleY);
+            touch->setTimestamp(timestamp);
             
             CCLOGINFO("x = %f y = %f", touch->getLocationInView().x, touch->getLocationInView().y);
             
@@ -349,6 +364,8 @@ void GLView::handleTouchesMove(int num, intptr_t ids[], float xs[], float ys[],
     float force = 0.0f;
     float maxForce = 0.0f;
     EventTouch touchEvent;
+    const auto timestamp = std::chrono::steady_clock::now();
+    Director::getInstance()->wakeUp();
     
     for (int i = 0; i < num; ++i)
     {
@@ -371,6 +388,7 @@ void GLView::handleTouchesMove(int num, intptr_t ids[], float xs[], float ys[],
         {
             touch->setTouchInfo(iter->second, (x - _viewPortRect.origin.x) / _scaleX,
                                 (y - _viewPortRect.origin.y) / _scaleY, force, maxForce);
+            touch->setTimestamp(timestamp);
             
             touchEvent._touches.push_back(touch);
         }
@@ -399,6 +417,8 @@ void GLView::handleTouchesOfEndOrCancel(EventTouch::EventCode eventCode, int num
     float x = 0.0f;
     float y = 0.0f;
     EventTouch touchEvent;
+    const auto timestamp = std::chrono::steady_clock::now();
+    Director::getInstance()->wakeUp();
     
     for (int i = 0; i < num; ++i)
     {
@@ -420,6 +440,7 @@ void GLView::handleTouchesOfEndOrCancel(EventTouch::EventCode eventCode, int num
             CCLOGINFO("Ending touches with id: %d, x=%f, y=%f", (int)id, x, y);
             touch->setTouchInfo(iter->second, (x - _viewPortRect.origin.x) / _scaleX,
                                 (y - _viewPortRect.origin.y) / _scaleY);
+            touch->setTimestamp(timestamp);
 
             touchEvent._touches.push_back(touch);
             
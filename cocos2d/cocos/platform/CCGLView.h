@@ -159,6 +159,13 @@ public:
     /** Polls the events. */
     virtual void pollEvents();
 
+    /** Waits at most timeout seconds for events and processes them, returns at the first one.
+     * The default implementation polls and sleeps a few milliseconds, subclass should implement it if the
+     * platform can wait for events.
+     * @param timeout In seconds.
+     */
+    virtual void waitEvents(float timeout);
+
     /**
      * Get the frame size of EGL view.
      * In general, it returns the screen size since the EGL view is a fullscreen view.
@@ -233,7 +233,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                 final float xPointerDown = pMotionEvent.getX(indexPointerDown);
                 final float yPointerDown = pMotionEvent.getY(indexPointerDown);
 
-                this.queueEvent(new Runnable() {
+                this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                     @Override
                     public void run() {
                         Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionDown(idPointerDown, xPointerDown, yPointerDown);
@@ -247,7 +247,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                 final float xDown = xs[0];
                 final float yDown = ys[0];
 
-                this.queueEvent(new Runnable() {
+                this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                     @Override
                     public void run() {
                         Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionDown(idDown, xDown, yDown);
@@ -263,7 +263,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                             final int[] idsMove = new int[]{0};
                             final float[] xsMove = new float[]{xs[i]};
                             final float[] ysMove = new float[]{ys[i]};
-                            this.queueEvent(new Runnable() {
+                            this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                                 @Override
                                 public void run() {
                                     Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionMove(idsMove, xsMove, ysMove);
@@ -273,7 +273,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                         }
                     }
                 } else {
-                    this.queueEvent(new Runnable() {
+                    this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                         @Override
                         public void run() {
                             Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionMove(ids, xs, ys);
@@ -291,7 +291,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                 final float xPointerUp = pMotionEvent.getX(indexPointUp);
                 final float yPointerUp = pMotionEvent.getY(indexPointUp);
 
-                this.queueEvent(new Runnable() {
+                this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                     @Override
                     public void run() {
                         Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionUp(idPointerUp, xPointerUp, yPointerUp);
@@ -305,7 +305,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                 final float xUp = xs[0];
                 final float yUp = ys[0];
 
-                this.queueEvent(new Runnable() {
+                this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                     @Override
                     public void run() {
                         Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionUp(idUp, xUp, yUp);
@@ -321,7 +321,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                             final int[] idsCancel = new int[]{0};
                             final float[] xsCancel = new float[]{xs[i]};
                             final float[] ysCancel = new float[]{ys[i]};
-                            this.queueEvent(new Runnable() {
+                            this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                                 @Override
                                 public void run() {
                                     Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionCancel(idsCancel, xsCancel, ysCancel);
@@ -331,7 +331,7 @@ public class Cocos2dxGLSurfaceView extends GLSurfaceView {
                         }
                     }
                 } else {
-                    this.queueEvent(new Runnable() {
+                    this.mCocos2dxRenderer.queueTouchEvent(new Runnable() {
                         @Override
                         public void run() {
                             Cocos2dxGLSurfaceView.this.mCocos2dxRenderer.handleActionCancel(ids, xs, ys);
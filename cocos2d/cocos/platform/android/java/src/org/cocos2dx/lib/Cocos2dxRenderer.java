@@ -25,6 +25,8 @@ package org.cocos2dx.lib;
 
 import android.opengl.GLSurfaceView;
 
+import java.util.concurrent.ConcurrentLinkedQueue;
+
 import javax.microedition.khronos.egl.EGLConfig;
 import javax.microedition.khronos.opengles.GL10;
 public class Cocos2dxRenderer implements GLSurfaceView.Renderer {
@@ -38,6 +40,10 @@ public class Cocos2dxRenderer implements GLSurfaceView.Renderer {
     // The final animation interval which is used in 'onDrawFrame'
     private static long sAnimationInterval = (long) (1.0 / 60 * Cocos2dxRenderer.NANOSECONDSPERSECOND);
 
+    // 'onDrawFrame' waits on it between the frames of a low frame rate, wakeUp() ends the wait
+    private static final Object sFrameLock = new Object();
+    private static boolean sWakeUp = false;
+
     // ===========================================================
     // Fields
     // ===========================================================
@@ -46,6 +52,9 @@ public class Cocos2dxRenderer implements GLSurfaceView.Renderer {
     private int mScreenWidth;
     private int mScreenHeight;
     private boolean mNativeInitCompleted = false;
+    // touches handled at the start of the next frame, GLSurfaceView.queueEvent() would hold those arriving
+    // while a frame waits for a low frame rate until the frame after it
+    private final ConcurrentLinkedQueue<Runnable> mTouchEvents = new ConcurrentLinkedQueue<Runnable>();
 
     // ===========================================================
     // Constructors
@@ -59,6 +68,33 @@ public class Cocos2dxRenderer implements GLSurfaceView.Renderer {
         sAnimationInterval = (long) (interval * Cocos2dxRenderer.NANOSECONDSPERSECOND);
     }
 
+    /*
+     * Called from the UI thread when input arrives, so a frame waiting for a low frame rate starts now
+     * and the input is not held until the end of the wait.
+     */
+    public static void wakeUp() {
+        synchronized (Cocos2dxRenderer.sFrameLock) {
+            Cocos2dxRenderer.sWakeUp = true;
+            Cocos2dxRenderer.sFrameLock.notifyAll();
+        }
+    }
+
+    /*
+     * Called from the UI thread: the touch is handled on the GL thread right before the next frame renders,
+     * which starts now when the GL thread is waiting for a low frame rate.
+     */
+    public void queueTouchEvent(final Runnable touchEvent) {
+        this.mTouchEvents.add(touchEvent);
+        Cocos2dxRenderer.wakeUp();
+    }
+
+    private void handleTouchEvents() {
+        Runnable touchEvent;
+        while ((touchEvent = this.mTouchEvents.poll()) != null) {
+            touchEvent.run();
+        }
+    }
+
     public void setScreenWidthAndHeight(final int surfaceWidth, final int surfaceHeight) {
         this.mScreenWidth = surfaceWidth;
         this.mScreenHeight = surfaceHeight;
@@ -87,21 +123,28 @@ public class Cocos2dxRenderer implements GLSurfaceView.Renderer {
          * since onDrawFrame() was called by system 60 times per second by default.
          */
         if (Cocos2dxRenderer.sAnimationInterval <= 1.0 / 60 * Cocos2dxRenderer.NANOSECONDSPERSECOND) {
+            this.handleTouchEvents();
             Cocos2dxRenderer.nativeRender();
         } else {
             final long now = System.nanoTime();
             final long interval = now - this.mLastTickInNanoSeconds;
         
-            if (interval < Cocos2dxRenderer.sAnimationInterval) {
-                try {
-                    Thread.sleep((Cocos2dxRenderer.sAnimationInterval - interval) / Cocos2dxRenderer.NANOSECONDSPERMICROSECOND);
-                } catch (final Exception e) {
+            synchronized (Cocos2dxRenderer.sFrameLock) {
+                final long wait = (Cocos2dxRenderer.sAnimationInterval - interval) / Cocos2dxRenderer.NANOSECONDSPERMICROSECOND;
+                // wait(0) would wait forever
+                if (wait > 0 && !Cocos2dxRenderer.sWakeUp) {
+                    try {
+                        Cocos2dxRenderer.sFrameLock.wait(wait);
+                    } catch (final Exception e) {
+                    }
                 }
+                Cocos2dxRenderer.sWakeUp = false;
             }
             /*
              * Render time MUST be counted in, or the FPS will slower than appointed.
             */
             this.mLastTickInNanoSeconds = System.nanoTime();
+            this.handleTouchEvents();
             Cocos2dxRenderer.nativeRender();
         }
     }
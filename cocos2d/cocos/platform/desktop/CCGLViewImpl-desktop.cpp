@@ -429,6 +429,16 @@ void GLViewImpl::pollEvents()
     glfwPollEvents();
 }
 
+void GLViewImpl::waitEvents(float timeout)
+{
+    // Linux links the GLFW of the system, which may be older than 3.2
+#if GLFW_VERSION_MAJOR > 3 || GLFW_VERSION_MINOR >= 2
+    glfwWaitEventsTimeout(timeout);
+#else
+    GLView::waitEvents(timeout);
+#endif
+}
+
 void GLViewImpl::enableRetina(bool enabled)
 {
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
@@ -78,6 +78,7 @@ public:
 
     bool windowShouldClose() override;
     void pollEvents() override;
+    void waitEvents(float timeout) override;
     GLFWwindow* getWindow() const { return _mainWindow; }
 
     bool isFullscreen() const;
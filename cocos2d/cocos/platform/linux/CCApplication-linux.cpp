@@ -28,7 +28,6 @@ THE SOFTWARE.
 
 #include "platform/linux/CCApplication-linux.h"
 #include <unistd.h>
-#include <sys/time.h>
 #include <string>
 #include "base/CCDirector.h"
 #include "platform/CCFileUtils.h"
@@ -39,17 +38,7 @@ NS_CC_BEGIN
 // sharedApplication pointer
 Application * Application::sm_pSharedApplication = nullptr;
 
-static long getCurrentMillSecond() {
-    long lLastTime;
-    struct timeval stCurrentTime;
-
-    gettimeofday(&stCurrentTime,NULL);
-    lLastTime = stCurrentTime.tv_sec*1000+stCurrentTime.tv_usec*0.001; // milliseconds
-    return lLastTime;
-}
-
 Application::Application()
-: _animationInterval(1.0f/60.0f*1000.0f)
 {
     CC_ASSERT(! sm_pSharedApplication);
     sm_pSharedApplication = this;
@@ -70,27 +59,36 @@ int Application::run()
         return 0;
     }
 
-    long lastTime = 0L;
-    long curTime = 0L;
-
     auto director = Director::getInstance();
     auto glview = director->getOpenGLView();
 
     // Retain glview to avoid glview being released in the while loop
     glview->retain();
 
+    _framePacer.start();
     while (!glview->windowShouldClose())
     {
-        lastTime = getCurrentMillSecond();
-
         director->mainLoop();
-        glview->pollEvents();
-
-        curTime = getCurrentMillSecond();
-        if (curTime - lastTime < _animationInterval)
+        // Director::drawScene() polls the events, only poll here when it did not run
+        if (!director->isValid())
+        {
+            glview->pollEvents();
+        }
+        // an idle Director draws a few frames a second, wait for input meanwhile rather than sleeping,
+        // a touch wakes the Director up and its frame is drawn at once
+        if (director->isIdle())
         {
-            usleep((_animationInterval - curTime + lastTime)*1000);
+            int64_t timeToNextFrame = 0;
+            while (director->isIdle() && (timeToNextFrame = _framePacer.getTimeToNextFrame()) > 0)
+            {
+                glview->waitEvents(timeToNextFrame / 1e9f);
+            }
+            if (!director->isIdle())
+            {
+                _framePacer.restart();
+            }
         }
+        _framePacer.waitForNextFrame();
     }
     /* Only work on Desktop
     *  Director::mainLoop is really one frame logic
@@ -109,8 +107,7 @@ int Application::run()
 
 void Application::setAnimationInterval(float interval)
 {
-    //TODO do something else
-    _animationInterval = interval*1000.0f;
+    _framePacer.setInterval(static_cast<int64_t>(interval * 1000000000.0));
 }
 
 void Application::setAnimationInterval(float interval, SetIntervalReason reason)
@@ -31,6 +31,7 @@ THE SOFTWARE.
 
 #include "platform/CCCommon.h"
 #include "platform/CCApplicationProtocol.h"
+#include "platform/linux/CCFramePacer-linux.h"
 #include <string>
 
 NS_CC_BEGIN
@@ -108,8 +109,13 @@ public:
      @brief Get target platform
      */
     virtual Platform getTargetPlatform() override;
+
+    /**
+     @brief Paces the frames of run(), and measures the frame times.
+     */
+    const FramePacer& getFramePacer() const { return _framePacer; }
 protected:
-    long       _animationInterval;  //micro second
+    FramePacer _framePacer;
     std::string _resourceRootPath;
     
     static Application * sm_pSharedApplication;
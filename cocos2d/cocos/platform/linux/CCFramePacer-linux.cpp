@@ -0,0 +1,177 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "platform/CCPlatformConfig.h"
+#if CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+
+#include "platform/linux/CCFramePacer-linux.h"
+#include <algorithm>
+#include <cmath>
+#include <errno.h>
+#include <time.h>
+
+NS_CC_BEGIN
+
+namespace
+{
+    const int64_t NANOSECONDS_PER_SECOND = 1000000000LL;
+    // the thread sleeps until at least this long before the deadline, and at most this long
+    const int64_t MIN_SPIN_MARGIN = 100000LL;
+    const int64_t MAX_SPIN_MARGIN = 2000000LL;
+}
+
+FramePacer::FramePacer()
+: _interval(NANOSECONDS_PER_SECOND / 60)
+, _deadline(0)
+, _lastFrame(0)
+, _sleepOvershoot(0.0)
+, _frameTimeCount(0)
+, _frameTimeIndex(0)
+, _frameCount(0)
+, _missedFrames(0)
+{
+}
+
+int64_t FramePacer::now()
+{
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return static_cast<int64_t>(time.tv_sec) * NANOSECONDS_PER_SECOND + time.tv_nsec;
+}
+
+void FramePacer::setInterval(int64_t nanoseconds)
+{
+    _interval = std::max<int64_t>(nanoseconds, 1);
+}
+
+void FramePacer::start()
+{
+    _lastFrame = now();
+    _deadline = _lastFrame;
+    resetStats();
+}
+
+int64_t FramePacer::getSpinMargin() const
+{
+    // twice the usual wake-up delay, a late wake-up costs a frame while spinning only costs power
+    const auto margin = static_cast<int64_t>(_sleepOvershoot * 2.0) + MIN_SPIN_MARGIN;
+    return std::min(margin, MAX_SPIN_MARGIN);
+}
+
+void FramePacer::waitForNextFrame()
+{
+    _deadline += _interval;
+    auto current = now();
+    if (current - _deadline > _interval)
+    {
+        // too late to catch up without a burst of frames, start the schedule again
+        ++_missedFrames;
+        _deadline = current;
+    }
+    else if (current < _deadline)
+    {
+        const auto wakeUp = _deadline - getSpinMargin();
+        if (current < wakeUp)
+        {
+            struct timespec time;
+            time.tv_sec = static_cast<time_t>(wakeUp / NANOSECONDS_PER_SECOND);
+            time.tv_nsec = static_cast<long>(wakeUp % NANOSECONDS_PER_SECOND);
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &time, nullptr) == EINTR)
+            {
+            }
+            // follow wake-up delays up quickly and down slowly
+            const auto overshoot = static_cast<double>(std::max<int64_t>(now() - wakeUp, 0));
+            _sleepOvershoot += (overshoot - _sleepOvershoot) * (overshoot > _sleepOvershoot ? 0.5 : 0.0625);
+        }
+        do
+        {
+            current = now();
+        } while (current < _deadline);
+    }
+
+    _frameTimes[_frameTimeIndex] = static_cast<float>(current - _lastFrame) / 1000000.0f;
+    _frameTimeIndex = (_frameTimeIndex + 1) % HISTORY_SIZE;
+    _frameTimeCount = std::min(_frameTimeCount + 1, static_cast<int>(HISTORY_SIZE));
+    _lastFrame = current;
+    ++_frameCount;
+}
+
+int64_t FramePacer::getTimeToNextFrame() const
+{
+    return _deadline + _interval - now();
+}
+
+void FramePacer::restart()
+{
+    _deadline = now() - _interval;
+}
+
+FramePacer::Stats FramePacer::getStats() const
+{
+    Stats stats;
+    stats.frameCount = _frameCount;
+    stats.missedFrames = _missedFrames;
+    stats.meanMs = 0.0;
+    stats.minMs = 0.0;
+    stats.maxMs = 0.0;
+    stats.jitterMs = 0.0;
+    stats.p99Ms = 0.0;
+    stats.sleepOvershootUs = _sleepOvershoot / 1000.0;
+    if (_frameTimeCount == 0)
+    {
+        return stats;
+    }
+
+    float sorted[HISTORY_SIZE];
+    std::copy(_frameTimes, _frameTimes + _frameTimeCount, sorted);
+    std::sort(sorted, sorted + _frameTimeCount);
+    auto sum = 0.0;
+    for (int i = 0; i < _frameTimeCount; ++i)
+    {
+        sum += sorted[i];
+    }
+    stats.meanMs = sum / _frameTimeCount;
+    auto variance = 0.0;
+    for (int i = 0; i < _frameTimeCount; ++i)
+    {
+        variance += (sorted[i] - stats.meanMs) * (sorted[i] - stats.meanMs);
+    }
+    stats.jitterMs = std::sqrt(variance / _frameTimeCount);
+    stats.minMs = sorted[0];
+    stats.maxMs = sorted[_frameTimeCount - 1];
+    stats.p99Ms = sorted[std::min(_frameTimeCount - 1, _frameTimeCount * 99 / 100)];
+    return stats;
+}
+
+void FramePacer::resetStats()
+{
+    _frameTimeCount = 0;
+    _frameTimeIndex = 0;
+    _frameCount = 0;
+    _missedFrames = 0;
+}
+
+NS_CC_END
+
+#endif // CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
@@ -0,0 +1,112 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_FRAME_PACER_LINUX_H__
+#define __CC_FRAME_PACER_LINUX_H__
+
+#include "platform/CCPlatformConfig.h"
+#if CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+
+#include <cstdint>
+#include "platform/CCPlatformMacros.h"
+
+NS_CC_BEGIN
+
+/**
+ * @brief Paces the frames of Application::run on the monotonic clock, in nanoseconds.
+ *
+ * Deadlines are absolute: each one is the previous deadline plus the interval, so the error of one wait
+ * does not add up over the next frames. A wait sleeps until shortly before the deadline and spins the rest,
+ * the sleep margin follows how late the kernel wakes the thread up. When a frame is late by more than a
+ * whole interval the schedule starts again from now, rather than drawing several frames at once to catch up.
+ */
+class CC_DLL FramePacer
+{
+public:
+    /** Number of recent frames the statistics are computed over. */
+    static const int HISTORY_SIZE = 240;
+
+    /** Frame time statistics, frame time being the time between two frames delivered by waitForNextFrame(). */
+    struct Stats
+    {
+        /** Frames since start() or resetStats(). */
+        unsigned int frameCount;
+        /** Frames that came later than a whole interval after their deadline. */
+        unsigned int missedFrames;
+        /** Over the last HISTORY_SIZE frames, in milliseconds. */
+        double meanMs;
+        double minMs;
+        double maxMs;
+        /** Standard deviation of the frame time. */
+        double jitterMs;
+        double p99Ms;
+        /** How late the kernel currently wakes the thread up, in microseconds. */
+        double sleepOvershootUs;
+    };
+
+    FramePacer();
+
+    /** Current time of the monotonic clock, in nanoseconds. */
+    static int64_t now();
+
+    /** @param nanoseconds Time between two frames. */
+    void setInterval(int64_t nanoseconds);
+    int64_t getInterval() const { return _interval; }
+
+    /** Start the schedule from now, call before the first frame. */
+    void start();
+
+    /** Wait until the deadline of the next frame, and record the frame time. */
+    void waitForNextFrame();
+
+    /** Time left until the deadline of the next frame, in nanoseconds, negative when it is late. */
+    int64_t getTimeToNextFrame() const;
+
+    /** The next waitForNextFrame() returns at once and the schedule goes on from there, e.g. to draw
+     *  at once when a long interval is cut short. */
+    void restart();
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    int64_t getSpinMargin() const;
+
+    int64_t _interval;
+    int64_t _deadline;
+    int64_t _lastFrame;
+    double _sleepOvershoot;
+
+    float _frameTimes[HISTORY_SIZE];
+    int _frameTimeCount;
+    int _frameTimeIndex;
+    unsigned int _frameCount;
+    unsigned int _missedFrames;
+};
+
+NS_CC_END
+
+#endif // CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
+
+#endif // __CC_FRAME_PACER_LINUX_H__
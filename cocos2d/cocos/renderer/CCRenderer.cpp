@@ -638,13 +638,18 @@ void Renderer::render()
     
     if (_glViewAssigned)
     {
+        auto& frameStats = Director::getInstance()->getFrameStats();
         //Process render commands
         //1. Sort render commands based on ID
+        frameStats.begin(FrameStats::Section::SORT);
         for (auto &renderqueue : _renderGroups)
         {
             renderqueue.sort();
         }
+        frameStats.end();
+        frameStats.begin(FrameStats::Section::FLUSH);
         visitRenderQueue(_renderGroups[0]);
+        frameStats.end();
     }
     clean();
     _isRendering = false;
@@ -0,0 +1,237 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "BenchRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include "json/document.h"
+#include "json/prettywriter.h"
+#include "json/stringbuffer.h"
+
+// results files carry this version, a baseline of another version is refused
+#define BENCH_FORMAT_VERSION 1
+// a batch never grows past this many iterations, whatever minBatchSeconds asks
+#define MAX_BATCH_ITERATIONS (1LL << 32)
+
+static volatile float s_keptValue = 0.0f;
+
+BenchRunner::BenchRunner()
+: _repetitions(15)
+, _minBatchSeconds(0.02)
+{
+}
+
+bool BenchRunner::isSelected(const std::string& name) const
+{
+    return _filter.empty() || name.find(_filter) != std::string::npos;
+}
+
+double BenchRunner::timeBatch(const Body& body, long long iterations) const
+{
+    const auto start = std::chrono::steady_clock::now();
+    body(iterations);
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(end - start).count();
+}
+
+void BenchRunner::run(const std::string& name, const Body& body)
+{
+    if (!isSelected(name))
+    {
+        return;
+    }
+    _counters.clear();
+
+    // grow the batch until it is long enough for the clock, the first batches also warm the caches up
+    long long iterations = 1;
+    auto seconds = timeBatch(body, iterations);
+    while (seconds < _minBatchSeconds && iterations < MAX_BATCH_ITERATIONS)
+    {
+        const auto scale = seconds > 0.0 ? _minBatchSeconds / seconds * 1.2 : 10.0;
+        iterations = std::min(MAX_BATCH_ITERATIONS, std::max(iterations * 2, static_cast<long long>(iterations * std::min(scale, 10.0))));
+        seconds = timeBatch(body, iterations);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(_repetitions);
+    for (int i = 0; i < _repetitions; ++i)
+    {
+        samples.push_back(timeBatch(body, iterations) * 1e9 / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    BenchResult result;
+    result.name = name;
+    result.nsPerOp = samples[samples.size() / 2];
+    result.minNsPerOp = samples.front();
+    result.maxNsPerOp = samples.back();
+    result.iterations = iterations;
+    result.counters = _counters;
+    _results.push_back(result);
+
+    printf("%-44s %14.1f ns/op  min %12.1f  max %12.1f  x%lld", name.c_str(), result.nsPerOp, result.minNsPerOp,
+        result.maxNsPerOp, iterations);
+    for (const auto& counter : result.counters)
+    {
+        printf("  %s=%g", counter.first.c_str(), counter.second);
+    }
+    printf("\n");
+    fflush(stdout);
+}
+
+void BenchRunner::skip(const std::string& name, const std::string& reason)
+{
+    if (!isSelected(name))
+    {
+        return;
+    }
+    BenchResult result;
+    result.name = name;
+    result.nsPerOp = result.minNsPerOp = result.maxNsPerOp = 0.0;
+    result.iterations = 0;
+    result.skipped = reason;
+    _results.push_back(result);
+    printf("%-44s skipped: %s\n", name.c_str(), reason.c_str());
+}
+
+void BenchRunner::setCounter(const std::string& counter, double value)
+{
+    _counters[counter] = value;
+}
+
+bool BenchRunner::writeJSON(const std::string& path) const
+{
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    writer.StartObject();
+    writer.Key("version");
+    writer.Int(BENCH_FORMAT_VERSION);
+    writer.Key("benchmarks");
+    writer.StartArray();
+    for (const auto& result : _results)
+    {
+        writer.StartObject();
+        writer.Key("name");
+        writer.String(result.name.c_str());
+        if (!result.skipped.empty())
+        {
+            writer.Key("skipped");
+            writer.String(result.skipped.c_str());
+        }
+        else
+        {
+            writer.Key("ns_per_op");
+            writer.Double(result.nsPerOp);
+            writer.Key("min_ns_per_op");
+            writer.Double(result.minNsPerOp);
+            writer.Key("max_ns_per_op");
+            writer.Double(result.maxNsPerOp);
+            writer.Key("iterations");
+            writer.Int64(result.iterations);
+            writer.Key("counters");
+            writer.StartObject();
+            for (const auto& counter : result.counters)
+            {
+                writer.Key(counter.first.c_str());
+                writer.Double(counter.second);
+            }
+            writer.EndObject();
+        }
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
+
+    auto file = fopen(path.c_str(), "wb");
+    if (!file)
+    {
+        return false;
+    }
+    const auto written = fwrite(buffer.GetString(), 1, buffer.GetSize(), file) == buffer.GetSize();
+    return fclose(file) == 0 && written;
+}
+
+int BenchRunner::compareWithBaseline(const std::string& path, double tolerance) const
+{
+    auto file = fopen(path.c_str(), "rb");
+    if (!file)
+    {
+        printf("can not open the baseline %s\n", path.c_str());
+        return -1;
+    }
+    std::string text;
+    char chunk[4096];
+    size_t size = 0;
+    while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        text.append(chunk, size);
+    }
+    fclose(file);
+
+    rapidjson::Document baseline;
+    baseline.Parse<0>(text.c_str());
+    if (baseline.HasParseError() || !baseline.IsObject() || !baseline.HasMember("version")
+        || !baseline["version"].IsInt() || baseline["version"].GetInt() != BENCH_FORMAT_VERSION
+        || !baseline.HasMember("benchmarks") || !baseline["benchmarks"].IsArray())
+    {
+        printf("%s is not a cocos2d_bench results file of version %d\n", path.c_str(), BENCH_FORMAT_VERSION);
+        return -1;
+    }
+    std::map<std::string, double> expected;
+    const auto& benchmarks = baseline["benchmarks"];
+    for (rapidjson::SizeType i = 0; i < benchmarks.Size(); ++i)
+    {
+        const auto& entry = benchmarks[i];
+        if (entry.IsObject() && entry.HasMember("name") && entry["name"].IsString()
+            && entry.HasMember("ns_per_op") && entry["ns_per_op"].IsNumber())
+        {
+            expected[entry["name"].GetString()] = entry["ns_per_op"].GetDouble();
+        }
+    }
+
+    printf("\n%-44s %14s %14s %9s\n", "compared with baseline", "baseline", "now", "change");
+    auto regressions = 0;
+    for (const auto& result : _results)
+    {
+        const auto found = expected.find(result.name);
+        if (!result.skipped.empty() || found == expected.end() || found->second <= 0.0)
+        {
+            printf("%-44s %14s\n", result.name.c_str(), result.skipped.empty() ? "new" : "skipped");
+            continue;
+        }
+        const auto change = result.nsPerOp / found->second - 1.0;
+        const auto regressed = change > tolerance;
+        regressions += regressed ? 1 : 0;
+        printf("%-44s %14.1f %14.1f %+8.1f%%%s\n", result.name.c_str(), found->second, result.nsPerOp, change * 100.0,
+            regressed ? "  REGRESSION" : "");
+    }
+    printf("%d regression(s) over %.0f%%\n", regressions, tolerance * 100.0);
+    return regressions;
+}
+
+void BenchRunner::keep(float value)
+{
+    s_keptValue = value;
+}
@@ -0,0 +1,104 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __COCOS2D_BENCH_BENCHRUNNER_H__
+#define __COCOS2D_BENCH_BENCHRUNNER_H__
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Result of one benchmark, in nanoseconds per operation.
+ */
+struct BenchResult
+{
+    std::string name;
+    // median, fastest and slowest of the repetitions
+    double nsPerOp;
+    double minNsPerOp;
+    double maxNsPerOp;
+    long long iterations;
+    // what the benchmark measured besides time, draw calls for example
+    std::map<std::string, double> counters;
+    // why it did not run, empty when it ran
+    std::string skipped;
+};
+
+/**
+ * @brief Runs benchmarks the same way every time: a benchmark body runs a given number of iterations, the
+ * runner grows that number until a batch lasts minBatchSeconds, then times several batches and keeps their
+ * median, which a stray context switch does not move.
+ *
+ * The results are written as JSON; the same file read back is a baseline, compared by name.
+ */
+class BenchRunner
+{
+public:
+    typedef std::function<void(long long iterations)> Body;
+
+    BenchRunner();
+
+    void setFilter(const std::string& filter) { _filter = filter; }
+    void setRepetitions(int repetitions) { _repetitions = repetitions; }
+    void setMinBatchSeconds(double seconds) { _minBatchSeconds = seconds; }
+
+    /** Whether a benchmark passes the filter, to skip its setup as well. */
+    bool isSelected(const std::string& name) const;
+
+    /** Times body, when name passes the filter. */
+    void run(const std::string& name, const Body& body);
+
+    /** Records a benchmark that can not run here. */
+    void skip(const std::string& name, const std::string& reason);
+
+    /** Attaches a counter to the result of the benchmark being run, from its body. */
+    void setCounter(const std::string& counter, double value);
+
+    const std::vector<BenchResult>& getResults() const { return _results; }
+
+    bool writeJSON(const std::string& path) const;
+
+    /**
+     * Prints every result next to its baseline.
+     * @param tolerance 0.1 lets a benchmark be 10% slower than its baseline.
+     * @return Number of benchmarks slower than the tolerance, -1 when the baseline can not be read.
+     */
+    int compareWithBaseline(const std::string& path, double tolerance) const;
+
+    /** Keeps the optimizer from dropping a computation whose result is not used otherwise. */
+    static void keep(float value);
+
+private:
+    double timeBatch(const Body& body, long long iterations) const;
+
+    std::string _filter;
+    int _repetitions;
+    double _minBatchSeconds;
+    std::vector<BenchResult> _results;
+    std::map<std::string, double> _counters;
+};
+
+#endif // __COCOS2D_BENCH_BENCHRUNNER_H__
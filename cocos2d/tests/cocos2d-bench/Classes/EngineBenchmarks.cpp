@@ -0,0 +1,431 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "EngineBenchmarks.h"
+#include "cocos2d.h"
+
+USING_NS_CC;
+
+// the scene graph is a root, BENCH_NODE_FANOUT children and BENCH_NODE_FANOUT grandchildren for each
+#define BENCH_NODE_FANOUT 100
+#define BENCH_SCHEDULER_TARGETS 10000
+// a tenth of the scheduler targets also have an interval timer
+#define BENCH_TIMER_EVERY 10
+#define BENCH_CHURN_TIMERS 1000
+#define BENCH_LISTENERS 1000
+#define BENCH_SPRITES 2000
+#define BENCH_IMAGE_SIZE 512
+#define BENCH_FILE_SIZE (1024 * 1024)
+
+namespace
+{
+    struct UpdateTarget
+    {
+        float elapsed;
+
+        UpdateTarget() : elapsed(0.0f) {}
+        void update(float dt) { elapsed += dt; }
+    };
+
+    // a gradient with some noise, between a flat image and a random one for the codecs
+    Image* createTestImage(int size)
+    {
+        std::vector<unsigned char> pixels(size * size * 4);
+        unsigned int seed = 1;
+        for (int y = 0; y < size; ++y)
+        {
+            for (int x = 0; x < size; ++x)
+            {
+                seed = seed * 1103515245 + 12345;
+                const auto noise = static_cast<int>((seed >> 16) & 31);
+                auto pixel = &pixels[(y * size + x) * 4];
+                pixel[0] = static_cast<unsigned char>(std::min(255, x * 224 / size + noise));
+                pixel[1] = static_cast<unsigned char>(std::min(255, y * 224 / size + noise));
+                pixel[2] = static_cast<unsigned char>(std::min(255, (x + y) * 112 / size + noise));
+                pixel[3] = 255;
+            }
+        }
+        auto image = new (std::nothrow) Image();
+        if (image && !image->initWithRawData(pixels.data(), pixels.size(), size, size, 8))
+        {
+            CC_SAFE_RELEASE_NULL(image);
+        }
+        return image;
+    }
+}
+
+void benchMath(BenchRunner& runner)
+{
+    Mat4 rotation;
+    Mat4::createRotationZ(0.001f, &rotation);
+
+    runner.run("mat4/multiply", [rotation](long long iterations)
+    {
+        auto result = Mat4::IDENTITY;
+        for (long long i = 0; i < iterations; ++i)
+        {
+            Mat4::multiply(result, rotation, &result);
+        }
+        BenchRunner::keep(result.m[0]);
+    });
+
+    std::vector<Vec3> points(1024);
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        points[i].set(static_cast<float>(i), static_cast<float>(i % 32), 1.0f);
+    }
+    runner.run("mat4/transform_point_1k", [rotation, &points](long long iterations)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            for (auto& point : points)
+            {
+                rotation.transformPoint(&point);
+            }
+        }
+        BenchRunner::keep(points[0].x);
+    });
+
+    runner.run("mat4/inverse", [rotation](long long iterations)
+    {
+        auto matrix = rotation;
+        matrix.translate(10.0f, 20.0f, 0.0f);
+        for (long long i = 0; i < iterations; ++i)
+        {
+            matrix = matrix.getInversed();
+        }
+        BenchRunner::keep(matrix.m[12]);
+    });
+}
+
+void benchScheduler(BenchRunner& runner)
+{
+    auto scheduler = new (std::nothrow) Scheduler();
+    std::vector<UpdateTarget> targets(BENCH_SCHEDULER_TARGETS);
+
+    const std::string updateName = "scheduler/update_10k_targets";
+    if (runner.isSelected(updateName))
+    {
+        for (int i = 0; i < BENCH_SCHEDULER_TARGETS; ++i)
+        {
+            // spread over the negative, zero and positive priority lists
+            auto target = &targets[i];
+            scheduler->scheduleUpdate(target, i % 3 - 1, false);
+            if (i % BENCH_TIMER_EVERY == 0)
+            {
+                scheduler->schedule([target](float dt) { target->elapsed += dt; }, target, 0.1f, false, "timer");
+            }
+        }
+        runner.run(updateName, [scheduler](long long iterations)
+        {
+            for (long long i = 0; i < iterations; ++i)
+            {
+                scheduler->update(1.0f / 60.0f);
+            }
+        });
+        scheduler->unscheduleAll();
+    }
+
+    runner.run("scheduler/schedule_unschedule_1k_timers", [scheduler, &targets](long long iterations)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            for (int t = 0; t < BENCH_CHURN_TIMERS; ++t)
+            {
+                auto target = &targets[t];
+                scheduler->schedule([target](float dt) { target->elapsed += dt; }, target, 0.5f, false, "churn");
+            }
+            for (int t = 0; t < BENCH_CHURN_TIMERS; ++t)
+            {
+                scheduler->unschedule("churn", &targets[t]);
+            }
+        }
+    });
+    scheduler->release();
+}
+
+void benchEventDispatcher(BenchRunner& runner)
+{
+    auto dispatcher = new (std::nothrow) EventDispatcher();
+    dispatcher->setEnabled(true);
+    long long received = 0;
+    for (int i = 0; i < BENCH_LISTENERS; ++i)
+    {
+        auto listener = EventListenerCustom::create("bench", [&received](EventCustom*) { ++received; });
+        dispatcher->addEventListenerWithFixedPriority(listener, i + 1);
+    }
+
+    EventCustom event("bench");
+    runner.run("event_dispatcher/dispatch_1k_listeners", [dispatcher, &event](long long iterations)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            dispatcher->dispatchEvent(&event);
+        }
+    });
+
+    EventCustom unheard("nobody");
+    runner.run("event_dispatcher/dispatch_no_listener", [dispatcher, &unheard](long long iterations)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            dispatcher->dispatchEvent(&unheard);
+        }
+    });
+
+    BenchRunner::keep(static_cast<float>(received));
+    dispatcher->removeAllEventListeners();
+    dispatcher->release();
+}
+
+void benchSceneGraph(BenchRunner& runner)
+{
+    auto renderer = Director::getInstance()->getRenderer();
+    auto root = Node::create();
+    root->retain();
+    for (int i = 0; i < BENCH_NODE_FANOUT; ++i)
+    {
+        auto child = Node::create();
+        child->setPosition(Vec2(static_cast<float>(i), 0.0f));
+        for (int j = 0; j < BENCH_NODE_FANOUT; ++j)
+        {
+            auto grandchild = Node::create();
+            grandchild->setPosition(Vec2(0.0f, static_cast<float>(j)));
+            child->addChild(grandchild);
+        }
+        root->addChild(child);
+    }
+
+    runner.run("node/visit_10k", [root, renderer](long long iterations)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            root->visit(renderer, Mat4::IDENTITY, 0);
+        }
+    });
+
+    // moving the root makes every node below it recompute its transform
+    runner.run("node/visit_10k_dirty_transform", [root, renderer](long long iterations)
+    {
+        for (long long i = 0; i < iterations; ++i)
+        {
+            root->setPositionX((i & 1) ? 1.0f : 0.0f);
+            root->visit(renderer, Mat4::IDENTITY, 0);
+        }
+    });
+
+    root->release();
+}
+
+void benchRenderer(BenchRunner& runner, bool hasGL)
+{
+    const std::string names[] = { "renderer/render_2k_sprites_1_texture", "renderer/render_2k_sprites_2_textures" };
+    if (!hasGL)
+    {
+        for (const auto& name : names)
+        {
+            runner.skip(name, "no OpenGL context");
+        }
+        return;
+    }
+
+    auto director = Director::getInstance();
+    auto renderer = director->getRenderer();
+    const auto size = director->getWinSize();
+    auto image = createTestImage(64);
+    Texture2D* textures[2] = { new (std::nothrow) Texture2D(), new (std::nothrow) Texture2D() };
+    textures[0]->initWithImage(image);
+    textures[1]->initWithImage(image);
+    CC_SAFE_RELEASE(image);
+
+    for (int textureCount = 1; textureCount <= 2; ++textureCount)
+    {
+        const auto& name = names[textureCount - 1];
+        if (!runner.isSelected(name))
+        {
+            continue;
+        }
+        // alternating textures break every batch, one texture batches the whole scene
+        auto scene = Scene::create();
+        scene->retain();
+        for (int i = 0; i < BENCH_SPRITES; ++i)
+        {
+            auto sprite = Sprite::createWithTexture(textures[i % textureCount]);
+            sprite->setPosition(Vec2(size.width * ((i * 37) % 101) / 100.0f, size.height * ((i * 53) % 103) / 102.0f));
+            scene->addChild(sprite);
+        }
+        runner.run(name, [&runner, scene, renderer](long long iterations)
+        {
+            for (long long i = 0; i < iterations; ++i)
+            {
+                renderer->clearDrawStats();
+                scene->render(renderer, Mat4::IDENTITY, nullptr);
+                // the GPU work of a frame is part of it, do not let it pile up into the next batches
+                glFinish();
+            }
+            runner.setCounter("draw_calls", static_cast<double>(renderer->getDrawnBatches()));
+        });
+        scene->release();
+    }
+
+    textures[0]->release();
+    textures[1]->release();
+}
+
+void benchLabel(BenchRunner& runner, bool hasGL, const std::string& fontPath)
+{
+    const std::string names[] = { "label/layout_ttf_line", "label/layout_ttf_wrapped_paragraph" };
+    std::string reason;
+    if (!hasGL)
+    {
+        reason = "no OpenGL context";
+    }
+    else if (fontPath.empty() || !FileUtils::getInstance()->isFileExist(fontPath))
+    {
+        reason = "no font, see --font";
+    }
+    if (!reason.empty())
+    {
+        for (const auto& name : names)
+        {
+            runner.skip(name, reason);
+        }
+        return;
+    }
+
+    // both texts of a benchmark have the same glyphs, so the atlas is filled by the first layout
+    const std::string lines[] = { "The quick brown fox jumps over the lazy dog",
+        "the lazy dog jumps over The quick brown fox" };
+    const std::string paragraphs[] = { lines[0] + " " + lines[1] + " " + lines[0] + " " + lines[1],
+        lines[1] + " " + lines[0] + " " + lines[1] + " " + lines[0] };
+
+    for (int wrapped = 0; wrapped <= 1; ++wrapped)
+    {
+        if (!runner.isSelected(names[wrapped]))
+        {
+            continue;
+        }
+        const auto texts = wrapped ? paragraphs : lines;
+        auto label = Label::createWithTTF(TTFConfig(fontPath, 24), texts[0]);
+        if (!label)
+        {
+            runner.skip(names[wrapped], "can not load " + fontPath);
+            continue;
+        }
+        label->retain();
+        if (wrapped)
+        {
+            label->setDimensions(200.0f, 0.0f);
+        }
+        runner.run(names[wrapped], [label, texts](long long iterations)
+        {
+            for (long long i = 0; i < iterations; ++i)
+            {
+                label->setString(texts[i & 1]);
+                label->updateContent();
+            }
+            BenchRunner::keep(label->getContentSize().height);
+        });
+        label->release();
+    }
+}
+
+void benchFiles(BenchRunner& runner)
+{
+    auto fileUtils = FileUtils::getInstance();
+    const auto directory = fileUtils->getWritablePath();
+    const auto blobPath = directory + "cocos2d_bench.bin";
+    const auto pngPath = directory + "cocos2d_bench.png";
+    const auto jpgPath = directory + "cocos2d_bench.jpg";
+
+    std::vector<unsigned char> bytes(BENCH_FILE_SIZE);
+    for (size_t i = 0; i < bytes.size(); ++i)
+    {
+        bytes[i] = static_cast<unsigned char>(i * 7);
+    }
+    Data blob;
+    blob.copy(bytes.data(), bytes.size());
+    if (fileUtils->writeDataToFile(blob, blobPath))
+    {
+        runner.run("file_utils/get_data_from_file_1mb", [fileUtils, blobPath](long long iterations)
+        {
+            for (long long i = 0; i < iterations; ++i)
+            {
+                BenchRunner::keep(static_cast<float>(fileUtils->getDataFromFile(blobPath).getSize()));
+            }
+        });
+
+        // the buffer keeps its capacity from one read to the next
+        runner.run("file_utils/get_contents_1mb_reused_buffer", [fileUtils, blobPath](long long iterations)
+        {
+            std::string buffer;
+            for (long long i = 0; i < iterations; ++i)
+            {
+                fileUtils->getContents(blobPath, &buffer);
+            }
+            BenchRunner::keep(static_cast<float>(buffer.size()));
+        });
+
+        fileUtils->addSearchPath(directory);
+        runner.run("file_utils/full_path_for_filename", [fileUtils](long long iterations)
+        {
+            for (long long i = 0; i < iterations; ++i)
+            {
+                BenchRunner::keep(static_cast<float>(fileUtils->fullPathForFilename("cocos2d_bench.bin").size()));
+            }
+        });
+        fileUtils->removeFile(blobPath);
+    }
+    else
+    {
+        runner.skip("file_utils/get_data_from_file_1mb", "can not write " + blobPath);
+        runner.skip("file_utils/get_contents_1mb_reused_buffer", "can not write " + blobPath);
+        runner.skip("file_utils/full_path_for_filename", "can not write " + blobPath);
+    }
+
+    auto image = createTestImage(BENCH_IMAGE_SIZE);
+    const std::string paths[] = { pngPath, jpgPath };
+    const std::string names[] = { "image/decode_png_512", "image/decode_jpg_512" };
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!image || !image->saveToFile(paths[i], i == 1))
+        {
+            runner.skip(names[i], "can not write " + paths[i]);
+            continue;
+        }
+        const auto encoded = fileUtils->getDataFromFile(paths[i]);
+        runner.run(names[i], [&encoded](long long iterations)
+        {
+            for (long long i = 0; i < iterations; ++i)
+            {
+                auto decoded = new (std::nothrow) Image();
+                decoded->initWithImageData(encoded.getBytes(), encoded.getSize());
+                BenchRunner::keep(static_cast<float>(decoded->getWidth()));
+                decoded->release();
+            }
+        });
+        fileUtils->removeFile(paths[i]);
+    }
+    CC_SAFE_RELEASE(image);
+}
@@ -0,0 +1,52 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __COCOS2D_BENCH_ENGINEBENCHMARKS_H__
+#define __COCOS2D_BENCH_ENGINEBENCHMARKS_H__
+
+#include <string>
+#include "BenchRunner.h"
+
+/** Mat4 products, point transforms and inverses. */
+void benchMath(BenchRunner& runner);
+
+/** Scheduler::update over 10000 targets of mixed priorities, and timers scheduled and unscheduled. */
+void benchScheduler(BenchRunner& runner);
+
+/** EventDispatcher::dispatchEvent to 1000 fixed priority listeners, and to none. */
+void benchEventDispatcher(BenchRunner& runner);
+
+/** Node::visit of a 10000 node tree, with and without a transform to update. */
+void benchSceneGraph(BenchRunner& runner);
+
+/** Renderer::render of 2000 sprites that batch into one draw call, and that do not. Needs a GL context. */
+void benchRenderer(BenchRunner& runner, bool hasGL);
+
+/** Label layout of a line and of a wrapped paragraph. Needs a GL context for the font atlas. */
+void benchLabel(BenchRunner& runner, bool hasGL, const std::string& fontPath);
+
+/** FileUtils reads and Image decodes, of files written in the writable path first. */
+void benchFiles(BenchRunner& runner);
+
+#endif // __COCOS2D_BENCH_ENGINEBENCHMARKS_H__
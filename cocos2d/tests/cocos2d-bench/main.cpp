@@ -0,0 +1,128 @@
+/****************************************************************************
+Copyright (c) 2013-2017 Chukong Technologies Inc.
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "cocos2d.h"
+#include "Classes/BenchRunner.h"
+#include "Classes/EngineBenchmarks.h"
+
+USING_NS_CC;
+
+// usage: cocos2d_bench [--filter TEXT] [--json RESULTS.json] [--baseline BASELINE.json] [--tolerance 0.1]
+//                      [--repetitions 15] [--min-time SECONDS] [--font FONT.ttf] [--no-gl]
+// Runs the engine benchmarks whose name contains TEXT, writes their results as JSON, and compares them with a
+// results file of an earlier run. Exits with 1 when a benchmark got slower than the tolerance, 2 on bad usage.
+int main(int argc, char** argv)
+{
+    BenchRunner runner;
+    std::string jsonPath;
+    std::string baselinePath;
+    std::string fontPath;
+    auto tolerance = 0.1;
+    auto useGL = true;
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && hasValue)
+        {
+            runner.setFilter(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--json") == 0 && hasValue)
+        {
+            jsonPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--baseline") == 0 && hasValue)
+        {
+            baselinePath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--tolerance") == 0 && hasValue)
+        {
+            tolerance = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--repetitions") == 0 && hasValue)
+        {
+            runner.setRepetitions(std::max(1, atoi(argv[++i])));
+        }
+        else if (strcmp(argv[i], "--min-time") == 0 && hasValue)
+        {
+            runner.setMinBatchSeconds(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--font") == 0 && hasValue)
+        {
+            fontPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--no-gl") == 0)
+        {
+            useGL = false;
+        }
+        else
+        {
+            fprintf(stderr, "unknown or incomplete option %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    // the renderer and label benchmarks need a context, the others run without one
+    auto director = Director::getInstance();
+    auto hasGL = false;
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+    if (useGL)
+    {
+        auto glview = GLViewImpl::createWithRect("cocos2d_bench", Rect(0, 0, 960, 640));
+        if (glview)
+        {
+            director->setOpenGLView(glview);
+            hasGL = true;
+        }
+    }
+#endif
+    printf("cocos2d_bench %s, %s\n", cocos2dVersion(), hasGL ? "with OpenGL" : "without OpenGL");
+
+    benchMath(runner);
+    benchScheduler(runner);
+    benchEventDispatcher(runner);
+    benchSceneGraph(runner);
+    benchRenderer(runner, hasGL);
+    benchLabel(runner, hasGL, fontPath);
+    benchFiles(runner);
+    PoolManager::getInstance()->getCurrentPool()->clear();
+
+    if (!jsonPath.empty() && !runner.writeJSON(jsonPath))
+    {
+        fprintf(stderr, "can not write %s\n", jsonPath.c_str());
+        return 2;
+    }
+    if (!baselinePath.empty())
+    {
+        const auto regressions = runner.compareWithBaseline(baselinePath, tolerance);
+        if (regressions < 0)
+        {
+            return 2;
+        }
+        return regressions > 0 ? 1 : 0;
+    }
+    return 0;
+}
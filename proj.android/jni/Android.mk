@@ -13,8 +13,23 @@ LOCAL_MODULE_FILENAME := libMyGame
 
 LOCAL_SRC_FILES := hellocpp/main.cpp \
                    ../../Classes/AppDelegate.cpp \
+                   ../../Classes/AssetLoader.cpp \
+                   ../../Classes/AirHockeySim.cpp \
+                   ../../Classes/CpuPlayer.cpp \
+                   ../../Classes/EffectMixer.cpp \
+                   ../../Classes/EffectPlayer.cpp \
+                   ../../Classes/EventTrace.cpp \
                    ../../Classes/GameLayer.cpp \
-                   ../../Classes/GameSprite.cpp
+                   ../../Classes/GameSprite.cpp \
+                   ../../Classes/LatencyHistogram.cpp \
+                   ../../Classes/LoadingLayer.cpp \
+                   ../../Classes/PartyLayer.cpp \
+                   ../../Classes/PartySim.cpp \
+                   ../../Classes/Replay.cpp \
+                   ../../Classes/RollbackSession.cpp \
+                   ../../Classes/TextureBundle.cpp \
+                   ../../Classes/TouchPredictor.cpp \
+                   ../../Classes/UdpTransport.cpp
 
 LOCAL_C_INCLUDES := $(LOCAL_PATH)/../../Classes
 
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * \brief Run task(index, worker) for every index in [0, taskCount) on threadCount threads, then return.
+ *
+ * Indexes are dealt round-robin to one deque per worker. A worker takes its own tasks from the
+ * back and, once out of work, steals from the front of the other deques, so uneven tasks
+ * (long and short matches) still keep every core busy.
+ */
+inline void workStealingFor(int threadCount, int taskCount, const std::function<void(int, int)>& task)
+{
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+    std::vector<WorkQueue> queues(threadCount);
+    for (auto i = 0; i < taskCount; ++i)
+    {
+        queues[i % threadCount].tasks.push_back(i);
+    }
+
+    const auto worker = [&queues, &task, threadCount](int self)
+    {
+        for (;;)
+        {
+            auto index = -1;
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                if (!queues[self].tasks.empty())
+                {
+                    index = queues[self].tasks.back();
+                    queues[self].tasks.pop_back();
+                }
+            }
+            for (auto victim = (self + 1) % threadCount; index < 0 && victim != self; victim = (victim + 1) % threadCount)
+            {
+                std::lock_guard<std::mutex> lock(queues[victim].mutex);
+                if (!queues[victim].tasks.empty())
+                {
+                    index = queues[victim].tasks.front();
+                    queues[victim].tasks.pop_front();
+                }
+            }
+            // no task is ever added, so empty queues everywhere means we are done
+            if (index < 0)
+            {
+                return;
+            }
+            task(index, self);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (auto i = 1; i < threadCount; ++i)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
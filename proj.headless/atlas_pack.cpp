@@ -0,0 +1,198 @@
+#include <png.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Packs sprites into one texture and writes the SpriteFrameCache plist (format 2) next to it, so the
+// sprites of the table share a texture and the renderer batches them.
+// usage: MyGame_atlaspack <out stem> <sprite.png>... writes <out stem>.png and <out stem>.plist
+// The frames are named after the sprite files, they are not trimmed nor rotated, so a sprite created from
+// its frame has the size it had from its file. Each sprite is surrounded by copies of its edge pixels,
+// scaled sprites do not sample their neighbours. The texture clamps to its edges, the border of a sprite
+// on an edge of the atlas is left out.
+
+// edge pixels copied around each sprite
+#define BORDER 2
+#define MAX_ATLAS_SIZE 4096
+
+struct Sprite
+{
+    std::string name;
+    png_image image;
+    std::vector<png_byte> pixels;
+    int x;
+    int y;
+};
+
+static int nextPowerOfTwo(int value)
+{
+    auto power = 1;
+    while (power < value)
+    {
+        power *= 2;
+    }
+    return power;
+}
+
+// shelves of the tallest sprites first, returns the height used or -1 if a sprite is wider than the atlas
+static int pack(std::vector<Sprite*>& sprites, int width)
+{
+    // the borders out of the atlas cost nothing
+    width += BORDER * 2;
+    auto x = 0;
+    auto y = 0;
+    auto shelfHeight = 0;
+    for (auto sprite : sprites)
+    {
+        const int w = sprite->image.width + BORDER * 2;
+        const int h = sprite->image.height + BORDER * 2;
+        if (w > width)
+        {
+            return -1;
+        }
+        if (x + w > width)
+        {
+            y += shelfHeight;
+            x = 0;
+            shelfHeight = 0;
+        }
+        sprite->x = x;
+        sprite->y = y;
+        x += w;
+        shelfHeight = std::max(shelfHeight, h);
+    }
+    return y + shelfHeight - BORDER * 2;
+}
+
+static bool writePlist(const std::string& path, const std::string& textureName, const std::vector<Sprite>& sprites, int width, int height)
+{
+    auto out = fopen(path.c_str(), "w");
+    if (!out)
+    {
+        return false;
+    }
+    fprintf(out, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    fprintf(out, "<!DOCTYPE plist PUBLIC \"-//Apple//DTD PLIST 1.0//EN\" \"http://www.apple.com/DTDs/PropertyList-1.0.dtd\">\n");
+    fprintf(out, "<plist version=\"1.0\">\n<dict>\n    <key>frames</key>\n    <dict>\n");
+    for (const auto& sprite : sprites)
+    {
+        const auto w = sprite.image.width;
+        const auto h = sprite.image.height;
+        fprintf(out, "        <key>%s</key>\n        <dict>\n", sprite.name.c_str());
+        fprintf(out, "            <key>frame</key>\n            <string>{{%d,%d},{%u,%u}}</string>\n", sprite.x, sprite.y, w, h);
+        fprintf(out, "            <key>offset</key>\n            <string>{0,0}</string>\n");
+        fprintf(out, "            <key>rotated</key>\n            <false/>\n");
+        fprintf(out, "            <key>sourceColorRect</key>\n            <string>{{0,0},{%u,%u}}</string>\n", w, h);
+        fprintf(out, "            <key>sourceSize</key>\n            <string>{%u,%u}</string>\n", w, h);
+        fprintf(out, "        </dict>\n");
+    }
+    fprintf(out, "    </dict>\n    <key>metadata</key>\n    <dict>\n");
+    fprintf(out, "        <key>format</key>\n        <integer>2</integer>\n");
+    fprintf(out, "        <key>realTextureFileName</key>\n        <string>%s</string>\n", textureName.c_str());
+    fprintf(out, "        <key>size</key>\n        <string>{%d,%d}</string>\n", width, height);
+    fprintf(out, "        <key>textureFileName</key>\n        <string>%s</string>\n", textureName.c_str());
+    fprintf(out, "    </dict>\n</dict>\n</plist>\n");
+    return fclose(out) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <out stem> <sprite.png>...\n", argv[0]);
+        return 1;
+    }
+    std::vector<Sprite> sprites(argc - 2);
+    for (auto i = 0; i < argc - 2; ++i)
+    {
+        auto& sprite = sprites[i];
+        const std::string path = argv[i + 2];
+        sprite.name = path.substr(path.find_last_of("/\\") + 1);
+        sprite.image = png_image();
+        sprite.image.version = PNG_IMAGE_VERSION;
+        if (!png_image_begin_read_from_file(&sprite.image, path.c_str()))
+        {
+            fprintf(stderr, "can not read %s: %s\n", path.c_str(), sprite.image.message);
+            return 1;
+        }
+        sprite.image.format = PNG_FORMAT_RGBA;
+        sprite.pixels.resize(PNG_IMAGE_SIZE(sprite.image));
+        if (!png_image_finish_read(&sprite.image, nullptr, sprite.pixels.data(), 0, nullptr))
+        {
+            fprintf(stderr, "can not decode %s: %s\n", path.c_str(), sprite.image.message);
+            return 1;
+        }
+    }
+
+    // the power of two atlas of the smallest area, the squarest one of the same area
+    std::vector<Sprite*> order;
+    for (auto& sprite : sprites)
+    {
+        order.push_back(&sprite);
+    }
+    std::stable_sort(order.begin(), order.end(), [](const Sprite* a, const Sprite* b) {
+        return a->image.height > b->image.height;
+    });
+    auto width = 0;
+    auto height = 0;
+    for (auto w = 64; w <= MAX_ATLAS_SIZE; w *= 2)
+    {
+        const auto used = pack(order, w);
+        if (used < 0 || used > MAX_ATLAS_SIZE)
+        {
+            continue;
+        }
+        const auto h = nextPowerOfTwo(used);
+        if (width == 0 || w * h < width * height || (w * h == width * height && std::max(w, h) < std::max(width, height)))
+        {
+            width = w;
+            height = h;
+        }
+    }
+    if (width == 0)
+    {
+        fprintf(stderr, "the sprites do not fit in %dx%d\n", MAX_ATLAS_SIZE, MAX_ATLAS_SIZE);
+        return 1;
+    }
+    pack(order, width);
+
+    std::vector<png_byte> atlas(static_cast<size_t>(width) * height * 4, 0);
+    for (const auto& sprite : sprites)
+    {
+        const int w = sprite.image.width;
+        const int h = sprite.image.height;
+        for (auto y = std::max(-BORDER, -sprite.y); y < std::min(h + BORDER, height - sprite.y); ++y)
+        {
+            const auto sy = std::min(std::max(y, 0), h - 1);
+            for (auto x = std::max(-BORDER, -sprite.x); x < std::min(w + BORDER, width - sprite.x); ++x)
+            {
+                const auto sx = std::min(std::max(x, 0), w - 1);
+                const auto src = &sprite.pixels[(static_cast<size_t>(sy) * w + sx) * 4];
+                const auto dst = &atlas[(static_cast<size_t>(sprite.y + y) * width + sprite.x + x) * 4];
+                std::copy(src, src + 4, dst);
+            }
+        }
+    }
+
+    const std::string stem = argv[1];
+    const auto textureName = stem.substr(stem.find_last_of("/\\") + 1) + ".png";
+    png_image out = png_image();
+    out.version = PNG_IMAGE_VERSION;
+    out.width = width;
+    out.height = height;
+    out.format = PNG_FORMAT_RGBA;
+    if (!png_image_write_to_file(&out, (stem + ".png").c_str(), 0, atlas.data(), 0, nullptr))
+    {
+        fprintf(stderr, "can not write %s.png: %s\n", stem.c_str(), out.message);
+        return 1;
+    }
+    if (!writePlist(stem + ".plist", textureName, sprites, width, height))
+    {
+        fprintf(stderr, "can not write %s.plist\n", stem.c_str());
+        return 1;
+    }
+    fprintf(stderr, "%d sprites in %dx%d\n", static_cast<int>(sprites.size()), width, height);
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include "../Classes/CpuPlayer.h"
+#include "../Classes/RollbackSession.h"
+#include "../Classes/UdpTransport.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+// Checks that a correction reports the goals it adds or removes, then plays a CPU vs CPU match between two
+// rollback sessions over UDP on loopback, through the bad network simulator, and checks both devices end with
+// the same match.
+// usage: MyGame_netplay [seconds=10] [latency ms=60] [jitter ms=20] [loss=0.05]
+// Exits with 1 when a correction is not reported, the devices disagree or a frame with corrections is over 16 ms.
+namespace
+{
+    const int FRAMES_PER_SECOND = 60;
+    const int TICKS_PER_FRAME = AirHockeySim::TICKS_PER_SECOND / FRAMES_PER_SECOND;
+    const double FRAME_BUDGET_MS = 16.0;
+
+    struct Peer
+    {
+        RollbackSession session;
+        UdpTransport transport;
+        CpuPlayer cpu;
+        double maxFrameMs;
+        int maxRollbackTicks;
+        int stalledFrames;
+    };
+
+    void receive(Peer& peer)
+    {
+        unsigned char packet[RollbackSession::MAX_PACKET_SIZE];
+        size_t size = 0;
+        while ((size = peer.transport.receive(packet, sizeof(packet))) > 0)
+        {
+            peer.session.readPacket(packet, size);
+        }
+    }
+
+    void send(Peer& peer)
+    {
+        unsigned char packet[RollbackSession::MAX_PACKET_SIZE];
+        peer.transport.send(packet, peer.session.writePacket(packet));
+    }
+
+    /**
+     * \brief Shoot the puck at the goal of player 2, predict that its mallet does not move, then deliver its move and release
+     * \return Events of the tick that received the move, -1 if the scores were not corrected
+     */
+    int correctShot(const AirHockeySim& start, float puckX, float malletX)
+    {
+        auto shot = start;
+        shot.puck.x = shot.puck.nextX = puckX;
+        shot.puck.y = shot.puck.nextY = shot.height * 0.85f;
+        shot.puck.vy = 1500.0f;
+
+        RollbackSession local;
+        RollbackSession remote;
+        local.init(shot, 0);
+        remote.init(shot, 1);
+        // long enough for the puck to reach the goal, short enough to be corrected
+        for (auto i = 0; i < RollbackSession::MAX_ROLLBACK_TICKS / 2; ++i)
+        {
+            local.advance(NetInput());
+        }
+        NetInput move = NetInput();
+        move.type = NetInput::MOVE;
+        move.x = malletX;
+        move.y = shot.height - shot.mallets[1].radius;
+        remote.advance(move);
+        // the touch stops there, the mallet does not keep the speed of its jump
+        NetInput release = NetInput();
+        release.type = NetInput::RELEASE;
+        remote.advance(release);
+
+        unsigned char packet[RollbackSession::MAX_PACKET_SIZE];
+        local.readPacket(packet, remote.writePacket(packet));
+        const auto events = local.advance(NetInput());
+        return local.areScoresCorrected() ? events : -1;
+    }
+
+    void frame(Peer& peer, unsigned int lastTick)
+    {
+        receive(peer);
+        const auto start = std::chrono::steady_clock::now();
+        if (!peer.session.canAdvance())
+        {
+            ++peer.stalledFrames;
+        }
+        for (auto i = 0; i < TICKS_PER_FRAME && peer.session.canAdvance() && peer.session.getState().tick < lastTick; ++i)
+        {
+            // like GameLayer, the input of a frame goes to its first tick
+            NetInput input = NetInput();
+            if (i == 0)
+            {
+                input.type = NetInput::MOVE;
+                peer.cpu.think(peer.session.getState(), 1.0f / FRAMES_PER_SECOND, input.x, input.y);
+            }
+            peer.session.advance(input);
+            if (peer.session.getLastRollbackTicks() > peer.maxRollbackTicks)
+            {
+                peer.maxRollbackTicks = peer.session.getLastRollbackTicks();
+            }
+        }
+        const auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (ms > peer.maxFrameMs)
+        {
+            peer.maxFrameMs = ms;
+        }
+        send(peer);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const auto seconds = argc > 1 ? std::atoi(argv[1]) : 10;
+    const auto latencyMs = argc > 2 ? static_cast<float>(std::atof(argv[2])) : 60.0f;
+    const auto jitterMs = argc > 3 ? static_cast<float>(std::atof(argv[3])) : 20.0f;
+    const auto lossRate = argc > 4 ? static_cast<float>(std::atof(argv[4])) : 0.05f;
+    const auto lastTick = static_cast<unsigned int>(seconds * AirHockeySim::TICKS_PER_SECOND);
+
+    AirHockeySim start;
+    start.init(640, 960, 40, 12);
+
+    // snapshot and restore are a copy of the struct, time a snapshot, a restore and a step together
+    const auto copies = 100000;
+    static AirHockeySim ring[RollbackSession::MAX_ROLLBACK_TICKS];
+    auto sim = start;
+    const auto copyStart = std::chrono::steady_clock::now();
+    for (auto i = 0; i < copies; ++i)
+    {
+        ring[i % RollbackSession::MAX_ROLLBACK_TICKS] = sim;
+        sim = ring[(i * 7) % RollbackSession::MAX_ROLLBACK_TICKS];
+        sim.step();
+    }
+    const auto copyUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - copyStart).count() / copies;
+
+    // the mallet of player 2 blocks a predicted goal, then leaves a predicted block
+    const auto blocked = correctShot(start, start.width * 0.35f, start.width * 0.35f);
+    const auto scored = correctShot(start, start.width * 0.5f, start.width * 0.85f);
+    const auto corrected = blocked >= 0 && (blocked & SIM_EVENT_GOAL) == 0 && scored >= 0 && (scored & SIM_EVENT_GOAL_PLAYER1) != 0;
+    printf("predicted_goal_blocked=%d predicted_block_scored=%d\n", blocked >= 0 ? 1 : 0, scored >= 0 ? 1 : 0);
+
+    static Peer peers[AirHockeySim::PLAYER_COUNT];
+    for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+    {
+        peers[i].session.init(start, i);
+        peers[i].cpu.init(i, 100, 1500.0f);
+        peers[i].maxFrameMs = 0.0;
+        peers[i].maxRollbackTicks = 0;
+        peers[i].stalledFrames = 0;
+        if (!peers[i].transport.open(0))
+        {
+            fprintf(stderr, "can not open a UDP socket\n");
+            return 1;
+        }
+        peers[i].transport.simulate(latencyMs, jitterMs, lossRate, 42 + i);
+    }
+    peers[0].transport.setRemote("127.0.0.1", peers[1].transport.getLocalPort());
+    peers[1].transport.setRemote("127.0.0.1", peers[0].transport.getLocalPort());
+
+    // play in real time, the simulated latency runs on the clock
+    const auto frameTime = std::chrono::microseconds(1000000 / FRAMES_PER_SECOND);
+    auto nextFrame = std::chrono::steady_clock::now();
+    auto frames = 0;
+    for (;;)
+    {
+        auto done = true;
+        for (auto i = 0; i < AirHockeySim::PLAYER_COUNT; ++i)
+        {
+            frame(peers[i], lastTick);
+            const auto& session = peers[i].session;
+            done = done && session.getState().tick == lastTick && session.getConfirmedTick() == lastTick;
+        }
+        ++frames;
+        if (done || frames > (seconds + 10) * FRAMES_PER_SECOND)
+        {
+            break;
+        }
+        nextFrame += frameTime;
+        std::this_thread::sleep_until(nextFrame);
+    }
+
+    for (auto& peer : peers)
+    {
+        peer.session.synchronize();
+    }
+    const auto& a = peers[0].session.getState();
+    const auto& b = peers[1].session.getState();
+    const auto same = a.tick == lastTick && memcmp(&a, &b, sizeof(AirHockeySim)) == 0;
+    auto maxFrameMs = 0.0;
+    for (const auto& peer : peers)
+    {
+        printf("mallet ticks=%u confirmed=%u rollbacks=%d max_rollback_ticks=%d stalled_frames=%d max_frame_ms=%.3f\n",
+            peer.session.getState().tick, peer.session.getConfirmedTick(), peer.session.getRollbackCount(),
+            peer.maxRollbackTicks, peer.stalledFrames, peer.maxFrameMs);
+        maxFrameMs = peer.maxFrameMs > maxFrameMs ? peer.maxFrameMs : maxFrameMs;
+    }
+    printf("latency_ms=%.0f jitter_ms=%.0f loss=%.2f snapshot_restore_step_us=%.4f score=%d:%d same=%d\n",
+        latencyMs, jitterMs, lossRate, copyUs, a.scores[0], a.scores[1], same ? 1 : 0);
+    return corrected && same && maxFrameMs <= FRAME_BUDGET_MS ? 0 : 1;
+}
@@ -0,0 +1,70 @@
+#include "../Classes/PartySim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// Micro-benchmark of the party mode tick (grid + SIMD narrowphase), without any renderer.
+// usage: MyGame_partybench [pucks=512] [mallets=4] [ticks=5000] [budget ms=1.0] [zone columns=1]
+// Exits with 1 when the average tick is over budget, so a CI job can track it.
+int main(int argc, char **argv)
+{
+    const auto puckCount = argc > 1 ? std::atoi(argv[1]) : 512;
+    const auto malletCount = argc > 2 ? std::atoi(argv[2]) : 4;
+    const auto tickCount = argc > 3 ? std::atoi(argv[3]) : 5000;
+    const auto budgetMs = argc > 4 ? std::atof(argv[4]) : 1.0;
+    const auto zoneColumns = argc > 5 ? std::atoi(argv[5]) : 1;
+
+    PartySim sim;
+    sim.init(640, 960, puckCount, 12, malletCount, 40, zoneColumns);
+
+    // fixed seed, every run simulates the same match
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> speed(-600.0f, 600.0f);
+    for (auto i = 0; i < puckCount; ++i)
+    {
+        sim.puckVx[i] = speed(random);
+        sim.puckVy[i] = speed(random);
+    }
+    std::uniform_real_distribution<float> tapX(0.0f, 640.0f);
+    std::uniform_real_distribution<float> tapY(0.0f, 960.0f);
+
+    std::vector<double> tickMs;
+    tickMs.reserve(tickCount);
+    auto events = 0;
+    for (auto t = 0; t < tickCount; ++t)
+    {
+        if (t % 4 == 0)
+        {
+            for (auto m = 0; m < malletCount; ++m)
+            {
+                sim.moveMallet(m, tapX(random), tapY(random));
+            }
+        }
+        const auto start = std::chrono::steady_clock::now();
+        events |= sim.step();
+        const auto end = std::chrono::steady_clock::now();
+        tickMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+    }
+
+    std::sort(tickMs.begin(), tickMs.end());
+    auto total = 0.0;
+    for (auto ms : tickMs)
+    {
+        total += ms;
+    }
+    const auto average = total / tickCount;
+    const auto p99 = tickMs[static_cast<size_t>(tickCount * 0.99)];
+    printf("pucks=%d mallets=%d ticks=%d avg_ms=%.4f p50_ms=%.4f p99_ms=%.4f max_ms=%.4f score=%d:%d events=0x%x\n",
+        puckCount, malletCount, tickCount, average, tickMs[tickCount / 2], p99, tickMs.back(),
+        sim.scores[0], sim.scores[1], events);
+    if (average > budgetMs)
+    {
+        printf("over budget: %.4f ms > %.4f ms\n", average, budgetMs);
+        return 1;
+    }
+    return 0;
+}
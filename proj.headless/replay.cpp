@@ -0,0 +1,96 @@
+#include "../Classes/CpuPlayer.h"
+#include "../Classes/Replay.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Records a CPU vs CPU match, then seeks the replay at random ticks and checks each seek
+// rebuilds exactly the state the live match had at that tick.
+// usage: MyGame_replay [minutes=10] [seeks=200] [budget ms=5.0] [file=replay_check.ahr]
+// Exits with 1 when a seek is wrong or the slowest seek is over budget.
+int main(int argc, char **argv)
+{
+    const auto minutes = argc > 1 ? std::atoi(argv[1]) : 10;
+    const auto seekCount = argc > 2 ? std::atoi(argv[2]) : 200;
+    const auto budgetMs = argc > 3 ? std::atof(argv[3]) : 5.0;
+    const auto path = argc > 4 ? argv[4] : "replay_check.ahr";
+    const auto tickCount = static_cast<unsigned int>(minutes * 60 * AirHockeySim::TICKS_PER_SECOND);
+
+    AirHockeySim sim;
+    sim.init(640, 960, 40, 12);
+    CpuPlayer bottom;
+    CpuPlayer top;
+    bottom.init(0, 0, 1500.0f);
+    top.init(1, 0, 1500.0f);
+
+    // the live states to compare the seeks against, a frame of 4 ticks like a 30 fps device
+    std::vector<AirHockeySim> live;
+    live.reserve(tickCount);
+    ReplayRecorder recorder;
+    if (!recorder.open(path, 5 * AirHockeySim::TICKS_PER_SECOND))
+    {
+        fprintf(stderr, "can not write %s\n", path);
+        return 1;
+    }
+    const auto recordStart = std::chrono::steady_clock::now();
+    for (unsigned int t = 0; t < tickCount; ++t)
+    {
+        if (t % 4 == 0)
+        {
+            const auto frameSeconds = 4 * AirHockeySim::tickSeconds();
+            auto x = 0.0f;
+            auto y = 0.0f;
+            bottom.think(sim, frameSeconds, x, y);
+            recorder.recordMove(sim.tick, 0, x, y);
+            sim.moveMallet(0, x, y);
+            top.think(sim, frameSeconds, x, y);
+            recorder.recordMove(sim.tick, 1, x, y);
+            sim.moveMallet(1, x, y);
+        }
+        live.push_back(sim);
+        recorder.recordTick(sim);
+        sim.step();
+    }
+    recorder.close();
+    const auto recordEnd = std::chrono::steady_clock::now();
+
+    ReplayPlayer player;
+    if (!player.load(path))
+    {
+        fprintf(stderr, "can not read %s\n", path);
+        return 1;
+    }
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<unsigned int> seekTick(0, tickCount - 1);
+    std::vector<double> seekMs;
+    seekMs.reserve(seekCount);
+    auto mismatches = 0;
+    AirHockeySim seeked;
+    for (auto i = 0; i < seekCount; ++i)
+    {
+        const auto tick = seekTick(random);
+        const auto start = std::chrono::steady_clock::now();
+        const auto found = player.seek(tick, seeked);
+        const auto end = std::chrono::steady_clock::now();
+        seekMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        if (!found || memcmp(&seeked, &live[tick], sizeof(AirHockeySim)) != 0)
+        {
+            ++mismatches;
+        }
+    }
+
+    std::sort(seekMs.begin(), seekMs.end());
+    const auto maxMs = seekMs.empty() ? 0.0 : seekMs.back();
+    printf("ticks=%u last_tick=%u record_ms=%.1f score=%d:%d seeks=%d p50_ms=%.3f max_ms=%.3f mismatches=%d\n",
+        tickCount, player.getLastTick(),
+        std::chrono::duration<double, std::milli>(recordEnd - recordStart).count(),
+        sim.scores[0], sim.scores[1], seekCount,
+        seekMs.empty() ? 0.0 : seekMs[seekMs.size() / 2], maxMs, mismatches);
+    return mismatches == 0 && maxMs <= budgetMs ? 0 : 1;
+}
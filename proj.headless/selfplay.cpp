@@ -0,0 +1,180 @@
+#include "../Classes/AirHockeySim.h"
+#include "WorkStealing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Self-play simulator: plays matches between two scripted mallets with the real game rules,
+// on every core, and reports matches per second and how it scales with the number of threads.
+// usage: MyGame_selfplay [matches=20000] [batch=64] [threads=0, sweep 1..all cores]
+
+// a match ends at this score, or after MAX_MATCH_SECONDS of play
+#define WINNING_SCORE 7
+#define MAX_MATCH_SECONDS 60
+// the scripted players move their mallet this many times per second, like touch moves
+#define BOT_MOVES_PER_SECOND 60
+
+struct MatchResult
+{
+    long long ticks;
+    int wins[AirHockeySim::PLAYER_COUNT];
+    int draws;
+};
+
+static unsigned int nextRandom(unsigned int& seed)
+{
+    // xorshift32, cheap and good enough to vary the matches
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+/**
+ * \brief Scripted player: attack the puck on its own court, otherwise guard the goal
+ */
+static void driveMallet(AirHockeySim& sim, int index, unsigned int& seed)
+{
+    const auto& mallet = sim.mallets[index];
+    const auto& puck = sim.puck;
+    const auto bottom = index == 0;
+    // the centre line, where the puck comes back after a goal, belongs to the bottom court like in whichCourt()
+    const auto ownCourt = bottom ? puck.y <= sim.height * 0.5f : puck.y > sim.height * 0.5f;
+    const auto jitter = static_cast<float>(nextRandom(seed) % 41) - 20.0f;
+    if (ownCourt)
+    {
+        // hit the puck from the side of the own goal, so it goes up the table
+        const auto behind = bottom ? -puck.radius : puck.radius;
+        sim.moveMallet(index, puck.x + jitter, puck.y + behind);
+    }
+    else
+    {
+        const auto guardY = bottom ? mallet.radius * 2.0f : sim.height - mallet.radius * 2.0f;
+        sim.moveMallet(index, puck.x + jitter, guardY);
+    }
+}
+
+/**
+ * \brief Play a batch of matches in lockstep, the states are contiguous so a tick walks memory once
+ */
+static void playBatch(int firstMatch, int matchCount, MatchResult& result)
+{
+    std::vector<AirHockeySim> tables(matchCount);
+    std::vector<unsigned int> seeds(matchCount);
+    std::vector<char> playing(matchCount, 1);
+    for (auto i = 0; i < matchCount; ++i)
+    {
+        tables[i].init(640, 960, 40, 25);
+        seeds[i] = 2654435761u * (firstMatch + i + 1);
+        // kick-off toward a random court
+        tables[i].puck.vy = (nextRandom(seeds[i]) & 1) ? 300.0f : -300.0f;
+        tables[i].puck.vx = static_cast<float>(nextRandom(seeds[i]) % 401) - 200.0f;
+    }
+
+    const auto maxTicks = MAX_MATCH_SECONDS * AirHockeySim::TICKS_PER_SECOND;
+    const auto ticksPerMove = AirHockeySim::TICKS_PER_SECOND / BOT_MOVES_PER_SECOND;
+    auto remaining = matchCount;
+    for (auto tick = 0; tick < maxTicks && remaining > 0; ++tick)
+    {
+        for (auto i = 0; i < matchCount; ++i)
+        {
+            if (!playing[i])
+            {
+                continue;
+            }
+            auto& table = tables[i];
+            if (tick % ticksPerMove == 0)
+            {
+                driveMallet(table, 0, seeds[i]);
+                driveMallet(table, 1, seeds[i]);
+            }
+            if ((table.step() & SIM_EVENT_GOAL) &&
+                (table.scores[0] >= WINNING_SCORE || table.scores[1] >= WINNING_SCORE))
+            {
+                playing[i] = 0;
+                --remaining;
+            }
+        }
+    }
+
+    for (const auto& table : tables)
+    {
+        result.ticks += table.tick;
+        if (table.scores[0] == table.scores[1])
+        {
+            result.draws++;
+        }
+        else
+        {
+            result.wins[table.scores[0] > table.scores[1] ? 0 : 1]++;
+        }
+    }
+}
+
+static double playMatches(int threadCount, int matchCount, int batchSize, MatchResult& total)
+{
+    const auto batchCount = (matchCount + batchSize - 1) / batchSize;
+    std::vector<MatchResult> results(threadCount, MatchResult());
+
+    const auto start = std::chrono::steady_clock::now();
+    workStealingFor(threadCount, batchCount, [&](int batch, int worker)
+    {
+        const auto first = batch * batchSize;
+        playBatch(first, std::min(batchSize, matchCount - first), results[worker]);
+    });
+    const auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    total = MatchResult();
+    for (const auto& result : results)
+    {
+        total.ticks += result.ticks;
+        total.wins[0] += result.wins[0];
+        total.wins[1] += result.wins[1];
+        total.draws += result.draws;
+    }
+    return seconds;
+}
+
+int main(int argc, char **argv)
+{
+    const auto matchCount = argc > 1 ? std::atoi(argv[1]) : 20000;
+    const auto batchSize = std::max(1, argc > 2 ? std::atoi(argv[2]) : 64);
+    const auto requestedThreads = argc > 3 ? std::atoi(argv[3]) : 0;
+    const auto cores = std::max(1u, std::thread::hardware_concurrency());
+
+    // sweep 1, 2, 4 ... cores threads, or only the requested count after the 1 thread baseline
+    std::vector<int> threadCounts(1, 1);
+    if (requestedThreads > 1)
+    {
+        threadCounts.push_back(requestedThreads);
+    }
+    else
+    {
+        for (auto threads = 2; threads < static_cast<int>(cores); threads *= 2)
+        {
+            threadCounts.push_back(threads);
+        }
+        if (cores > 1)
+        {
+            threadCounts.push_back(cores);
+        }
+    }
+
+    printf("matches=%d batch=%d cores=%u\n", matchCount, batchSize, cores);
+    auto baseline = 0.0;
+    for (auto threads : threadCounts)
+    {
+        MatchResult total;
+        const auto seconds = playMatches(threads, matchCount, batchSize, total);
+        const auto matchesPerSecond = matchCount / seconds;
+        baseline = baseline > 0.0 ? baseline : matchesPerSecond;
+        printf("threads=%d seconds=%.3f matches_per_s=%.0f ticks_per_s=%.0f speedup=%.2f efficiency=%.2f wins=%d:%d draws=%d\n",
+            threads, seconds, matchesPerSecond, total.ticks / seconds,
+            matchesPerSecond / baseline, matchesPerSecond / baseline / threads,
+            total.wins[0], total.wins[1], total.draws);
+    }
+    return 0;
+}
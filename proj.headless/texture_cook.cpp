@@ -0,0 +1,425 @@
+#include "../Classes/TextureBundle.h"
+
+#include <png.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Cooks PNG textures into a TextureBundle, so the game uploads them without decoding nor converting.
+// usage: MyGame_texturecook [-f etc1|rgba8888|rgba4444|rgb565] <out bundle> <texture.png>...
+// Each texture is stored as a PVR v3 file named after its PNG.
+// etc1 (default): 4 bits per pixel, decoded by the GPU, or by Image where the GPU has no ETC1. ETC1 has no
+// alpha, a texture with transparent pixels gets a second ETC1 texture "<name>@alpha" holding its alpha in
+// red, drawn with the ETC1AS shaders. The colour is not premultiplied, the shader does it.
+// rgba8888, rgba4444, rgb565: uncompressed, premultiplied here and flagged so in the PVR header.
+// S3TC and PVRTC are not cooked: only desktop GPUs decode the first, and PVRTC needs the PowerVR encoder.
+
+// the ETC1 suffix of TextureCache
+#define ALPHA_SUFFIX "@alpha"
+
+// PVR v3, see Image::initWithPVRv3Data()
+#define PVR3_VERSION 0x03525650
+#define PVR3_FLAG_PREMULTIPLIED 0x02
+#define PVR3_FORMAT_ETC1 6ULL
+#define PVR3_FORMAT_RGBA8888 0x0808080861626772ULL
+#define PVR3_FORMAT_RGBA4444 0x0404040461626772ULL
+#define PVR3_FORMAT_RGB565 0x0005060500626772ULL
+
+#pragma pack(push, 1)
+struct PVR3Header
+{
+    uint32_t version;
+    uint32_t flags;
+    uint64_t pixelFormat;
+    uint32_t colorSpace;
+    uint32_t channelType;
+    uint32_t height;
+    uint32_t width;
+    uint32_t depth;
+    uint32_t numberOfSurfaces;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmaps;
+    uint32_t metadataLength;
+};
+#pragma pack(pop)
+
+enum class Format
+{
+    ETC1,
+    RGBA8888,
+    RGBA4444,
+    RGB565
+};
+
+struct Texture
+{
+    int width;
+    int height;
+    // RGBA, not premultiplied
+    std::vector<png_byte> pixels;
+};
+
+// the intensity modifiers of ETC1, for pixel indices 0 to 3 (msb, lsb)
+static const int ETC1_MODIFIERS[8][4] = {
+    { 2, 8, -2, -8 },
+    { 5, 17, -5, -17 },
+    { 9, 29, -9, -29 },
+    { 13, 42, -13, -42 },
+    { 18, 60, -18, -60 },
+    { 24, 80, -24, -80 },
+    { 33, 106, -33, -106 },
+    { 47, 183, -47, -183 },
+};
+
+struct SubBlock
+{
+    // the 8 pixels as x * 4 + y, the order of the index bits
+    int pixels[8];
+    int table;
+    int indices[8];
+    int error;
+};
+
+static int clamp255(int value)
+{
+    return std::min(std::max(value, 0), 255);
+}
+
+// the table and pixel indices closest to the block for a base colour, returns the squared error
+static int fitSubBlock(const int block[16][3], const int base[3], SubBlock& sub)
+{
+    sub.error = -1;
+    for (auto table = 0; table < 8; ++table)
+    {
+        auto error = 0;
+        int indices[8];
+        for (auto i = 0; i < 8; ++i)
+        {
+            const auto pixel = block[sub.pixels[i]];
+            auto best = -1;
+            for (auto index = 0; index < 4; ++index)
+            {
+                auto distance = 0;
+                for (auto c = 0; c < 3; ++c)
+                {
+                    const auto d = clamp255(base[c] + ETC1_MODIFIERS[table][index]) - pixel[c];
+                    distance += d * d;
+                }
+                if (best < 0 || distance < best)
+                {
+                    best = distance;
+                    indices[i] = index;
+                }
+            }
+            error += best;
+        }
+        if (sub.error < 0 || error < sub.error)
+        {
+            sub.error = error;
+            sub.table = table;
+            std::copy(indices, indices + 8, sub.indices);
+        }
+    }
+    return sub.error;
+}
+
+// an ETC1 block from 4x4 RGB pixels, given as x * 4 + y: the average of each half as base colour, both
+// splits and both colour modes are tried
+static uint64_t encodeEtc1Block(const int block[16][3])
+{
+    uint64_t best = 0;
+    auto bestError = -1;
+    for (auto flip = 0; flip < 2; ++flip)
+    {
+        SubBlock subs[2];
+        int average[2][3] = {};
+        for (auto half = 0; half < 2; ++half)
+        {
+            auto n = 0;
+            for (auto x = 0; x < 4; ++x)
+            {
+                for (auto y = 0; y < 4; ++y)
+                {
+                    // flipped, the halves are the top and bottom rows, else the left and right columns
+                    if ((flip ? y / 2 : x / 2) == half)
+                    {
+                        subs[half].pixels[n++] = x * 4 + y;
+                        for (auto c = 0; c < 3; ++c)
+                        {
+                            average[half][c] += block[x * 4 + y][c];
+                        }
+                    }
+                }
+            }
+        }
+
+        for (auto differential = 0; differential < 2; ++differential)
+        {
+            int quantized[2][3];
+            int base[2][3];
+            const auto levels = differential ? 31 : 15;
+            for (auto half = 0; half < 2; ++half)
+            {
+                for (auto c = 0; c < 3; ++c)
+                {
+                    quantized[half][c] = (average[half][c] * levels + 8 * 255 / 2) / (8 * 255);
+                }
+            }
+            if (differential)
+            {
+                // the second colour is stored as a 3 bit difference to the first
+                for (auto c = 0; c < 3; ++c)
+                {
+                    quantized[1][c] = std::min(std::max(quantized[1][c], quantized[0][c] - 4), quantized[0][c] + 3);
+                }
+            }
+            for (auto half = 0; half < 2; ++half)
+            {
+                for (auto c = 0; c < 3; ++c)
+                {
+                    const auto q = quantized[half][c];
+                    base[half][c] = differential ? (q << 3) | (q >> 2) : (q << 4) | q;
+                }
+            }
+            const auto error = fitSubBlock(block, base[0], subs[0]) + fitSubBlock(block, base[1], subs[1]);
+            if (bestError >= 0 && error >= bestError)
+            {
+                continue;
+            }
+            bestError = error;
+
+            uint64_t bits = 0;
+            for (auto c = 0; c < 3; ++c)
+            {
+                const auto shift = 59 - c * 8;
+                if (differential)
+                {
+                    bits |= static_cast<uint64_t>(quantized[0][c]) << shift;
+                    bits |= static_cast<uint64_t>((quantized[1][c] - quantized[0][c]) & 7) << (shift - 3);
+                }
+                else
+                {
+                    bits |= static_cast<uint64_t>(quantized[0][c]) << (shift + 1);
+                    bits |= static_cast<uint64_t>(quantized[1][c]) << (shift - 3);
+                }
+            }
+            bits |= static_cast<uint64_t>(subs[0].table) << 37;
+            bits |= static_cast<uint64_t>(subs[1].table) << 34;
+            bits |= static_cast<uint64_t>(differential) << 33;
+            bits |= static_cast<uint64_t>(flip) << 32;
+            for (auto half = 0; half < 2; ++half)
+            {
+                for (auto i = 0; i < 8; ++i)
+                {
+                    const auto pixel = subs[half].pixels[i];
+                    const auto index = subs[half].indices[i];
+                    bits |= static_cast<uint64_t>(index >> 1) << (16 + pixel);
+                    bits |= static_cast<uint64_t>(index & 1) << pixel;
+                }
+            }
+            best = bits;
+        }
+    }
+    return best;
+}
+
+// channel 0 to 2 as the colour, or channel 3 (alpha) in the three of them
+static std::vector<unsigned char> encodeEtc1(const Texture& texture, bool alpha)
+{
+    const auto blocksWide = (texture.width + 3) / 4;
+    const auto blocksHigh = (texture.height + 3) / 4;
+    std::vector<unsigned char> data;
+    data.reserve(static_cast<size_t>(blocksWide) * blocksHigh * 8);
+    for (auto by = 0; by < blocksHigh; ++by)
+    {
+        for (auto bx = 0; bx < blocksWide; ++bx)
+        {
+            int block[16][3];
+            for (auto x = 0; x < 4; ++x)
+            {
+                for (auto y = 0; y < 4; ++y)
+                {
+                    // blocks over the edge repeat the last pixels
+                    const auto px = std::min(bx * 4 + x, texture.width - 1);
+                    const auto py = std::min(by * 4 + y, texture.height - 1);
+                    const auto pixel = &texture.pixels[(static_cast<size_t>(py) * texture.width + px) * 4];
+                    for (auto c = 0; c < 3; ++c)
+                    {
+                        block[x * 4 + y][c] = alpha ? pixel[3] : pixel[c];
+                    }
+                }
+            }
+            const auto bits = encodeEtc1Block(block);
+            for (auto i = 7; i >= 0; --i)
+            {
+                data.push_back(static_cast<unsigned char>(bits >> (i * 8)));
+            }
+        }
+    }
+    return data;
+}
+
+static std::vector<unsigned char> encodeUncompressed(const Texture& texture, Format format)
+{
+    std::vector<unsigned char> data;
+    const auto count = static_cast<size_t>(texture.width) * texture.height;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto pixel = &texture.pixels[i * 4];
+        const auto a = pixel[3];
+        const auto r = (pixel[0] * a + 127) / 255;
+        const auto g = (pixel[1] * a + 127) / 255;
+        const auto b = (pixel[2] * a + 127) / 255;
+        uint16_t packed = 0;
+        switch (format)
+        {
+        case Format::RGBA8888:
+            data.push_back(static_cast<unsigned char>(r));
+            data.push_back(static_cast<unsigned char>(g));
+            data.push_back(static_cast<unsigned char>(b));
+            data.push_back(a);
+            continue;
+        case Format::RGBA4444:
+            packed = static_cast<uint16_t>((r >> 4) << 12 | (g >> 4) << 8 | (b >> 4) << 4 | a >> 4);
+            break;
+        default:
+            packed = static_cast<uint16_t>((r >> 3) << 11 | (g >> 2) << 5 | b >> 3);
+            break;
+        }
+        // little endian shorts, as GL reads them
+        data.push_back(static_cast<unsigned char>(packed));
+        data.push_back(static_cast<unsigned char>(packed >> 8));
+    }
+    return data;
+}
+
+static std::vector<unsigned char> makePvr(const Texture& texture, uint64_t pixelFormat, uint32_t flags, const std::vector<unsigned char>& data)
+{
+    PVR3Header header;
+    memset(&header, 0, sizeof(header));
+    header.version = PVR3_VERSION;
+    header.flags = flags;
+    header.pixelFormat = pixelFormat;
+    header.height = texture.height;
+    header.width = texture.width;
+    header.depth = 1;
+    header.numberOfSurfaces = 1;
+    header.numberOfFaces = 1;
+    header.numberOfMipmaps = 1;
+    std::vector<unsigned char> pvr(sizeof(header) + data.size());
+    memcpy(pvr.data(), &header, sizeof(header));
+    std::copy(data.begin(), data.end(), pvr.begin() + sizeof(header));
+    return pvr;
+}
+
+int main(int argc, char **argv)
+{
+    auto format = Format::ETC1;
+    auto arg = 1;
+    if (argc > 2 && strcmp(argv[1], "-f") == 0)
+    {
+        const std::string name = argv[2];
+        if (name == "etc1")
+        {
+            format = Format::ETC1;
+        }
+        else if (name == "rgba8888")
+        {
+            format = Format::RGBA8888;
+        }
+        else if (name == "rgba4444")
+        {
+            format = Format::RGBA4444;
+        }
+        else if (name == "rgb565")
+        {
+            format = Format::RGB565;
+        }
+        else
+        {
+            fprintf(stderr, "unknown format %s\n", argv[2]);
+            return 1;
+        }
+        arg = 3;
+    }
+    if (argc < arg + 2)
+    {
+        fprintf(stderr, "usage: %s [-f etc1|rgba8888|rgba4444|rgb565] <out bundle> <texture.png>...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<std::pair<std::string, std::vector<unsigned char>>> textures;
+    size_t pngSize = 0;
+    for (auto i = arg + 1; i < argc; ++i)
+    {
+        const std::string path = argv[i];
+        const auto name = path.substr(path.find_last_of("/\\") + 1);
+        png_image image = png_image();
+        image.version = PNG_IMAGE_VERSION;
+        if (!png_image_begin_read_from_file(&image, path.c_str()))
+        {
+            fprintf(stderr, "can not read %s: %s\n", path.c_str(), image.message);
+            return 1;
+        }
+        image.format = PNG_FORMAT_RGBA;
+        Texture texture;
+        texture.width = image.width;
+        texture.height = image.height;
+        texture.pixels.resize(PNG_IMAGE_SIZE(image));
+        if (!png_image_finish_read(&image, nullptr, texture.pixels.data(), 0, nullptr))
+        {
+            fprintf(stderr, "can not decode %s: %s\n", path.c_str(), image.message);
+            return 1;
+        }
+        auto file = fopen(path.c_str(), "rb");
+        if (file)
+        {
+            fseek(file, 0, SEEK_END);
+            pngSize += ftell(file);
+            fclose(file);
+        }
+
+        switch (format)
+        {
+        case Format::ETC1:
+        {
+            textures.emplace_back(name, makePvr(texture, PVR3_FORMAT_ETC1, 0, encodeEtc1(texture, false)));
+            auto opaque = true;
+            for (size_t p = 3; p < texture.pixels.size() && opaque; p += 4)
+            {
+                opaque = texture.pixels[p] == 255;
+            }
+            if (!opaque)
+            {
+                textures.emplace_back(name + ALPHA_SUFFIX, makePvr(texture, PVR3_FORMAT_ETC1, 0, encodeEtc1(texture, true)));
+            }
+            break;
+        }
+        case Format::RGBA8888:
+            textures.emplace_back(name, makePvr(texture, PVR3_FORMAT_RGBA8888, PVR3_FLAG_PREMULTIPLIED, encodeUncompressed(texture, format)));
+            break;
+        case Format::RGBA4444:
+            textures.emplace_back(name, makePvr(texture, PVR3_FORMAT_RGBA4444, PVR3_FLAG_PREMULTIPLIED, encodeUncompressed(texture, format)));
+            break;
+        case Format::RGB565:
+            textures.emplace_back(name, makePvr(texture, PVR3_FORMAT_RGB565, PVR3_FLAG_PREMULTIPLIED, encodeUncompressed(texture, format)));
+            break;
+        }
+    }
+
+    if (!TextureBundle::write(argv[arg], textures))
+    {
+        fprintf(stderr, "can not write %s\n", argv[arg]);
+        return 1;
+    }
+    size_t size = 0;
+    for (const auto& texture : textures)
+    {
+        size += texture.second.size();
+    }
+    fprintf(stderr, "%d textures, %.1f KB of PNG cooked to %.1f KB\n", static_cast<int>(textures.size()), pngSize / 1024.0, size / 1024.0);
+    return 0;
+}
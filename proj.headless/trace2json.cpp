@@ -0,0 +1,70 @@
+#include "../Classes/AirHockeySim.h"
+#include "../Classes/EventTrace.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+// Converts a gameplay event trace (last_match.aht in the writable path of the game) to the Chrome trace
+// JSON format, to open in chrome://tracing or https://ui.perfetto.dev.
+// usage: MyGame_trace2json <trace.aht> [out.json, default stdout]
+// Goals become instant events over the whole process, hits and bounces instant events of their thread
+// (one per mallet, and one for the walls), and the puck speed a counter.
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <trace.aht> [out.json]\n", argv[0]);
+        return 1;
+    }
+    auto in = fopen(argv[1], "rb");
+    if (!in)
+    {
+        fprintf(stderr, "can not read %s\n", argv[1]);
+        return 1;
+    }
+    char magic[4];
+    uint32_t header[2];
+    if (fread(magic, 1, 4, in) != 4 || memcmp(magic, "AHTR", 4) != 0
+        || fread(header, sizeof(header), 1, in) != 1 || header[0] != 1 || header[1] != sizeof(TraceEvent))
+    {
+        fprintf(stderr, "%s is not a trace of this version\n", argv[1]);
+        fclose(in);
+        return 1;
+    }
+    auto out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    if (!out)
+    {
+        fprintf(stderr, "can not write %s\n", argv[2]);
+        fclose(in);
+        return 1;
+    }
+
+    fprintf(out, "{\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"player 1\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"player 2\"}},\n");
+    fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"walls\"}}");
+    TraceEvent event;
+    auto count = 0;
+    while (fread(&event, sizeof(event), 1, in) == 1)
+    {
+        const auto speed = std::sqrt(event.vx * event.vx + event.vy * event.vy);
+        const auto tid = event.mallet >= 0 ? event.mallet + 1 : 3;
+        const auto scope = (event.type & SIM_EVENT_GOAL) ? "p" : "t";
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"gameplay\",\"ph\":\"i\",\"s\":\"%s\",\"ts\":%llu,\"pid\":1,\"tid\":%d,"
+            "\"args\":{\"tick\":%u,\"x\":%.1f,\"y\":%.1f,\"vx\":%.1f,\"vy\":%.1f,\"impulse\":%.1f}}",
+            EventTrace::getEventName(event.type), scope, static_cast<unsigned long long>(event.timeUs), tid,
+            event.tick, event.x, event.y, event.vx, event.vy, event.impulse);
+        fprintf(out, ",\n{\"name\":\"puck speed\",\"ph\":\"C\",\"ts\":%llu,\"pid\":1,\"args\":{\"speed\":%.1f}}",
+            static_cast<unsigned long long>(event.timeUs), speed);
+        ++count;
+    }
+    fprintf(out, "\n],\"displayTimeUnit\":\"ms\"}\n");
+    fclose(in);
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+    fprintf(stderr, "%d events\n", count);
+    return 0;
+}